@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+
+#include <book_policy.hpp>
+#include <utils/object_pool.hpp>
+#include <vector>
+
+#include "order_flow.hpp"
+
+// One side of a book on its own, as the matcher drives it.
+template <typename Policy>
+struct SideFixture {
+    using SideType = typename Policy::SideType;
+
+    utils::ObjectPool<PriceLevelNode> nodes;
+    SideType                          side;
+    std::vector<Order>                orders;
+
+    // `levels` occupied prices around 10000, `perLevel` orders each
+    SideFixture(size_t levels, size_t perLevel)
+        : side(Policy::makeSide(BookSpec{BookType::AVL, 1, 1 << 16}, nodes)) {
+        orders.reserve(levels * perLevel + 1);
+        for (size_t i = 0; i < levels * perLevel; ++i) {
+            Price price = 10000 - static_cast<Price>(levels / 2) + static_cast<Price>(i % levels);
+            orders.emplace_back(i + 1, "C1", price, 10, Side::Buy, OrderType::Limit);
+        }
+        for (auto &order : orders) side.insert(order);
+    }
+
+    ~SideFixture() {
+        side.clear([](Order *) {});
+    }
+};
+
+// A new order lands at a random price near the touch and leaves again: the
+// level is created and destroyed about half the time.
+template <typename Policy>
+static void BM_SideInsertRemove(benchmark::State &state) {
+    SideFixture<Policy> f(state.range(0), 1);
+    OrderFlow           flow;
+    Order               order(0, "C1", 0, 10, Side::Buy, OrderType::Limit);
+    Price               low = 10000 - state.range(0);
+
+    for (auto _ : state) {
+        order.price = low + static_cast<Price>(flow.pick(state.range(0) * 2));
+        benchmark::DoNotOptimize(f.side.insert(order));
+        benchmark::DoNotOptimize(f.side.remove(order));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Policy>
+static void BM_SideFind(benchmark::State &state) {
+    SideFixture<Policy> f(state.range(0), 1);
+    OrderFlow           flow;
+    Price               low = 10000 - state.range(0);
+
+    for (auto _ : state) {
+        Price price = low + static_cast<Price>(flow.pick(state.range(0) * 2));
+        benchmark::DoNotOptimize(f.side.find(price));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Walks from the best price inwards, as a sweep does.
+template <typename Policy>
+static void BM_SideWalkLevels(benchmark::State &state) {
+    SideFixture<Policy> f(state.range(0), 1);
+
+    for (auto _ : state) {
+        uint64_t total = 0;
+        for (auto &level : f.side.descending()) total += level.quantity();
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BM_SideInsertRemove, AVLBook)->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_SideInsertRemove, LadderBook)->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_SideFind, AVLBook)->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_SideFind, LadderBook)->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_SideWalkLevels, AVLBook)->Arg(256)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_SideWalkLevels, LadderBook)->Arg(256)->Arg(4096);
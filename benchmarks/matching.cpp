@@ -0,0 +1,108 @@
+#include <benchmark/benchmark.h>
+
+#include <deque>
+#include <instrument.hpp>
+#include <vector>
+
+#include "order_flow.hpp"
+
+// Each benchmark runs once per book layout: Arg 0 is the BookType.
+static BookType bookOf(const benchmark::State &state) {
+    return state.range(0) == 0 ? BookType::AVL : BookType::Ladder;
+}
+
+static void books(benchmark::internal::Benchmark *b) {
+    b->ArgNames({"ladder"})->Arg(0)->Arg(1);
+}
+
+struct Resting {
+    OrderId     id;
+    std::string clientId;
+};
+
+// Places `req` and remembers the order if it rested.
+static void place(Instrument &instrument, const OrderRequest &req, std::deque<Resting> *resting) {
+    Order  *order = instrument.createOrder(req);
+    OrderId id    = order->getId();
+    if (instrument.placeOrder(*order) == Placement::Rested && resting)
+        resting->push_back(Resting{id, req.clientId});
+}
+
+// Orders that only ever rest; the oldest are cancelled to hold the book at
+// about 10k orders, so this is the add / cancel path without matching.
+static void BM_PassiveFlow(benchmark::State &state) {
+    auto                instrument = makeInstrument(benchSpec(bookOf(state)));
+    OrderFlow           flow;
+    std::deque<Resting> resting;
+
+    for (auto _ : state) {
+        place(*instrument, flow.passive(), &resting);
+        if (resting.size() > 10000) {
+            instrument->cancelOrder(resting.front().id, resting.front().clientId);
+            resting.pop_front();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PassiveFlow)->Apply(books);
+
+// A realistic mix: a third of the orders cross and trade against the touch.
+static void BM_CrossingFlow(benchmark::State &state) {
+    auto      instrument = makeInstrument(benchSpec(bookOf(state)));
+    OrderFlow flow;
+    for (int i = 0; i < 10000; ++i) place(*instrument, flow.passive(), nullptr);
+
+    for (auto _ : state) place(*instrument, flow.next(0.33), nullptr);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CrossingFlow)->Apply(books);
+
+// One market order takes out Arg 1 ask levels of four orders each.
+static void BM_DeepSweep(benchmark::State &state) {
+    auto       instrument = makeInstrument(benchSpec(bookOf(state)));
+    const auto levels     = static_cast<Price>(state.range(1));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (Price p = 0; p < levels; ++p)
+            for (int k = 0; k < 4; ++k)
+                place(*instrument,
+                      OrderRequest{"M", "BENCH", Side::Sell, OrderType::Limit, 10000 + p, 10},
+                      nullptr);
+        state.ResumeTiming();
+
+        place(*instrument,
+              OrderRequest{"T",
+                           "BENCH",
+                           Side::Buy,
+                           OrderType::Market,
+                           0,
+                           static_cast<int>(levels * 4 * 10),
+                           TimeInForce::IOC},
+              nullptr);
+    }
+    state.SetItemsProcessed(state.iterations() * levels * 4);
+}
+BENCHMARK(BM_DeepSweep)->ArgNames({"ladder", "levels"})->ArgsProduct({{0, 1}, {10, 100, 1000}});
+
+// Cancels every order of a 10k order book in random order.
+static void BM_CancelStorm(benchmark::State &state) {
+    constexpr size_t ORDERS = 10000;
+
+    auto      instrument = makeInstrument(benchSpec(bookOf(state)));
+    OrderFlow flow;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::deque<Resting> resting;
+        while (resting.size() < ORDERS) place(*instrument, flow.passive(), &resting);
+        for (size_t i = resting.size(); i > 1; --i)
+            std::swap(resting[i - 1], resting[flow.pick(i)]);
+        state.ResumeTiming();
+
+        for (auto &order : resting)
+            benchmark::DoNotOptimize(instrument->cancelOrder(order.id, order.clientId));
+    }
+    state.SetItemsProcessed(state.iterations() * ORDERS);
+}
+BENCHMARK(BM_CancelStorm)->Apply(books);
@@ -0,0 +1,76 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include <instrument.hpp>
+
+/**
+ * @brief Synthetic order flow shaped like a busy book.
+ *        The mid price random-walks; passive orders rest a geometric number
+ *        of ticks behind it (most near the touch, a long tail deeper), and
+ *        aggressive orders cross it by a few ticks. Sizes are heavy-tailed.
+ *        Seeded, so every run of a benchmark sees the same flow.
+ */
+class OrderFlow {
+   public:
+    explicit OrderFlow(uint64_t seed = 42, Price mid = 10000, double depth = 0.15)
+        : rng(seed), mid(mid), distance(depth) {}
+
+    Price midPrice() const { return mid; }
+
+    // Rests without trading: bids below the mid, asks above it.
+    OrderRequest passive() {
+        step();
+        Side  side  = coin(rng) ? Side::Buy : Side::Sell;
+        Price away  = 1 + distance(rng);
+        Price price = side == Side::Buy ? mid - away : mid + away;
+        return request(side, std::max<Price>(price, 1));
+    }
+
+    // Crosses the mid by up to a few ticks, so it trades against what rests there.
+    OrderRequest aggressive() {
+        step();
+        Side  side  = coin(rng) ? Side::Buy : Side::Sell;
+        Price cross = ticks(rng) % 4;
+        return request(side, side == Side::Buy ? mid + cross : std::max<Price>(mid - cross, 1));
+    }
+
+    // A mix with `crossing` of the orders aggressive.
+    OrderRequest next(double crossing) {
+        return uniform(rng) < crossing ? aggressive() : passive();
+    }
+
+    // Uniform pick in [0, n), e.g. which resting order to cancel.
+    size_t pick(size_t n) { return static_cast<size_t>(ticks(rng) % n); }
+
+   private:
+    void step() {
+        // drifts one tick about every tenth order
+        if (uniform(rng) < 0.1)
+            mid += coin(rng) ? 1 : -1;
+    }
+
+    OrderRequest request(Side side, Price price) {
+        // Pareto-ish: mostly round lots, now and then a block
+        int qty = static_cast<int>(std::min(1000.0, 1 + 10 / std::pow(1 - uniform(rng), 0.7)));
+        return OrderRequest{clients[ticks(rng) % 4], "BENCH", side, OrderType::Limit, price, qty};
+    }
+
+    std::mt19937_64                        rng;
+    Price                                  mid;
+    std::geometric_distribution<Price>     distance;
+    std::bernoulli_distribution            coin{0.5};
+    std::uniform_real_distribution<double> uniform{0.0, 1.0};
+    std::uniform_int_distribution<int64_t> ticks{0, INT32_MAX};
+
+    const std::string clients[4] = {"C1", "C2", "C3", "C4"};
+};
+
+// Books for the benchmarks; ladders span every price the flow can reach.
+inline InstrumentSpec benchSpec(BookType type) {
+    return InstrumentSpec{
+            .symbol = "BENCH", .tick = TickSize{2, 1}, .book = BookSpec{type, 1, 1 << 16}};
+}
@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+
+#include <command.hpp>
+#include <cstring>
+#include <price.hpp>
+#include <string>
+#include <wire.hpp>
+
+#include "order_flow.hpp"
+
+// A read buffer's worth of NEWL requests, as a client would pipeline them.
+static std::string textBuffer(size_t lines) {
+    OrderFlow   flow;
+    std::string buf;
+    for (size_t i = 0; i < lines; ++i) {
+        OrderRequest req = flow.passive();
+        buf += std::string("newl ") + (req.side == Side::Buy ? "buy" : "sell") + " tsla " +
+               std::to_string(req.quantity) + " " + formatPrice(req.price, TickSize{2, 1}) +
+               (i % 3 ? "\n" : " ioc\n");
+    }
+    return buf;
+}
+
+// What Server::process_session_messages does with a text buffer before
+// dispatch: split on newlines, tokenise in place, parse the NEWL fields.
+static void BM_TextParse(benchmark::State &state) {
+    const std::string input = textBuffer(1024);
+    const TickSize    tick{2, 1};
+    std::string       buf;
+
+    for (auto _ : state) {
+        buf = input;  // tokenising upper-cases in place
+        size_t parsed = 0;
+        for (size_t pos = 0; pos < buf.size();) {
+            auto  *nl  = static_cast<char *>(std::memchr(buf.data() + pos, '\n', buf.size() - pos));
+            size_t end = nl - buf.data();
+            CommandLine line(buf.data() + pos, end - pos);
+            pos = end + 1;
+
+            Side        side;
+            int         qty;
+            Price       price;
+            TimeInForce tif = TimeInForce::GTC;
+            if (line.verb() == Command::NewL && parseSide(line[1], side) &&
+                parseQuantity(line[3], qty) && parsePrice(line[4], tick, price) &&
+                (line.size() < 6 || parseTimeInForce(line[5], tif)))
+                ++parsed;
+        }
+        benchmark::DoNotOptimize(parsed);
+    }
+    state.SetItemsProcessed(state.iterations() * 1024);
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_TextParse);
+
+// The same requests as binary NewOrder frames: one length check and a memcpy each.
+static void BM_BinaryDecode(benchmark::State &state) {
+    OrderFlow   flow;
+    std::string buf;
+    for (int i = 0; i < 1024; ++i) {
+        OrderRequest   req = flow.passive();
+        wire::NewOrder m{};
+        wire::setSymbol(m.symbol, "TSLA");
+        m.side     = req.side == Side::Buy ? 0 : 1;
+        m.quantity = static_cast<uint32_t>(req.quantity);
+        m.price    = req.price;
+        wire::append(buf, m, wire::MsgType::NewOrder);
+    }
+
+    for (auto _ : state) {
+        uint64_t total = 0;
+        for (size_t pos = 0; pos + sizeof(wire::Header) <= buf.size();) {
+            wire::Header hdr;
+            std::memcpy(&hdr, buf.data() + pos, sizeof(hdr));
+            if (hdr.type == wire::MsgType::NewOrder) {
+                wire::NewOrder m;
+                std::memcpy(&m, buf.data() + pos, sizeof(m));
+                total += m.quantity;
+            }
+            pos += hdr.length;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * 1024);
+    state.SetBytesProcessed(state.iterations() * buf.size());
+}
+BENCHMARK(BM_BinaryDecode);
@@ -1,21 +1,51 @@
 #pragma once
 #include <algorithm>
 #include <cmath>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <queue>
+#include <string>
+#include <vector>
+
+#include "price.hpp"
+#include "utils/object_pool.hpp"
+
+/**
+ * @brief AVL tree over price level nodes.
+ *        Nodes carry parent pointers and are threaded in price order through
+ *        prev/next, so neighbouring levels are reachable in O(1) and a node that
+ *        is already known can be unlinked without searching for it again.
+ *        Node identity is stable: removal relinks nodes instead of copying data.
+ */
 template <typename NodeType>
 class AVLTree {
    public:
-    void      inorder(NodeType* root, std::function<void(NodeType*)> func, size_t limit);
-    NodeType* insert(NodeType* root, uint64_t price, NodeType*& out);
-    NodeType* remove(NodeType* root, uint64_t price);
+    // Node storage; nodes live on the global heap when no pool is attached.
+    utils::ObjectPool<NodeType>* pool = nullptr;
+
+    // Visits up to `limit` nodes in ascending order over the threads, without recursion.
+    template <typename Func>
+    void inorder(NodeType* root, Func&& func, size_t limit) const;
+
+    NodeType* insert(NodeType* root, Price price, NodeType*& out);
+    NodeType* remove(NodeType* root, Price price);
+    NodeType* removeNode(NodeType* root, NodeType* node);
     void      freeTree(NodeType* root);
 
+    // Builds a balanced tree over `n` fresh nodes sorted by price and threads
+    // them in that order: O(n), no rotations. Returns the root.
+    NodeType* build(NodeType* const* sorted, size_t n);
+
+    NodeType* createNode(Price price);
+    void      destroyNode(NodeType* node);
+
     void printTree(NodeType* root);
 
     NodeType* findMin(NodeType* node);
     NodeType* findMax(NodeType* node);
+    NodeType* predecessor(NodeType* node);
+    NodeType* successor(NodeType* node);
 
     //    private:
     int height(NodeType* node);
@@ -25,6 +55,11 @@ class AVLTree {
     NodeType* rotateRight(NodeType* node);
     NodeType* balance(NodeType* node);
     void      updateHeight(NodeType* node);
+
+    NodeType* insertAt(NodeType* root, Price price, NodeType*& out, bool& created);
+    NodeType* buildRange(NodeType* const* sorted, size_t n, NodeType* parent);
+    void      linkNeighbours(NodeType* node);
+    void      replaceChild(NodeType*& root, NodeType* parent, NodeType* oldChild, NodeType* newChild);
 };
 
 template <typename NodeType>
@@ -45,6 +80,11 @@ NodeType* AVLTree<NodeType>::rotateLeft(NodeType* node) {
     newRoot->left = node;
     node->right   = movedSubtree;
 
+    newRoot->parent = node->parent;
+    node->parent    = newRoot;
+    if (movedSubtree)
+        movedSubtree->parent = node;
+
     updateHeight(node);
     updateHeight(newRoot);
 
@@ -59,6 +99,11 @@ NodeType* AVLTree<NodeType>::rotateRight(NodeType* node) {
     newRoot->right = node;
     node->left     = movedSubtree;
 
+    newRoot->parent = node->parent;
+    node->parent    = newRoot;
+    if (movedSubtree)
+        movedSubtree->parent = node;
+
     updateHeight(node);
     updateHeight(newRoot);
 
@@ -91,34 +136,81 @@ void AVLTree<NodeType>::updateHeight(NodeType* node) {
 }
 
 template <typename NodeType>
-void AVLTree<NodeType>::inorder(NodeType* root, std::function<void(NodeType*)> func, size_t limit) {
-    size_t count = 0;
+template <typename Func>
+void AVLTree<NodeType>::inorder(NodeType* root, Func&& func, size_t limit) const {
+    NodeType* node = root;
+    while (node && node->left) node = node->left;
+
+    for (size_t count = 0; node && count < limit; ++count) {
+        NodeType* next = node->next;  // `func` may release the node
+        func(node);
+        node = next;
+    }
+}
 
-    std::function<void(NodeType*)> recurse = [&](NodeType* node) {
-        if (!node || count >= limit)
-            return;
-        recurse(node->left);
-        if (count < limit) {
-            func(node);
-            ++count;
-        }
-        recurse(node->right);
-    };
+template <typename NodeType>
+NodeType* AVLTree<NodeType>::createNode(Price price) {
+    return pool ? pool->create(price) : new NodeType(price);
+}
 
-    recurse(root);
+template <typename NodeType>
+void AVLTree<NodeType>::destroyNode(NodeType* node) {
+    if (pool)
+        pool->destroy(node);
+    else
+        delete node;
+}
+
+template <typename NodeType>
+NodeType* AVLTree<NodeType>::build(NodeType* const* sorted, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        sorted[i]->prev = i > 0 ? sorted[i - 1] : nullptr;
+        sorted[i]->next = i + 1 < n ? sorted[i + 1] : nullptr;
+    }
+    return buildRange(sorted, n, nullptr);
+}
+
+// The middle node becomes the root of each range, so the halves differ by at
+// most one node and every subtree is balanced as built.
+template <typename NodeType>
+NodeType* AVLTree<NodeType>::buildRange(NodeType* const* sorted, size_t n, NodeType* parent) {
+    if (n == 0)
+        return nullptr;
+    size_t    mid  = n / 2;
+    NodeType* node = sorted[mid];
+    node->parent   = parent;
+    node->left     = buildRange(sorted, mid, node);
+    node->right    = buildRange(sorted + mid + 1, n - mid - 1, node);
+    updateHeight(node);
+    return node;
+}
+
+template <typename NodeType>
+NodeType* AVLTree<NodeType>::insert(NodeType* root, Price price, NodeType*& out) {
+    bool created = false;
+    root         = insertAt(root, price, out, created);
+    if (created)
+        linkNeighbours(out);
+    return root;
 }
 
 template <typename NodeType>
-NodeType* AVLTree<NodeType>::insert(NodeType* root, uint64_t price, NodeType*& out) {
+NodeType* AVLTree<NodeType>::insertAt(NodeType* root,
+                                      Price     price,
+                                      NodeType*& out,
+                                      bool&      created) {
     if (!root) {
-        out = new NodeType(price);
+        out     = createNode(price);
+        created = true;
         return out;
     }
 
     if (price < root->price) {
-        root->left = insert(root->left, price, out);
+        root->left         = insertAt(root->left, price, out, created);
+        root->left->parent = root;
     } else if (price > root->price) {
-        root->right = insert(root->right, price, out);
+        root->right         = insertAt(root->right, price, out, created);
+        root->right->parent = root;
     } else {
         out = root;
         return root;
@@ -128,35 +220,78 @@ NodeType* AVLTree<NodeType>::insert(NodeType* root, uint64_t price, NodeType*& o
 }
 
 template <typename NodeType>
-NodeType* AVLTree<NodeType>::remove(NodeType* root, uint64_t price) {
-    if (!root)
-        return nullptr;
+void AVLTree<NodeType>::linkNeighbours(NodeType* node) {
+    node->prev = predecessor(node);
+    node->next = successor(node);
+    if (node->prev)
+        node->prev->next = node;
+    if (node->next)
+        node->next->prev = node;
+}
 
-    if (price < root->price) {
-        root->left = remove(root->left, price);
-    } else if (price > root->price) {
-        root->right = remove(root->right, price);
+template <typename NodeType>
+void AVLTree<NodeType>::replaceChild(NodeType*& root,
+                                     NodeType*  parent,
+                                     NodeType*  oldChild,
+                                     NodeType*  newChild) {
+    if (!parent)
+        root = newChild;
+    else if (parent->left == oldChild)
+        parent->left = newChild;
+    else
+        parent->right = newChild;
+    if (newChild)
+        newChild->parent = parent;
+}
+
+template <typename NodeType>
+NodeType* AVLTree<NodeType>::remove(NodeType* root, Price price) {
+    NodeType* node = root;
+    while (node && node->price != price) node = price < node->price ? node->left : node->right;
+    return node ? removeNode(root, node) : root;
+}
+
+template <typename NodeType>
+NodeType* AVLTree<NodeType>::removeNode(NodeType* root, NodeType* node) {
+    NodeType* rebalanceFrom;
+
+    if (!node->left || !node->right) {
+        rebalanceFrom = node->parent;
+        replaceChild(root, node->parent, node, node->left ? node->left : node->right);
     } else {
-        if (!root->left || !root->right) {
-            NodeType* temp = root->left ? root->left : root->right;
-
-            if (!temp) {
-                delete root;
-                return nullptr;
-            } else {
-                NodeType* old = root;
-                root          = temp;
-                delete old;
-            }
+        // in-order successor: leftmost node of the right subtree, has no left child
+        NodeType* heir = node->next;
+
+        if (heir->parent != node) {
+            rebalanceFrom = heir->parent;
+            replaceChild(root, heir->parent, heir, heir->right);
+            heir->right         = node->right;
+            heir->right->parent = heir;
         } else {
-            NodeType* successor = findMin(root->right);
-
-            root->leanCopy(successor);
-            root->right = remove(root->right, successor->price);
+            rebalanceFrom = heir;
         }
+
+        replaceChild(root, node->parent, node, heir);
+        heir->left         = node->left;
+        heir->left->parent = heir;
+        heir->height       = node->height;
     }
 
-    return balance(root);
+    if (node->prev)
+        node->prev->next = node->next;
+    if (node->next)
+        node->next->prev = node->prev;
+    destroyNode(node);
+
+    while (rebalanceFrom) {
+        NodeType* parent   = rebalanceFrom->parent;
+        NodeType* balanced = balance(rebalanceFrom);
+        if (balanced != rebalanceFrom)
+            replaceChild(root, parent, rebalanceFrom, balanced);
+        rebalanceFrom = parent;
+    }
+
+    return root;
 }
 
 template <typename NodeType>
@@ -165,7 +300,7 @@ void AVLTree<NodeType>::freeTree(NodeType* root) {
         return;
     freeTree(root->left);
     freeTree(root->right);
-    delete root;
+    destroyNode(root);
 }
 
 template <typename NodeType>
@@ -235,3 +370,27 @@ NodeType* AVLTree<NodeType>::findMax(NodeType* node) {
     while (node->right) node = node->right;
     return node;
 }
+
+template <typename NodeType>
+NodeType* AVLTree<NodeType>::predecessor(NodeType* node) {
+    if (node->left)
+        return findMax(node->left);
+    NodeType* parent = node->parent;
+    while (parent && node == parent->left) {
+        node   = parent;
+        parent = parent->parent;
+    }
+    return parent;
+}
+
+template <typename NodeType>
+NodeType* AVLTree<NodeType>::successor(NodeType* node) {
+    if (node->right)
+        return findMin(node->right);
+    NodeType* parent = node->parent;
+    while (parent && node == parent->right) {
+        node   = parent;
+        parent = parent->parent;
+    }
+    return parent;
+}
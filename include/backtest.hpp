@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "book_policy.hpp"
+#include "order.hpp"
+#include "price.hpp"
+
+/**
+ * @brief Offline replay of historical order flow, without the network or
+ *        the engine threads.
+ *        Input is grouped into one stream per symbol. A stream is fed straight
+ *        into a fresh instrument, whose clock is set to each event's timestamp,
+ *        so a day of flow runs as fast as it can be matched. Symbols share
+ *        nothing, so streams can run on as many threads as there are symbols.
+ *        The result of a stream depends only on its events: the same input
+ *        gives the same fills and the same book every time.
+ *
+ *        CSV input has one event per line, in time order within a symbol:
+ *
+ *            timestamp_ns,symbol,action,ref,client,side,price,quantity,tif
+ *
+ *        `action` is NEWL, NEWM, CANCEL or AMEND. `ref` is the order's id in
+ *        the source data; cancels and amends name their order by it. Prices
+ *        are decimal. Fields an action does not use may be empty (side, price
+ *        and quantity of a CANCEL; the price of a NEWM; tif defaults to GTC).
+ *        An AMEND without a price keeps the current one. Blank lines and
+ *        lines starting with '#' or "timestamp" are skipped.
+ */
+namespace backtest {
+
+enum class Action : uint8_t { NewLimit, NewMarket, Cancel, Amend };
+
+struct Event {
+    int64_t     timestamp = 0;  // ns since the epoch
+    Action      action    = Action::NewLimit;
+    uint64_t    ref       = 0;
+    std::string clientId;
+    Side        side     = Side::Buy;
+    Price       price    = 0;  // ticks; 0 on an AMEND keeps the price
+    int         quantity = 0;
+    TimeInForce tif      = TimeInForce::GTC;
+};
+
+// Every event of one symbol, in input order.
+struct Stream {
+    std::string        symbol;
+    std::vector<Event> events;
+};
+
+// Parses one CSV line. Returns false with `error` set if the line is malformed.
+bool parseCsvLine(std::string_view line,
+                  const TickSize  &tick,
+                  std::string     &symbol,
+                  Event           &event,
+                  std::string     &error);
+
+// Reads a CSV file into one stream per symbol, in order of first appearance.
+// Stops at the first bad line; `error` then says which one and why.
+bool loadCsv(const std::string   &path,
+             const TickSize      &tick,
+             std::vector<Stream> &streams,
+             std::string         &error);
+
+// Reads the order, cancel and amend records of the journals in `dir` (see
+// journal.hpp) into streams. Journal ids serve as refs; records without a
+// timestamp carry the previous one of their symbol.
+bool loadJournal(const std::string &dir, std::vector<Stream> &streams, std::string &error);
+
+struct Result {
+    std::string symbol;
+    size_t      events    = 0;
+    size_t      refused   = 0;  // not accepted by the book (price, liquidity, unknown order)
+    size_t      fills     = 0;  // one per trade, not per side
+    uint64_t    volume    = 0;
+    double      vwap      = 0;
+    Price       open      = 0, high = 0, low = 0, close = 0;
+    size_t      bidLevels = 0, askLevels = 0;
+    size_t      restingOrders = 0;
+
+    // timestamp_ns,symbol,buy_ref,sell_ref,price,quantity per trade
+    std::string fillLog;
+};
+
+// Replays one stream into a new instrument described by `tick` and `book`.
+// With `logFills` unset only the counters are kept.
+Result run(const Stream &stream, const TickSize &tick, const BookSpec &book, bool logFills = true);
+
+// Runs every stream on up to `threads` threads. Results come back in the
+// order of `streams`, however the work was spread.
+std::vector<Result> runAll(const std::vector<Stream> &streams,
+                           const TickSize            &tick,
+                           const BookSpec            &book,
+                           size_t                     threads,
+                           bool                       logFills = true);
+
+}  // namespace backtest
@@ -0,0 +1,63 @@
+#pragma once
+#include <concepts>
+#include <cstdint>
+#include <span>
+
+#include "price.hpp"
+#include "price_ladder.hpp"
+#include "price_level_node.hpp"
+#include "side_tree.hpp"
+#include "utils/object_pool.hpp"
+
+enum class BookType { AVL, Ladder };
+
+// Layout of an instrument's book. Ladder books cover `levels` consecutive ticks
+// starting at `basePrice`; orders outside that range are refused.
+struct BookSpec {
+    BookType type      = BookType::AVL;
+    Price    basePrice = 0;
+    size_t   levels    = 0;
+};
+
+// What the matcher needs from one side of a book.
+template <typename S>
+concept BookSide = requires(
+        S s, const S cs, Order& o, PriceLevelNode* level, std::span<Order* const> orders) {
+    { s.insert(o) } -> std::same_as<PriceLevelNode*>;
+    { s.remove(o) } -> std::same_as<PriceLevelNode*>;
+    { s.remove(o, level) } -> std::same_as<PriceLevelNode*>;
+    { s.bulkLoad(orders) };
+    { cs.above(level) } -> std::same_as<PriceLevelNode*>;
+    { cs.below(level) } -> std::same_as<PriceLevelNode*>;
+    { cs.accepts(Price{}) } -> std::same_as<bool>;
+    { s.low } -> std::convertible_to<PriceLevelNode*>;
+    { s.high } -> std::convertible_to<PriceLevelNode*>;
+    { cs.size() } -> std::convertible_to<size_t>;
+    { cs.empty() } -> std::convertible_to<bool>;
+};
+
+// Book policies: a policy names the container used for each side of an
+// instrument's book and knows how to build it. BookInstrument<Policy> is compiled
+// once per policy, so the matcher calls straight into the container.
+struct AVLBook {
+    using SideType = SideTree<PriceLevelNode>;
+
+    static SideType makeSide(const BookSpec& spec, utils::ObjectPool<PriceLevelNode>& nodes) {
+        (void)spec;
+        SideType side;
+        side.setNodePool(&nodes);
+        return side;
+    }
+};
+
+struct LadderBook {
+    using SideType = PriceLadder<PriceLevelNode>;
+
+    static SideType makeSide(const BookSpec& spec, utils::ObjectPool<PriceLevelNode>& nodes) {
+        (void)nodes;
+        return SideType(spec.basePrice, 1, spec.levels);
+    }
+};
+
+static_assert(BookSide<AVLBook::SideType>);
+static_assert(BookSide<LadderBook::SideType>);
@@ -0,0 +1,179 @@
+#pragma once
+#include <array>
+#include <charconv>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "order.hpp"
+
+// Text protocol verbs; processors are looked up by this instead of by name.
+enum class Command : uint8_t {
+    Unknown,
+    Ping,
+    Debug,
+    NewL,
+    NewM,
+    Cancel,
+    Auth,
+    Send,
+    Sub,
+    Binary,
+    Batch,
+    Amend,
+    Count,
+};
+
+inline Command lookupCommand(std::string_view name) {
+    switch (name.size()) {
+        case 3:
+            if (name == "SUB")
+                return Command::Sub;
+            break;
+        case 4:
+            if (name == "NEWL")
+                return Command::NewL;
+            if (name == "NEWM")
+                return Command::NewM;
+            if (name == "PING")
+                return Command::Ping;
+            if (name == "AUTH")
+                return Command::Auth;
+            if (name == "SEND")
+                return Command::Send;
+            break;
+        case 5:
+            if (name == "DEBUG")
+                return Command::Debug;
+            if (name == "BATCH")
+                return Command::Batch;
+            if (name == "AMEND")
+                return Command::Amend;
+            break;
+        case 6:
+            if (name == "CANCEL")
+                return Command::Cancel;
+            if (name == "BINARY")
+                return Command::Binary;
+            break;
+    }
+    return Command::Unknown;
+}
+
+// The verb a client sends for `cmd`; empty for Unknown and Count.
+constexpr std::string_view commandName(Command cmd) {
+    switch (cmd) {
+        case Command::Ping:
+            return "PING";
+        case Command::Debug:
+            return "DEBUG";
+        case Command::NewL:
+            return "NEWL";
+        case Command::NewM:
+            return "NEWM";
+        case Command::Cancel:
+            return "CANCEL";
+        case Command::Auth:
+            return "AUTH";
+        case Command::Send:
+            return "SEND";
+        case Command::Sub:
+            return "SUB";
+        case Command::Binary:
+            return "BINARY";
+        case Command::Batch:
+            return "BATCH";
+        case Command::Amend:
+            return "AMEND";
+        default:
+            return {};
+    }
+}
+
+/**
+ * @brief One request line split into whitespace separated tokens.
+ *        Tokens are views into the connection's read buffer, so they are only
+ *        valid while the line is being dispatched. Tokens past MAX_TOKENS are
+ *        dropped; no request needs that many.
+ */
+class CommandLine {
+   public:
+    static constexpr size_t MAX_TOKENS = 16;
+
+    // Splits `line` in place. Every token is upper-cased except the one
+    // following AUTH (the passkey), matching the protocol's case rules.
+    explicit CommandLine(char *line, size_t len) {
+        size_t i = 0;
+        while (i < len && count < MAX_TOKENS) {
+            while (i < len && isSpace(line[i])) ++i;
+            if (i == len)
+                break;
+
+            size_t start = i;
+            while (i < len && !isSpace(line[i])) ++i;
+
+            bool keepCase = count > 0 && tokens[count - 1] == "AUTH";
+            if (!keepCase)
+                for (size_t k = start; k < i; ++k) line[k] = toUpper(line[k]);
+            tokens[count++] = std::string_view(line + start, i - start);
+        }
+        command = count ? lookupCommand(tokens[0]) : Command::Unknown;
+    }
+
+    Command verb() const noexcept { return command; }
+    size_t  size() const noexcept { return count; }
+    bool    empty() const noexcept { return count == 0; }
+
+    std::string_view operator[](size_t i) const noexcept { return tokens[i]; }
+
+   private:
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+    static char toUpper(char c) { return (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c; }
+
+    std::array<std::string_view, MAX_TOKENS> tokens{};
+    size_t                                   count   = 0;
+    Command                                  command = Command::Unknown;
+};
+
+// Field parsers for already upper-cased tokens; all of them reject trailing junk.
+
+inline bool parseSide(std::string_view tok, Side &out) {
+    if (tok == "BUY") {
+        out = Side::Buy;
+        return true;
+    }
+    if (tok == "SELL") {
+        out = Side::Sell;
+        return true;
+    }
+    return false;
+}
+
+inline bool parseTimeInForce(std::string_view tok, TimeInForce &out) {
+    if (tok == "GTC")
+        out = TimeInForce::GTC;
+    else if (tok == "IOC")
+        out = TimeInForce::IOC;
+    else if (tok == "FOK")
+        out = TimeInForce::FOK;
+    else
+        return false;
+    return true;
+}
+
+// Strictly positive quantity that fits an order's int fields.
+inline bool parseQuantity(std::string_view tok, int &out) {
+    long long v  = 0;
+    auto [p, ec] = std::from_chars(tok.data(), tok.data() + tok.size(), v);
+    if (ec != std::errc() || p != tok.data() + tok.size() || v <= 0 || v > INT_MAX)
+        return false;
+    out = static_cast<int>(v);
+    return true;
+}
+
+// Unsigned decimal; a leading '-' is rejected rather than wrapped.
+inline bool parseOrderId(std::string_view tok, OrderId &out) {
+    auto [p, ec] = std::from_chars(tok.data(), tok.data() + tok.size(), out);
+    return ec == std::errc() && p == tok.data() + tok.size();
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "instrument.hpp"
+
+/**
+ * @brief Instrument definitions read at startup. One instrument per line:
+ *
+ *            <SYMBOL> tick=<size> [book=avl|ladder] [base=<price>] [levels=<n>]
+ *                     [band_bps=<n>] [max_qty=<n>] [max_open_qty=<n>]
+ *                     [max_notional=<amount>] [engine=<n>]
+ *
+ *        Symbols are up to 8 characters and are upper-cased, as clients' are.
+ *        `tick` is the price increment ("0.01", "0.05", "1"). A ladder book
+ *        covers `levels` ticks from `base` (by default 65536 from one tick).
+ *        The risk keys limit how far an order may be priced from the last
+ *        trade, how large one order may be, and how much quantity and value
+ *        (price x quantity, in the instrument's currency) one client may have
+ *        resting. `engine` pins the instrument to an engine shard. Without
+ *        it, instruments are spread round robin. Blank lines and everything
+ *        after a '#' are ignored.
+ */
+namespace config {
+
+// Parses one instrument line into `spec`. On failure `error` says why.
+bool parseInstrument(std::string_view line, InstrumentSpec &spec, std::string &error);
+
+// Reads every instrument in the file at `path`. Fails on the first bad line,
+// naming it in `error`, and on a symbol defined twice.
+bool loadInstruments(const std::string           &path,
+                     std::vector<InstrumentSpec> &specs,
+                     std::string                 &error);
+
+}  // namespace config
@@ -0,0 +1,204 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "instrument.hpp"
+#include "journal.hpp"
+#include "latency.hpp"
+#include "snapshot.hpp"
+#include "utils/payload.hpp"
+#include "utils/spsc_ring.hpp"
+#include "wire.hpp"
+
+// Identifies the session a reply belongs to. The serial guards against the fd
+// having been closed and reused by another connection in the meantime.
+struct ReplyTo {
+    size_t   reactor  = 0;
+    int      fd       = -1;
+    uint64_t session  = 0;
+    bool     binary   = false;  // answer with wire frames rather than text
+    uint64_t received = 0;      // tsc when the request was read, for Stage::Total
+};
+
+// Decoded request handed from a reactor to an engine.
+struct EngineCommand {
+    enum class Kind : uint8_t { NewOrder, Cancel, Amend, Query, Publish, Batch };
+
+    Kind        kind       = Kind::NewOrder;
+    ReplyTo     replyTo;
+    Instrument *instrument = nullptr;
+    uint64_t    queued     = 0;  // tsc at submit()
+
+    OrderRequest order{};      // NewOrder; Cancel and Amend use clientId, Amend quantity and price
+    OrderId      orderId = 0;  // Cancel, Amend
+
+    // Batch: orders for `instrument`, placed back to back and answered with one ack
+    std::vector<OrderRequest> batch;
+
+    // Query: runs on the engine thread, the result is sent back as the reply
+    std::function<std::string(Instrument &)> query;
+
+    // Publish: relays `text` to `group` on every reactor
+    std::string group;
+    std::string text;
+};
+
+// Output of an engine travelling back to a reactor.
+struct EngineEvent {
+    enum class Kind : uint8_t { Reply, User, Group };
+
+    Kind           kind = Kind::Reply;
+    ReplyTo        replyTo{};      // Reply
+    std::string    target{};       // User: client id, Group: group name
+    std::string    text{};
+    std::string    binary{};       // User: wire form for binary sessions, if there is one
+    utils::Payload payload{};      // Group: encoded once, shared by every reactor and subscriber
+    std::string    key{};          // Group: if set, a newer message with the same key supersedes it
+    uint64_t       published = 0;  // tsc when the engine pushed it
+};
+
+/**
+ * @brief Matching thread owning a shard of instruments.
+ *        Every book is only ever touched by its engine, so matching needs no
+ *        locks. Each reactor (network thread) gets its own pair of SPSC rings:
+ *        commands in, replies and notifications out. A reactor is woken by
+ *        writing to its eventfd in `wakeFds`. Replies go back to the reactor
+ *        that asked; user and group notifications go to every reactor, which
+ *        delivers them to the sessions it holds.
+ *        An idle engine spins briefly and then parks until the next submit.
+ *        Market data is conflated: instruments whose book or trades changed are
+ *        published once at the end of a burst of commands, and no more often
+ *        than `mdInterval`.
+ *        Orders pass the instrument's pre-trade risk checks before they are
+ *        journaled or reach the book. The exposure behind them is kept per
+ *        client as orders rest, trade and leave, on this thread like the book.
+ */
+class Engine final : public InstrumentListener {
+   public:
+    explicit Engine(std::vector<int>          wakeFds,
+                    std::chrono::microseconds mdInterval   = {},
+                    size_t                    ringCapacity = 1 << 14);
+    ~Engine() override;
+
+    Engine(const Engine &)            = delete;
+    Engine &operator=(const Engine &) = delete;
+
+    // Routes the instrument's notifications through this engine and starts
+    // its risk checks from the orders already resting (e.g. recovered ones);
+    // call before the instrument receives its first command.
+    void adopt(Instrument &instrument);
+
+    // Journals every order, cancel, amend and fill from then on; call before
+    // start(). The journal is committed once per burst, and the burst's events
+    // are only handed to the reactors after that. If the journal fails, the
+    // burst goes unanswered and later orders, amends and cancels are refused
+    // with RejectReason::Journal.
+    // With `snapshotEvery` set, the owned instruments are also snapshotted
+    // into the journal's directory at most that often (and once on stop), so
+    // recovery only replays the journal written since; the segments finished
+    // before a snapshot are deleted.
+    void setJournal(std::unique_ptr<journal::Journal> j, std::chrono::seconds snapshotEvery = {}) {
+        wal            = std::move(j);
+        snapshot_every = snapshotEvery;
+        last_snapshot  = std::chrono::steady_clock::now();
+    }
+
+    void start();
+    void stop();
+
+    size_t reactors() const noexcept { return links.size(); }
+
+    // Dispatch and Match times and the order and execution counters, written by
+    // the engine thread; safe to read from any thread.
+    const LatencyStats &latency() const noexcept { return stats; }
+
+    // Reactor thread. Returns false when the engine is backed up.
+    bool submit(size_t reactor, EngineCommand &&cmd);
+
+    // Reactor thread. Hands every pending event to `handle`; returns how many.
+    template <typename Handler>
+    size_t drain(size_t reactor, Handler &&handle) {
+        size_t      n = 0;
+        EngineEvent ev;
+        while (links[reactor]->outbound.tryPop(ev)) {
+            handle(ev);
+            ++n;
+        }
+        return n;
+    }
+
+    void notifyUser(const std::string &clientId, std::string message) override;
+    void notifyGroup(const std::string &group, std::string message) override;
+    void notifyExecution(const Instrument &instrument, const Execution &execution) override;
+    void notifyConflated(const Instrument &instrument,
+                         const std::string &group,
+                         std::string        message) override;
+
+   private:
+    static constexpr int SPIN_LIMIT = 4096;
+    // a burst longer than this still gets its market data and wake-ups out
+    static constexpr int MAX_BURST = 256;
+
+    // Rings shared with one reactor.
+    struct Link {
+        Link(int fd, size_t capacity) : inbound(capacity), outbound(capacity), wake_fd(fd) {}
+
+        utils::SpscRing<EngineCommand> inbound;
+        utils::SpscRing<EngineEvent>   outbound;
+
+        int  wake_fd;
+        bool pending_wake = false;  // engine thread only
+
+        // with a journal, the burst's events wait here until it is committed
+        std::vector<EngineEvent> staged;
+    };
+
+    void run();
+    void execute(EngineCommand &cmd);
+    void reply(const ReplyTo &to, std::string text);
+    void ack(const ReplyTo &to, wire::AckKind kind, OrderId id, std::string text);
+    void reject(const ReplyTo &to, wire::RejectReason reason, std::string text);
+    void placeBatch(EngineCommand &cmd);
+    void rejectRisk(const ReplyTo &to, risk::Verdict verdict, const std::string &symbol = {});
+    risk::Checker &checkerFor(const Instrument &instrument);
+    void publish(Link &link, EngineEvent &&ev);
+    void push(Link &link, EngineEvent &&ev);
+    void releaseStaged();
+    void broadcast(EngineEvent &&ev);
+    void wake(Link &link);
+    bool idle() const;
+    void publishMarketData();
+    void markDirty(Instrument *instrument);
+    void takeSnapshots(bool force);
+
+    std::vector<std::unique_ptr<Link>> links;
+
+    std::chrono::microseconds             md_interval;
+    std::chrono::steady_clock::time_point last_md{};
+    std::vector<Instrument *>             md_dirty;  // changed since the last publish
+
+    std::vector<Instrument *> owned;  // adopted instruments
+
+    // risk state of each adopted instrument, and the order being placed or
+    // amended: its own fills never rested, every other fill releases a maker
+    utils::FlatMap<const Instrument *, risk::Checker> checkers;
+    OrderId                                           active_order = 0;
+
+    std::unique_ptr<journal::Journal>     wal;
+    bool                                  journal_down = false;  // set once a commit fails
+    std::chrono::seconds                  snapshot_every{0};
+    std::chrono::steady_clock::time_point last_snapshot{};
+    uint64_t                              snapshot_seq = 0;  // journal records the last one covers
+
+    LatencyStats stats;
+
+    std::atomic<bool> running{false};
+    std::atomic<bool> parked{false};
+    std::thread       thread;
+};
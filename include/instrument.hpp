@@ -1,73 +1,319 @@
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
 #include <string>
+#include <vector>
 
+#include "book_policy.hpp"
 #include "order.hpp"
+#include "price.hpp"
 #include "price_level_node.hpp"
-#include "side_tree.hpp"
+#include "risk.hpp"
+#include "utils/flat_map.hpp"
+#include "utils/id_generator.hpp"
+#include "utils/object_pool.hpp"
 #include "utils/string.hpp"
-class Instrument {
+
+// Static definition of a tradable instrument.
+struct InstrumentSpec {
+    static constexpr size_t ANY_ENGINE = SIZE_MAX;
+
+    std::string  symbol;
+    TickSize     tick;
+    BookSpec     book;
+    risk::Limits limits{};             // pre-trade limits, all off by default
+    size_t       engine = ANY_ENGINE;  // engine shard to run on; the default spreads round robin
+};
+
+// Receives everything an instrument publishes (executions, market data).
+// The engine running the instrument forwards it to the network thread;
+// an instrument without a listener stays silent.
+class Instrument;
+
+// One side of a trade, reported to the owner of the order.
+struct Execution {
+    std::string_view clientId;
+    OrderId          orderId;
+    Price            price;
+    uint64_t         quantity;
+};
+
+// Outcome of an incoming order.
+enum class Placement {
+    Rested,     // (the rest of) a limit order entered the book
+    Filled,     // traded in full on arrival
+    Cancelled,  // IOC or market: traded what it could, the remainder was dropped
+    Killed,     // FOK that could not fill in full, or a market order with nothing to hit
+    Refused,    // the book cannot hold the price (e.g. off a ladder)
+};
+
+// Outcome of an amend.
+enum class Amendment {
+    Reduced,   // same price, no larger: changed in place, the order kept its queue position
+    Requeued,  // price changed or size grew: moved to the back of its (new) level
+    Filled,    // the new price crossed and the order traded in full
+    Refused,   // the book cannot hold the new price; the order is unchanged
+    Unknown,   // no such resting order for this client
+};
+
+// Trading statistics of an instrument, as saved in a snapshot.
+struct TradeState {
+    Price    lastTradePrice;
+    uint64_t lastTradeSize;
+    int64_t  lastTradeNs;  // system clock
+    uint64_t volumeToday;
+    int64_t  vwapNumerator;
+    Price    open, high, low, close;
+};
+
+// One aggregated price level as seen by the depth feed.
+struct DepthLevel {
+    Price    price;
+    uint64_t quantity;
+
+    bool operator==(const DepthLevel &) const = default;
+};
+
+class InstrumentListener {
    public:
+    virtual ~InstrumentListener() = default;
+
+    virtual void notifyUser(const std::string &clientId, std::string message)           = 0;
+    virtual void notifyGroup(const std::string &group, std::string message)              = 0;
+    virtual void notifyExecution(const Instrument &instrument, const Execution &execution) = 0;
+    // Market data where only the latest message per instrument matters; a consumer that
+    // falls behind may skip to the newest one.
+    virtual void notifyConflated(const Instrument &instrument,
+                                 const std::string &group,
+                                 std::string        message) = 0;
+};
+
+class Instrument {
    public:
-    Instrument() noexcept = default;
+    // Levels per side carried by the L2 feed.
+    static constexpr size_t L2_DEPTH = 10;
+
+    explicit Instrument(const InstrumentSpec &spec)
+        : symbol(spec.symbol),
+          tick(spec.tick),
+          limits(spec.limits),
+          last_trade_ts(std::chrono::system_clock::time_point{}) {}
 
-    explicit Instrument(const std::string &sym) noexcept
-        : symbol(sym), last_trade_ts(std::chrono::system_clock::time_point{}) {}
+    Instrument(const Instrument &)            = delete;
+    Instrument &operator=(const Instrument &) = delete;
 
-    const std::string &getSymbol() const noexcept { return symbol; }
+    virtual ~Instrument() = default;
 
-    const SideTree<PriceLevelNode> &getBuySide() const noexcept { return buy_side; }
-    const SideTree<PriceLevelNode> &getSellSide() const noexcept { return sell_side; }
+    const std::string  &getSymbol() const noexcept { return symbol; }
+    const TickSize     &getTickSize() const noexcept { return tick; }
+    const risk::Limits &getLimits() const noexcept { return limits; }
 
-    const std::unordered_map<OrderId, Order *> &getOrderMap() const noexcept { return order_map; }
+    void setListener(InstrumentListener *l) noexcept { listener = l; }
 
-    Order *findOrder(const OrderId &id) const noexcept {
+    // Stamps trades with `now` instead of the wall clock, e.g. the time of the
+    // event a backtest is replaying. A default time point goes back to the
+    // wall clock.
+    void setSimulatedTime(std::chrono::system_clock::time_point now) noexcept { sim_now = now; }
+
+    // Decimal <-> tick conversion at the edges; everything inside is in ticks.
+    bool        parsePrice(std::string_view text, Price &out) const {
+        return ::parsePrice(text, tick, out);
+    }
+    std::string formatPrice(Price ticks) const { return ::formatPrice(ticks, tick); }
+
+    const utils::FlatMap<OrderId, Order *> &getOrderMap() const noexcept { return order_map; }
+
+    Order *findOrder(OrderId id) const noexcept {
         auto it = order_map.find(id);
         return it == order_map.end() ? nullptr : it->second;
     }
 
-    double      getLastTradePrice() const noexcept { return last_trade_price; }
+    Price       getLastTradePrice() const noexcept { return last_trade_price; }
     uint64_t    getLastTradeSize() const noexcept { return last_trade_size; }
     std::string getLastTradeTimestamp() const noexcept {
         return timepoint_to_string(last_trade_ts);
     }
 
     uint64_t getVolumeToday() const noexcept { return volume_today; }
-    double   getVWAPNumerator() const noexcept { return vwap_numerator; }
+    int64_t  getVWAPNumerator() const noexcept { return vwap_numerator; }
 
+    // Volume weighted average price, in ticks.
     double getVWAP() const noexcept {
-        return (volume_today == 0) ? 0.0 : (vwap_numerator / static_cast<double>(volume_today));
+        return (volume_today == 0) ? 0.0
+                                   : (static_cast<double>(vwap_numerator) /
+                                      static_cast<double>(volume_today));
     }
 
-    double getOpen() const noexcept { return open; }
-    double getHigh() const noexcept { return high; }
-    double getLow() const noexcept { return low; }
-    double getClose() const noexcept { return close; }
+    Price getOpen() const noexcept { return open; }
+    Price getHigh() const noexcept { return high; }
+    Price getLow() const noexcept { return low; }
+    Price getClose() const noexcept { return close; }
 
-    void updateState(double fillPrice, int qty);
+    // Records a fill. The L1 update is not sent per fill: the instrument is
+    // marked and publishMarketData() sends one update for the whole burst.
+    void updateState(Price fillPrice, uint64_t qty);
     void fetchState(std::string clientId);
 
-    std::vector<Order *> getClientOrders(std::string clientId) {
-        return (client_orders.find(clientId) != client_orders.end()) ? client_orders[clientId]
-                                                                     : std::vector<Order *>();
-    }
+    // Market data is published by the engine once per burst of commands: an
+    // F1_UPDATE to L1 if the instrument traded, and the changes to the top
+    // L2_DEPTH levels of either side as one sequenced L2_DELTA to L2.
+    bool hasPendingMarketData() const noexcept { return l1_pending || l2_pending; }
+    void publishMarketData();
 
-    void placeOrder(Order &order);
-    void execute_limit_if_match();
-    void execute_market();
+    // The depth last published to L2, tagged with its sequence number; a
+    // subscriber applies the L2_DELTAs numbered above it.
+    std::string depthSnapshot() const;
+    uint64_t    depthSequence() const noexcept { return l2_seq; }
 
-   private:
-    std::string              symbol;
-    SideTree<PriceLevelNode> buy_side;
-    SideTree<PriceLevelNode> sell_side;
+    // Orders are owned by the instrument's pool and numbered from its own
+    // sequence; fully filled orders are returned to it by the matcher.
+    Order *createOrder(const OrderRequest &req);
+    void   releaseOrder(Order *order);
+
+    // Entry point per order; the matching itself is compiled per book policy.
+    // The order first trades against the opposite side; only a GTC limit
+    // remainder is inserted, so a crossing order never touches the insert path.
+    // Orders that do not rest are released before this returns.
+    virtual Placement placeOrder(Order &order) = 0;
+
+    // Whether the book can hold a limit order at `price` on `side`; a ladder
+    // only covers its range of ticks. Placing or amending to any other price
+    // is refused.
+    virtual bool accepts(Side side, Price price) const = 0;
+
+    // Pulls a resting order out of the book. Only the owning client may cancel;
+    // returns false if the order is unknown (already filled or cancelled).
+    virtual bool cancelOrder(OrderId id, const std::string &clientId) = 0;
+
+    // Changes a resting order to `quantity` open at `price`, keeping its id.
+    // A reduction at the same price is done in place and keeps time priority;
+    // anything else takes the order out, lets it trade if the new price crosses
+    // and queues the remainder last at its level, as a new order would be.
+    virtual Amendment amendOrder(OrderId            id,
+                                 const std::string &clientId,
+                                 uint64_t           quantity,
+                                 Price              price) = 0;
+
+    // Snapshot support. A snapshot holds the trade state, the id sequence and
+    // the resting orders; restoring goes through restoreOrder() for every
+    // order and one loadBook(), on an empty instrument.
+    TradeState tradeState() const;
+    void       restoreTradeState(const TradeState &state);
+    OrderId    nextOrderId() const noexcept { return order_ids.peek(); }
+    void       restoreOrderIds(OrderId next) noexcept { order_ids.restore(next); }
+    Order     *restoreOrder(OrderId             id,
+                            const OrderRequest &req,
+                            uint64_t            filled,
+                            uint64_t            arrivalNs);
 
-    std::unordered_map<OrderId, Order *> order_map;
+    // Rests restored orders, each side sorted by price and oldest first
+    // within a price, on an empty book. Returns false, releasing all of them
+    // and leaving the book empty, if it cannot hold every price.
+    virtual bool loadBook(std::span<Order *const> bids, std::span<Order *const> asks) = 0;
 
-    std::unordered_map<std::string, std::vector<Order *>> client_orders;
+    // Visits up to `limit` levels of one side in ascending price order.
+    virtual void forEachLevel(Side                                 side,
+                              std::function<void(PriceLevelNode *)> func,
+                              size_t                                limit) const = 0;
 
-    double                                last_trade_price{0.0};
+    // Copies up to `limit` levels of one side into `out`, best price first;
+    // returns how many. One virtual call per side, nothing per level.
+    virtual size_t copyDepth(Side side, DepthLevel *out, size_t limit) const = 0;
+
+   protected:
+    void publishL1();
+    void publishL2();
+
+    // pools are declared ahead of the book sides so they outlive the nodes they back
+    utils::ObjectPool<Order>          order_pool;
+    utils::ObjectPool<PriceLevelNode> level_pool;
+
+    std::string         symbol;
+    TickSize            tick;
+    risk::Limits        limits;
+    InstrumentListener *listener = nullptr;
+
+    void notifyUser(const std::string &clientId, std::string message) {
+        if (listener)
+            listener->notifyUser(clientId, std::move(message));
+    }
+    void notifyGroup(const std::string &group, std::string message) {
+        if (listener)
+            listener->notifyGroup(group, std::move(message));
+    }
+    void notifyExecution(const Execution &execution) {
+        if (listener)
+            listener->notifyExecution(*this, execution);
+    }
+    void notifyConflated(const std::string &group, std::string message) {
+        if (listener)
+            listener->notifyConflated(*this, group, std::move(message));
+    }
+
+    utils::IdGenerator               order_ids;
+    utils::FlatMap<OrderId, Order *> order_map;  // resting orders
+
+    Price                                 last_trade_price{0};
     uint64_t                              last_trade_size{0};
     std::chrono::system_clock::time_point last_trade_ts;
+    std::chrono::system_clock::time_point sim_now{};  // unset: the wall clock
     uint64_t                              volume_today{0};
-    double                                vwap_numerator{0.0};
-    double                                open{0.0}, high{0.0}, low{0.0}, close{0.0};
-};
\ No newline at end of file
+    int64_t                               vwap_numerator{0};
+    Price                                 open{0}, high{0}, low{0}, close{0};
+    bool                                  l1_pending{false};  // traded since the last L1 update
+
+    bool                    l2_pending{false};  // book changed since the last L2 publish
+    uint64_t                l2_seq{0};
+    std::vector<DepthLevel> l2_bids, l2_asks;  // as last published, best first
+};
+
+template <typename BookPolicy>
+class BookInstrument final : public Instrument {
+   public:
+    using SideType = typename BookPolicy::SideType;
+    static_assert(BookSide<SideType>);
+
+    explicit BookInstrument(const InstrumentSpec &spec)
+        : Instrument(spec),
+          buy_side(BookPolicy::makeSide(spec.book, level_pool)),
+          sell_side(BookPolicy::makeSide(spec.book, level_pool)) {}
+
+    ~BookInstrument() override;
+
+    const SideType &getBuySide() const noexcept { return buy_side; }
+    const SideType &getSellSide() const noexcept { return sell_side; }
+
+    bool      accepts(Side side, Price price) const override;
+    Placement placeOrder(Order &order) override;
+    bool      cancelOrder(OrderId id, const std::string &clientId) override;
+    Amendment amendOrder(OrderId            id,
+                         const std::string &clientId,
+                         uint64_t           quantity,
+                         Price              price) override;
+
+    void forEachLevel(Side                                 side,
+                      std::function<void(PriceLevelNode *)> func,
+                      size_t                                limit) const override;
+
+    size_t copyDepth(Side side, DepthLevel *out, size_t limit) const override;
+    bool   loadBook(std::span<Order *const> bids, std::span<Order *const> asks) override;
+
+   private:
+    // Trades `taker` against the opposite side for as long as prices cross.
+    void match(Order &taker);
+    // Whether the opposite side holds enough crossing quantity to fill `taker`.
+    bool canFill(const Order &taker) const;
+
+    static bool crosses(const Order &taker, Price resting) {
+        if (taker.type == OrderType::Market)
+            return true;
+        return taker.side == Side::Buy ? resting <= taker.price : resting >= taker.price;
+    }
+
+    SideType buy_side;
+    SideType sell_side;
+};
+
+std::shared_ptr<Instrument> makeInstrument(const InstrumentSpec &spec);
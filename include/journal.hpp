@@ -0,0 +1,159 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "order.hpp"
+
+class Instrument;
+struct Execution;
+
+/**
+ * @brief Write-ahead journal of everything that changes a book.
+ *        Each engine appends fixed-size records to its own journal: orders as
+ *        they arrive, cancels, amends and the fills they cause. Segments are
+ *        preallocated files mapped into memory; an append is a memcpy, and
+ *        commit() syncs everything appended since the last commit with one
+ *        msync, once per burst of commands (group commit).
+ *
+ *        Files are named <epoch>-<engine>-<segment>.journal. Every run of the
+ *        server starts a new epoch, so sorting the names gives the order the
+ *        records were written in for any one instrument, however instruments
+ *        were spread over engines in earlier runs.
+ *
+ *        Recovery replays the orders, cancels and amends into empty books;
+ *        matching is deterministic, so the fills, the ids and the resting
+ *        orders come out as they were. Fill records are for auditing only.
+ */
+namespace journal {
+
+constexpr size_t SYMBOL_LEN    = 8;
+constexpr size_t CLIENT_ID_LEN = ClientId::CAPACITY;  // longer client ids cannot be journaled
+
+enum class RecordKind : uint8_t { New = 1, Cancel = 2, Amend = 3, Fill = 4 };
+
+#pragma pack(push, 1)
+struct Record {
+    RecordKind kind;  // 0 marks the unused tail of a segment
+    uint8_t    side;
+    uint8_t    type;
+    uint8_t    timeInForce;
+    uint32_t   checksum;   // FNV-1a of the record with this field zeroed
+    uint64_t   sequence;   // per journal, from 1
+    uint64_t   timestamp;  // New: the order's arrivalNs
+    uint64_t   orderId;
+    int64_t    price;
+    uint64_t   quantity;
+    char       symbol[SYMBOL_LEN];
+    char       clientId[CLIENT_ID_LEN];
+};
+#pragma pack(pop)
+
+uint32_t checksum(const Record &record);
+
+// Where a record sits in the history: the run (epoch), the engine that wrote
+// it and its sequence in that engine's journal.
+struct Position {
+    uint64_t epoch    = 0;  // runs are numbered from 1; 0 is before everything
+    uint32_t engine   = 0;
+    uint64_t sequence = 0;
+};
+
+// Whether the record at `record` is already part of a snapshot taken at `snapshot`.
+bool covers(const Position &snapshot, const Position &record);
+
+inline std::string_view field(const char *text, size_t len) {
+    size_t n = 0;
+    while (n < len && text[n]) ++n;
+    return std::string_view(text, n);
+}
+
+class Journal {
+   public:
+    static constexpr size_t DEFAULT_SEGMENT = size_t(64) << 20;
+
+    // Nothing is opened yet.
+    Journal(std::string dir,
+            uint64_t    epoch,
+            uint32_t    engine,
+            size_t      segmentBytes = DEFAULT_SEGMENT);
+    ~Journal();
+
+    Journal(const Journal &)            = delete;
+    Journal &operator=(const Journal &) = delete;
+
+    bool open();
+    void close();
+
+    // Appends are dropped once the journal has failed (disk full, I/O error);
+    // the error is reported once and the engine keeps trading.
+    void newOrder(const Instrument &instrument, const Order &order);
+    void cancel(const Instrument &instrument, const std::string &clientId, OrderId id);
+    void amend(const Instrument  &instrument,
+               const std::string &clientId,
+               OrderId            id,
+               uint64_t           quantity,
+               Price              price);
+    void fill(const Instrument &instrument, const Execution &execution);
+
+    // Makes every record appended so far durable. Cheap when nothing is new.
+    void commit();
+
+    // Deletes the finished segments holding nothing after `upTo`, once a
+    // snapshot taken there makes them dead weight. The open segment is kept.
+    void prune(uint64_t upTo);
+
+    bool     failed() const noexcept { return broken; }
+    uint64_t records() const noexcept { return sequence; }
+    Position position() const noexcept { return {epoch, engine, sequence}; }
+
+    const std::string &directory() const noexcept { return dir; }
+
+   private:
+    void        append(Record &record, const Instrument &instrument, std::string_view clientId);
+    std::string segmentPath(uint32_t index) const;
+    bool        openSegment();
+    void        closeSegment();
+
+    std::string dir;
+    uint64_t    epoch;
+    uint32_t    engine;
+    size_t      segment_bytes;
+
+    int      fd       = -1;
+    char    *base     = nullptr;
+    size_t   written  = 0;  // bytes used in the current segment
+    size_t   synced   = 0;  // bytes of it known to be on disk
+    uint32_t segment  = 0;
+    uint64_t sequence = 0;
+    bool     broken   = false;
+
+    // last sequence of each finished segment still on disk, oldest first
+    uint32_t             oldest = 0;
+    std::deque<uint64_t> finished;
+};
+
+// First epoch not used by the journals already in `dir`.
+uint64_t nextEpoch(const std::string &dir);
+
+// Deletes the segments in `dir` of every epoch before `epoch`, once snapshots
+// newer than them cover every book. Returns the number of files removed.
+size_t removeBefore(const std::string &dir, uint64_t epoch);
+
+// Feeds every valid record in `dir` to `visit` with its position, oldest
+// first, skipping epochs before `fromEpoch`. A segment is read up to its first
+// unused or damaged record (a write torn by a crash). Returns the number of
+// records read.
+size_t read(const std::string                                          &dir,
+            const std::function<void(const Position &, const Record &)> &visit,
+            uint64_t                                                    fromEpoch = 0);
+
+// Re-applies one record to the instrument it names. The instrument must not
+// have a listener yet, so replay publishes nothing. Returns false if the
+// record does not reproduce (e.g. the order got a different id).
+bool apply(const Record &record, Instrument &instrument);
+
+}  // namespace journal
@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "utils/histogram.hpp"
+#include "utils/tsc.hpp"
+
+/**
+ * @brief Where a request spends its time, in TSC ticks (see utils/tsc.hpp).
+ *        Reactors record Read, Parse, Enqueue, Write and Total; engines record
+ *        Dispatch and Match. Every thread owns its LatencyStats and is its only
+ *        writer; DEBUG STATS reads them all from a reactor while they run.
+ */
+enum class Stage : uint8_t {
+    Read,      // one recv() that returned data
+    Parse,     // decoding one line or frame and handing it on, engine ring push included
+    Dispatch,  // waiting in the reactor-to-engine ring
+    Match,     // the engine executing the command
+    Enqueue,   // engine publish to the reactor appending the event to the session
+    Write,     // one flush of a session's output
+    Total,     // recv() returning the request to its reply being queued for the socket
+    Count
+};
+
+inline constexpr std::array<std::string_view, size_t(Stage::Count)> STAGE_NAMES = {
+        "read", "parse", "dispatch", "match", "enqueue", "write", "total"};
+
+struct LatencyStats {
+    std::array<utils::Histogram, size_t(Stage::Count)> stages;
+
+    // engines only: orders placed (a batch counts each of its orders) and
+    // executions, two per trade
+    std::atomic<uint64_t> orders{0};
+    std::atomic<uint64_t> executions{0};
+
+    utils::Histogram       &operator[](Stage s) noexcept { return stages[size_t(s)]; }
+    const utils::Histogram &operator[](Stage s) const noexcept { return stages[size_t(s)]; }
+
+    // Records the ticks from `start` to `end`; a zero start means not stamped.
+    void record(Stage s, uint64_t start, uint64_t end) noexcept {
+        if (start != 0)
+            stages[size_t(s)].record(end > start ? end - start : 0);
+    }
+
+    // Writer thread only.
+    static void bump(std::atomic<uint64_t> &counter, uint64_t by = 1) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+};
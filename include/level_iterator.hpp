@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+/**
+ * @brief Walks the occupied price levels of a book side, one neighbour at a
+ *        time, and stops after `limit` levels or at the end of the side.
+ *        Stepping goes through the side's own above()/below(): the threaded
+ *        links of a SideTree or the bitmap of a PriceLadder. There is no stack,
+ *        no allocation and no type-erased call per level.
+ */
+template <typename Book, bool Descending>
+class LevelIterator {
+   public:
+    using node_type         = typename Book::node_type;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = node_type;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = node_type *;
+    using reference         = node_type &;
+
+    LevelIterator() = default;
+    LevelIterator(const Book *book, node_type *start, size_t limit)
+        : book(book), node(limit ? start : nullptr), left(limit) {}
+
+    reference operator*() const { return *node; }
+    pointer   operator->() const { return node; }
+
+    LevelIterator &operator++() {
+        node = --left == 0 ? nullptr : Descending ? book->below(node) : book->above(node);
+        return *this;
+    }
+    LevelIterator operator++(int) {
+        LevelIterator prev = *this;
+        ++*this;
+        return prev;
+    }
+
+    bool operator==(const LevelIterator &other) const { return node == other.node; }
+    bool operator==(std::default_sentinel_t) const { return node == nullptr; }
+
+   private:
+    const Book *book = nullptr;
+    node_type  *node = nullptr;
+    size_t      left = 0;
+};
+
+// A `for`-loopable run of levels; see SideTree/PriceLadder::ascending() and descending().
+template <typename Book, bool Descending>
+struct LevelRange {
+    LevelIterator<Book, Descending> first;
+
+    LevelIterator<Book, Descending> begin() const { return first; }
+    std::default_sentinel_t         end() const { return {}; }
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "order.hpp"
+#include "price.hpp"
+#include "utils/histogram.hpp"
+
+/**
+ * @brief Load generator for the text protocol.
+ *        Opens many sessions, logs each in with AUTH, subscribes it to the
+ *        market data groups and then sends a mix of resting orders, orders
+ *        that cross the book (IOC) and cancels of its own resting orders.
+ *        Requests are pipelined: a session keeps up to `pipeline` of them
+ *        unanswered. Requests and replies are built and read with
+ *        protocol.hpp, the definitions the server itself uses.
+ *
+ *        Measured per request, from the write to the reply being read:
+ *        acks of new orders, acks of cancels and, for crossing orders, the
+ *        first execution. The text EXEC does not name the order, so an
+ *        execution counts as the crossing order's if it arrives while that
+ *        order is the oldest one unanswered; a passive fill of the same
+ *        session landing in that window is counted instead.
+ */
+namespace loadgen {
+
+struct Config {
+    std::string              host     = "127.0.0.1";
+    uint16_t                 port     = 0;
+    size_t                   sessions = 100;
+    size_t                   threads  = 1;
+    std::vector<std::string> symbols{"TSLA"};  // sessions are spread over them
+    std::vector<std::string> groups{"L1", "L2"};
+    std::string              passkey = "pawy";
+    std::string              prefix  = "LG";  // client ids are <prefix><session>
+    TickSize                 tick{2, 1};
+
+    double               rate     = 1000;   // requests per second over all sessions; 0: flat out
+    size_t               pipeline = 8;      // unanswered requests per session
+    double               cancels  = 0.3;    // share of requests that cancel a resting order
+    double               cross    = 0.1;    // share of orders priced through the book, IOC
+    Price                mid      = 10000;  // ticks; passive orders rest around it
+    int                  depth    = 20;     // levels either side of mid the orders spread over
+    int                  maxQty   = 10;
+    std::chrono::seconds duration{10};
+};
+
+// Applies one key=value argument (see loadgen_main.cpp for the keys).
+bool parseOption(std::string_view arg, Config &config, std::string &error);
+
+// Counters and latencies of a set of sessions, in TSC ticks.
+struct Stats {
+    utils::Histogram ack;     // NEWL to REQUEST_MADE
+    utils::Histogram cancel;  // CANCEL to CANCELLED
+    utils::Histogram exec;    // crossing NEWL to its first EXEC
+
+    uint64_t orders     = 0;  // NEWL sent
+    uint64_t cancels    = 0;  // CANCEL sent
+    uint64_t acks       = 0;
+    uint64_t errors     = 0;  // ERR replies; a cancel that lost the race to a fill is one
+    uint64_t executions = 0;
+    uint64_t marketData = 0;  // any other line, L1/L2 updates mostly
+
+    void add(const Stats &other);
+};
+
+/**
+ * @brief What one session sends and how it reads the answers, without the
+ *        socket. Replies to a session come back in request order, so each is
+ *        matched to the oldest request still waiting.
+ */
+class Flow {
+   public:
+    Flow(const Config &config, size_t index);
+
+    const std::string &clientId() const noexcept { return client_id; }
+    const std::string &symbol() const noexcept { return *sym; }
+
+    // AUTH and the subscriptions, sent once on connect.
+    std::string hello() const;
+    // Every reply to hello() has arrived; orders may go out.
+    bool ready() const noexcept { return setup_left == 0; }
+
+    size_t inFlight() const noexcept { return pending.size(); }
+    size_t resting() const noexcept { return resting_ids.size(); }
+
+    // Appends the next request to `out` if the pipeline has room. `now` is
+    // the tsc the request is considered sent at.
+    bool next(std::string &out, uint64_t now, Stats &stats);
+
+    // Handles one line from the server (without its '\n').
+    void onLine(std::string_view line, uint64_t now, Stats &stats);
+
+   private:
+    struct Pending {
+        bool     cancel;
+        bool     crossing;
+        OrderId  id;  // cancel: the order
+        uint64_t sent;
+        bool     filled = false;  // crossing: first EXEC seen
+    };
+
+    const Config      &config;
+    std::string        client_id;
+    const std::string *sym;
+    std::mt19937_64    rng;
+    size_t             setup_left;
+
+    std::deque<Pending>  pending;
+    std::vector<OrderId> resting_ids;  // acked passive orders, candidates for cancels
+    OrderId              last_ioc = 0;  // its CANCELLED (the unfilled rest) answers no request
+};
+
+// Connects config.sessions sessions over config.threads threads, runs the
+// flow for config.duration and returns the totals. Returns false if no
+// session could connect; `error` then says why.
+bool run(const Config &config, Stats &stats, double &elapsed, std::string &error);
+
+}  // namespace loadgen
@@ -0,0 +1,152 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Messages below this level are compiled out: 0 debug, 1 info, 2 warn, 3 error.
+#ifndef TRADESTACK_LOG_LEVEL
+#define TRADESTACK_LOG_LEVEL 1
+#endif
+
+/**
+ * @brief Asynchronous logger that keeps formatting and I/O off the calling thread.
+ *        A call copies a fixed-size binary record into the calling thread's own
+ *        SPSC ring: the timestamp, a pointer to the format string (a literal,
+ *        which must outlive the program) and the raw arguments. No lock, no
+ *        allocation, no system call. A background thread drains every ring,
+ *        substitutes the arguments for the `{}` placeholders and writes each
+ *        batch with one write(2): debug and info to stdout, warnings and errors
+ *        to stderr. When a ring is full the record is dropped and counted
+ *        rather than making the caller wait; the count is logged later.
+ *
+ *        Arguments may be integers, floating point, bool, strings (copied, up
+ *        to TEXT_BYTES per record) and sysError(), which captures errno and is
+ *        rendered with strerror by the background thread.
+ *
+ *            LOG_INFO("reactor {} listening on port {}", reactor, port);
+ *            LOG_ERROR("bind: {}", logging::sysError());
+ */
+namespace logging {
+
+enum class Level : uint8_t { Debug, Info, Warn, Error };
+
+constexpr size_t MAX_ARGS   = 8;
+constexpr size_t TEXT_BYTES = 192;
+
+// errno at the call, formatted later.
+struct SysError {
+    int code;
+};
+
+inline SysError sysError() noexcept {
+    return SysError{errno};
+}
+
+struct Arg {
+    enum class Type : uint8_t { Int, Uint, Double, Bool, Text, Errno };
+
+    Type type;
+    union {
+        int64_t  i;
+        uint64_t u;
+        double   d;
+        struct {
+            uint16_t offset, length;
+        } text;
+    };
+};
+
+struct Record {
+    uint64_t    ns;  // system clock, since the epoch
+    const char *format;
+    Level       level;
+    uint8_t     count;
+    uint16_t    used;  // bytes of `text` taken
+    Arg         args[MAX_ARGS];
+    char        text[TEXT_BYTES];
+};
+
+// Hands `record` to the background thread, starting it on first use.
+void submit(const Record &record) noexcept;
+
+// Blocks until everything logged before the call has been written.
+void flush();
+
+// Redirects output, for tests: info and below to `infoFd`, the rest to `errorFd`.
+void setOutput(int infoFd, int errorFd);
+
+// Renders a record the way the background thread does, without the newline.
+std::string format(const Record &record);
+
+namespace detail {
+
+inline void put(Record &r, Arg::Type type, auto set) {
+    if (r.count == MAX_ARGS)
+        return;
+    Arg &a = r.args[r.count++];
+    a.type = type;
+    set(a);
+}
+
+inline void put(Record &r, std::string_view s) {
+    size_t n = std::min(s.size(), TEXT_BYTES - r.used);
+    put(r, Arg::Type::Text, [&](Arg &a) {
+        a.text = {r.used, static_cast<uint16_t>(n)};
+    });
+    std::memcpy(r.text + r.used, s.data(), n);
+    r.used += static_cast<uint16_t>(n);
+}
+
+template <typename T>
+void encode(Record &r, const T &v) {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, bool>)
+        put(r, Arg::Type::Bool, [&](Arg &a) { a.u = v; });
+    else if constexpr (std::is_same_v<U, SysError>)
+        put(r, Arg::Type::Errno, [&](Arg &a) { a.i = v.code; });
+    else if constexpr (std::is_enum_v<U>)
+        put(r, Arg::Type::Int, [&](Arg &a) { a.i = static_cast<int64_t>(v); });
+    else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>)
+        put(r, Arg::Type::Int, [&](Arg &a) { a.i = v; });
+    else if constexpr (std::is_integral_v<U>)
+        put(r, Arg::Type::Uint, [&](Arg &a) { a.u = v; });
+    else if constexpr (std::is_floating_point_v<U>)
+        put(r, Arg::Type::Double, [&](Arg &a) { a.d = v; });
+    else
+        put(r, std::string_view(v));
+}
+
+template <typename... Args>
+void log(Level level, const char *format, const Args &...args) noexcept {
+    Record r;
+    r.ns     = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::system_clock::now().time_since_epoch())
+                                         .count());
+    r.format = format;
+    r.level  = level;
+    r.count  = 0;
+    r.used   = 0;
+    (encode(r, args), ...);
+    submit(r);
+}
+
+}  // namespace detail
+
+}  // namespace logging
+
+#define TRADESTACK_LOG(level, min, ...)                                    \
+    do {                                                                   \
+        if constexpr ((min) >= TRADESTACK_LOG_LEVEL)                       \
+            ::logging::detail::log(::logging::Level::level, __VA_ARGS__); \
+    } while (0)
+
+#define LOG_DEBUG(...) TRADESTACK_LOG(Debug, 0, __VA_ARGS__)
+#define LOG_INFO(...)  TRADESTACK_LOG(Info, 1, __VA_ARGS__)
+#define LOG_WARN(...)  TRADESTACK_LOG(Warn, 2, __VA_ARGS__)
+#define LOG_ERROR(...) TRADESTACK_LOG(Error, 3, __VA_ARGS__)
@@ -1,12 +1,96 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
+#include "engine.hpp"
 #include "instrument.hpp"
+#include "latency.hpp"
+#include "symbol_directory.hpp"
+
+// Where a symbol lives: the instrument and the engine thread that owns it.
+struct Route {
+    Instrument *instrument = nullptr;
+    Engine     *engine     = nullptr;  // null until the manager is started
+    SymbolId    id         = NO_SYMBOL;
+};
 
 class Manager {
    public:
-    bool new_instrument(std::string symbol);
+    static constexpr std::chrono::seconds DEFAULT_SNAPSHOT{60};
+
+    Manager() = default;
+    ~Manager();
+
+    // Adds an instrument; false if the symbol is taken or the engines are
+    // already running (they and the reactors read the routes unlocked). Its
+    // spec.engine, if set, pins it to that engine (modulo the engine count).
+    bool new_instrument(const InstrumentSpec &spec);
+
+    // Restores the instruments from their snapshots in `dir`, if any, and
+    // replays the journal records written after them; start() then journals
+    // this run there as a new epoch and snapshots every `snapshotEvery`.
+    // When every book has a snapshot, the journal epochs older than all of
+    // them are deleted. Call after the instruments are added and before start().
+    void recover(const std::string &dir, std::chrono::seconds snapshotEvery = DEFAULT_SNAPSHOT);
+
+    // Spreads the instruments over `engineCount` engine threads, wires each of
+    // them to `reactorCount` reactors and starts them. Instruments without a
+    // pinned engine are dealt out round robin. `mdInterval` throttles each
+    // engine's market data (zero: one update per burst of commands).
+    bool start(size_t                    engineCount,
+               size_t                    reactorCount = 1,
+               std::chrono::microseconds mdInterval   = {});
+    void stop();
+
+    size_t reactors() const noexcept { return wake_fds_.size(); }
+
+    // One hash of the symbol, then everything is indexed by its id.
+    const Route *route(std::string_view symbol) const { return route(symbols_.find(symbol)); }
+    const Route *route(SymbolId id) const {
+        return id < routes_.size() && routes_[id].engine ? &routes_[id] : nullptr;
+    }
+    // Every instrument, by id; valid once started.
+    const std::vector<Route> &routes() const noexcept { return routes_; }
+    const SymbolDirectory    &symbols() const noexcept { return symbols_; }
+
+    // eventfd the engines signal when they have events for `reactor`
+    int wake_fd(size_t reactor) const noexcept { return wake_fds_[reactor]; }
+
+    template <typename Handler>
+    void drain(size_t reactor, Handler &&handle) {
+        for (auto &e : engines_) e->drain(reactor, handle);
+    }
+
+    // Stages timed on `reactor`'s thread (see latency.hpp); valid once started.
+    LatencyStats &latency(size_t reactor) noexcept { return *reactor_stats_[reactor]; }
+
+    // Calls `visit` with the latency stats of every reactor and engine.
+    template <typename Visitor>
+    void forEachLatency(Visitor &&visit) const {
+        for (auto &r : reactor_stats_) visit(static_cast<const LatencyStats &>(*r));
+        for (auto &e : engines_) visit(e->latency());
+    }
+
+    // Sends `text` to the members of `group` on every reactor.
+    bool publish(size_t reactor, std::string group, std::string text);
+
+    // by symbol id
+    std::vector<std::shared_ptr<Instrument>> instruments_;
+
+   private:
+    void assign(SymbolId id);
 
-    std::unordered_map<std::string, std::shared_ptr<Instrument>> instruments_;
-};
\ No newline at end of file
+    SymbolDirectory                            symbols_;
+    std::vector<Route>                         routes_;  // by symbol id
+    std::vector<size_t>                        pinned_;  // engine asked for, by symbol id
+    std::vector<std::unique_ptr<Engine>>       engines_;
+    std::vector<int>                           wake_fds_;
+    std::vector<std::unique_ptr<LatencyStats>> reactor_stats_;
+    size_t                                     next_engine_ = 0;
+    std::string                                journal_dir_;
+    std::chrono::seconds                       snapshot_every_{0};
+};
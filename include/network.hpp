@@ -2,32 +2,62 @@
 
 #include <unistd.h>
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <functional>
-#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "command.hpp"
+#include "latency.hpp"
 #include "manager.hpp"
+#include "notifier.hpp"
+#include "output_chain.hpp"
+#include "risk.hpp"
+#include "utils/fd_table.hpp"
+#include "utils/flat_map.hpp"
+#include "utils/timer_wheel.hpp"
+#include "wire.hpp"
 
 struct Session {
     int                                   fd;
-    std::string                           inbuf;
-    std::string                           outbuf;
+    uint64_t                              serial;       // unique per connection, unlike fd
+    std::string                           inbuf;        // unparsed bytes, compacted once per read
+    size_t                                scanned = 0;  // inbuf[0, scanned) holds no newline
+    OutputChain                           out;
     std::chrono::seconds                  timeout;
     std::chrono::steady_clock::time_point last_active;
+    utils::TimerWheel<int>::Handle        idle_timer;  // on the server's wheel, by fd
+    risk::Throttle                        throttle;    // order entry messages
 
     bool is_authenticated = false;
+    bool binary           = false;  // speaks wire frames instead of text lines
+    bool dirty            = false;  // queued on the server's flush list
+    bool want_write       = false;  // EPOLLOUT armed: the socket was full at the last flush
+
+    // latest keyed market data held back while the socket is full
+    std::unordered_map<std::string, utils::Payload> conflated;
+
+    // text BATCH in progress: order lines still expected, the ones read so far
+    // and the first problem found (the whole batch is refused if there is one)
+    size_t                    batch_left = 0;
+    std::vector<OrderRequest> batch;
+    std::string               batch_error;
 
     std::string client_id;
 
-    Session(int fd_, std::chrono::seconds timeout_)
-        : fd(fd_), timeout(timeout_), last_active(std::chrono::steady_clock::now()) {}
+    Session(int fd_, uint64_t serial_, std::chrono::seconds timeout_)
+        : fd(fd_),
+          serial(serial_),
+          timeout(timeout_),
+          last_active(std::chrono::steady_clock::now()) {}
 
     void touch() { last_active = std::chrono::steady_clock::now(); }
 
-    bool is_stale() { return (std::chrono::steady_clock::now() - last_active) > timeout; }
+    std::chrono::steady_clock::time_point deadline() const { return last_active + timeout; }
 
     void close_fd() {
         if (fd >= 0) {
@@ -38,48 +68,132 @@ struct Session {
 };
 using Processor = std::function<void(int /*fd*/,
                                      std::shared_ptr<Session>& /*session*/,
-                                     std::vector<std::string>& /*parts*/,
-                                     std::string /*clientId*/
+                                     const CommandLine& /*parts*/,
+                                     const std::string& /*clientId*/
                                      )>;
 
+/**
+ * @brief One reactor: an epoll loop with its own listening socket and sessions.
+ *        Several reactors can serve the same port; each binds with SO_REUSEPORT
+ *        and the kernel spreads incoming connections across them. A reactor
+ *        only ever touches its own sessions, so reactors share nothing but
+ *        the Manager, whose engines are reached through per-reactor rings.
+ */
 class Server {
    public:
-    static Manager manager;
-
-    Server(uint16_t port, int max_events = 64) : port_(port), max_events_(max_events) {}
+    Server(uint16_t port, Manager& manager, size_t reactor = 0, int max_events = 64)
+        : manager(manager),
+          notifier_(*this),
+          port_(port),
+          reactor_(reactor),
+          max_events_(max_events) {}
 
     ~Server() { stop(); }
 
+    Server(const Server&)            = delete;
+    Server& operator=(const Server&) = delete;
+
     bool start();
     void stop();
     void run();
 
+    // Asks run() to return; safe to call from any thread.
+    void request_stop() noexcept { running_.store(false); }
+
+    Notifier& notifier() noexcept { return notifier_; }
+
+    Manager& manager;
+
    private:
-    uint16_t   port_;
-    int        max_events_;
-    static int epoll_fd_;
-    static int listen_fd_;
-
-    static std::map<int, std::shared_ptr<Session>>         temp_sessions_;
-    static std::map<std::string, std::shared_ptr<Session>> sessions_;
-    static std::unordered_map<std::string, Processor>      processors_;
-
-    static void accept_new();
-    static void cleanup_stale();
-    static bool handle_read(int fd);
-    static bool handle_write(int fd);
-    static void modify_epoll_out(int fd, bool enable);
-
-    static void process_session_messages(int fd, std::string clientId);
-    static void remove_session(int fd);
-    static void dispatch(std::string&              cmd,
-                         int                       fd,
-                         std::shared_ptr<Session>& s,
-                         std::vector<std::string>& parts,
-                         std::string               clientId);
-    static void enqueue_reply(int fd, std::shared_ptr<Session>& s, const std::string& reply);
-    static void load_processors();
-    static void register_processor(std::string cmd, Processor p);
+    Notifier          notifier_;
+    uint16_t          port_;
+    size_t            reactor_;
+    int               max_events_;
+    int               epoll_fd_    = -1;
+    int               listen_fd_   = -1;
+    uint64_t          next_serial_ = 1;
+    std::atomic<bool> running_{true};
+
+    // this reactor's stage timings, and when the current input was read (tsc)
+    LatencyStats *latency_  = nullptr;
+    uint64_t      read_tsc_ = 0;
+    // counters at the previous DEBUG STATS, for its rates
+    std::chrono::steady_clock::time_point stats_at_;
+    uint64_t                              stats_orders_     = 0;
+    uint64_t                              stats_executions_ = 0;
+
+    // every connection by fd, and the authenticated ones by client id
+    utils::FdTable<std::shared_ptr<Session>>              temp_sessions_;
+    utils::FlatMap<std::string, std::shared_ptr<Session>> sessions_;
+    std::vector<std::shared_ptr<Session>>                 dirty_;  // have output since last flush
+    // one idle timer per session; touch() leaves it alone, it is moved when it fires
+    utils::TimerWheel<int> timers_;
+    std::array<Processor, size_t(Command::Count)>         processors_;
+
+    void accept_new();
+    void cleanup_stale();
+    void schedule_idle(std::shared_ptr<Session>& s);
+    bool handle_read(int fd);
+    bool handle_write(int fd);
+    bool flush_session(std::shared_ptr<Session>& s);
+    void flush_dirty();
+    void mark_dirty(std::shared_ptr<Session>& s);
+    void modify_epoll_out(int fd, bool enable);
+    void drain_engines();
+    void deliver(EngineEvent& ev);
+    bool submit(const Route& route, EngineCommand&& cmd);
+
+    bool process_session_messages(int fd);
+    void remove_session(int fd);
+    void dispatch(const CommandLine& line, int fd, std::shared_ptr<Session>& s);
+    void dispatch_frame(const wire::Header&       hdr,
+                        const char*               data,
+                        int                       fd,
+                        std::shared_ptr<Session>& s);
+
+    // Charges `messages` to the session's rate limit, refusing the request
+    // with THROTTLED if it is spent.
+    bool admit(int fd, std::shared_ptr<Session>& s, uint32_t messages = 1);
+    // Order entry shared by the text processors and the binary frames.
+    void submit_order(int                       fd,
+                      std::shared_ptr<Session>& s,
+                      const Route&              route,
+                      Side                      side,
+                      int                       qty,
+                      Price                     price,
+                      OrderType                 type = OrderType::Limit,
+                      TimeInForce               tif  = TimeInForce::GTC);
+    void submit_cancel(int fd, std::shared_ptr<Session>& s, const Route& route, OrderId id);
+    void submit_amend(int                       fd,
+                      std::shared_ptr<Session>& s,
+                      const Route&              route,
+                      OrderId                   id,
+                      int                       qty,
+                      Price                     price);
+    // Orders of one instrument, answered by a single BATCH_ACK.
+    void submit_batch(int                         fd,
+                      std::shared_ptr<Session>&   s,
+                      const Route&                route,
+                      std::vector<OrderRequest>&& orders);
+    void batch_line(const CommandLine& line, int fd, std::shared_ptr<Session>& s);
+
+    void enqueue_reply(int fd, std::shared_ptr<Session>& s, const std::string& reply);
+    // Queues a reference to a broadcast instead of a copy of it; see Notifier for `key`.
+    void enqueue_shared(std::shared_ptr<Session>& s,
+                        const utils::Payload&     message,
+                        const std::string&        key = {});
+    // Sends `text`, or `binary` to a binary session (text is framed if there is no binary form).
+    void enqueue_message(std::shared_ptr<Session>& s,
+                         const std::string&        text,
+                         const std::string&        binary = {});
+    // Refuses a request in the session's protocol.
+    void reject(int                       fd,
+                std::shared_ptr<Session>& s,
+                wire::RejectReason        reason,
+                const std::string&        text);
+    std::string describe_latency();
+    void        load_processors();
+    void register_processor(Command cmd, Processor p);
 
     friend class Notifier;
 };
\ No newline at end of file
@@ -1,27 +1,37 @@
 #pragma once
-#include <algorithm>
+#include <memory>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
-#include "network.hpp"
+#include "utils/flat_map.hpp"
+#include "utils/payload.hpp"
 
+class Server;
+struct Session;
+
+// Delivers messages to the sessions of one reactor; every reactor has its own
+// Notifier and with it its own group memberships. Members are held as session
+// handles, so a group message costs no lookups; closed sessions are dropped
+// the next time their group is notified.
 class Notifier {
    public:
-    static Notifier &instance() {
-        static Notifier inst;
-        return inst;
-    }
+    explicit Notifier(Server &server) : server(server) {}
 
-    void subscribe(std::string group, std::string clientId);
-    void unsubscribe(std::string group, std::string clientId);
-    void notifyUser(std::string clientId, std::string message);
-    void notifyGroup(std::string group, std::string message);
+    void subscribe(const std::string &group, const std::shared_ptr<Session> &session);
+    void unsubscribe(const std::string &group, const std::shared_ptr<Session> &session);
+    void notifyUser(const std::string &clientId,
+                    const std::string &message,
+                    const std::string &binary = {});
+    // `message` is shared by every member's output queue, not copied. With a
+    // `key`, a member whose socket is full keeps only the latest message per key.
+    void notifyGroup(const std::string    &group,
+                     const utils::Payload &message,
+                     const std::string    &key = {});
     void registerGroup(std::string group);
     void removeGroup(std::string group);
 
-    std::unordered_map<std::string, std::vector<std::string>> groups;
+    utils::FlatMap<std::string, std::vector<std::shared_ptr<Session>>> groups;
 
    private:
-    Notifier() = default;
+    Server &server;
 };
\ No newline at end of file
@@ -1,40 +1,88 @@
 #pragma once
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
-#include <list>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <utility>
 
-#include "utils/id_generator.hpp"
+#include "price.hpp"
 #include "utils/print_utils.hpp"
 
 enum class Side { Buy, Sell };
 
 enum class OrderType { Market, Limit };
 
+// What happens to the part of an order that does not trade on arrival: GTC
+// rests in the book, IOC is cancelled, FOK trades in full or not at all.
+// Market orders never rest and behave as IOC unless sent FOK.
+enum class TimeInForce { GTC, IOC, FOK };
+
 using OrderId = uint64_t;
+
+struct PriceLevelNode;
+
+// Client id held inline, so a pooled order never allocates for it. Longer ids
+// are truncated; sessions and the journal refuse them before they get here.
+class ClientId {
+   public:
+    static constexpr std::size_t CAPACITY = 24;
+
+    ClientId() = default;
+    ClientId(std::string_view cid) { assign(cid); }
+
+    ClientId& operator=(std::string_view cid) {
+        assign(cid);
+        return *this;
+    }
+
+    [[nodiscard]] std::string_view view() const noexcept { return {chars, length}; }
+    [[nodiscard]] std::size_t      size() const noexcept { return length; }
+    operator std::string_view() const noexcept { return view(); }
+
+    friend bool operator==(const ClientId& a, std::string_view b) noexcept { return a.view() == b; }
+
+   private:
+    char         chars[CAPACITY];
+    std::uint8_t length = 0;
+
+    void assign(std::string_view cid) {
+        length = static_cast<std::uint8_t>(std::min(cid.size(), CAPACITY));
+        std::memcpy(chars, cid.data(), length);
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const ClientId& cid) {
+    return os << cid.view();
+}
+
 struct Order {
     using Clock     = std::chrono::steady_clock;
     using TimePoint = std::chrono::time_point<Clock>;
 
-    std::string id;
-    std::string clientId;
+    OrderId  id;
+    ClientId clientId;
 
-    std::uint64_t price;
+    Price         price;  // in ticks
     std::uint64_t remainingQuantity;
     std::uint64_t filledQuantity = 0;
 
-    Side      side;
-    OrderType type;
+    Side        side;
+    OrderType   type;
+    TimeInForce tif = TimeInForce::GTC;
 
     TimePoint     arrivalTime;
     std::uint64_t arrivalNs;  // for persistence
 
-    std::list<Order*>::iterator level_posn;
+    // intrusive links into the OrderQueue of the price level the order rests at
+    Order*          prev  = nullptr;
+    Order*          next  = nullptr;
+    PriceLevelNode* level = nullptr;
 
-    explicit Order(std::string cid, double p, int q, Side s, OrderType t)
-        : id(utils::IdGenerator::next()),
-          clientId(std::move(cid)),
+    explicit Order(OrderId oid, std::string_view cid, Price p, int q, Side s, OrderType t)
+        : id(oid),
+          clientId(cid),
           price(p),
           remainingQuantity(q),
           side(s),
@@ -54,17 +102,17 @@ struct Order {
         arrivalTime = TimePoint(std::chrono::nanoseconds(ns));
     }
 
-    void setPrice(std::uint64_t p) { price = p; }
+    void setPrice(Price p) { price = p; }
     void setRemainingQuantity(std::uint64_t q) { remainingQuantity = q; }
     void setFilledQuantity(std::uint64_t q) { filledQuantity = q; }
     void setSide(Side s) { side = s; }
     void setType(OrderType t) { type = t; }
-    void setClientId(std::string cid) { clientId = std::move(cid); }
-    void setId(std::string oid) { id = std::move(oid); }
+    void setClientId(std::string_view cid) { clientId = cid; }
+    void setId(OrderId oid) { id = oid; }
 
-    [[nodiscard]] const std::string& getId() const { return id; }
-    [[nodiscard]] const std::string& getClientId() const { return clientId; }
-    [[nodiscard]] std::uint64_t      getPrice() const { return price; }
+    [[nodiscard]] OrderId            getId() const { return id; }
+    [[nodiscard]] std::string_view   getClientId() const { return clientId.view(); }
+    [[nodiscard]] Price              getPrice() const { return price; }
     [[nodiscard]] std::uint64_t      getRemainingQuantity() const { return remainingQuantity; }
     [[nodiscard]] std::uint64_t      getFilledQuantity() const { return filledQuantity; }
     [[nodiscard]] Side               getSide() const { return side; }
@@ -78,12 +126,11 @@ struct OrderRequest {
     std::string symbol;
     Side        side;
     OrderType   type;
-    double      price;
+    Price       price;  // in ticks; ignored for market orders
     int         quantity;
+    TimeInForce tif = TimeInForce::GTC;
 };
 
-Order* createOrder(const OrderRequest& req);
-
 inline void printOrder(const Order& ord, std::ostream& os = std::cout, std::size_t width = 15) {
     utils::printField("ID", ord.id, width, os);
     utils::printField("Client ID", ord.clientId, width, os);
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+#include "order.hpp"
+
+/**
+ * @brief Intrusive FIFO of the orders resting at one price level.
+ *        Links live in the Order itself, so appending and cancelling are O(1)
+ *        with no per-order allocation. The queue also keeps the order count
+ *        and the aggregate remaining quantity of the level.
+ */
+class OrderQueue {
+   public:
+    class iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = Order*;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = Order**;
+        using reference         = Order*;
+
+        explicit iterator(Order* o = nullptr) : cur(o) {}
+
+        Order*    operator*() const { return cur; }
+        iterator& operator++() {
+            cur = cur->next;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator tmp = *this;
+            cur          = cur->next;
+            return tmp;
+        }
+        bool operator==(const iterator& other) const { return cur == other.cur; }
+        bool operator!=(const iterator& other) const { return cur != other.cur; }
+
+       private:
+        Order* cur;
+    };
+
+    OrderQueue() = default;
+
+    OrderQueue(const OrderQueue&)            = delete;
+    OrderQueue& operator=(const OrderQueue&) = delete;
+
+    Order* front() const { return head; }
+    Order* back() const { return tail; }
+
+    bool          empty() const { return count == 0; }
+    size_t        size() const { return count; }
+    std::uint64_t quantity() const { return total_quantity; }
+
+    iterator begin() const { return iterator(head); }
+    iterator end() const { return iterator(); }
+
+    void push_back(Order* order) {
+        order->prev = tail;
+        order->next = nullptr;
+        if (tail)
+            tail->next = order;
+        else
+            head = order;
+        tail = order;
+
+        ++count;
+        total_quantity += order->remainingQuantity;
+    }
+
+    // Unlinks an order that is known to sit in this queue.
+    void erase(Order* order) {
+        if (order->prev)
+            order->prev->next = order->next;
+        else
+            head = order->next;
+        if (order->next)
+            order->next->prev = order->prev;
+        else
+            tail = order->prev;
+        order->prev = order->next = nullptr;
+
+        --count;
+        total_quantity -= order->remainingQuantity;
+    }
+
+    Order* pop_front() {
+        Order* order = head;
+        if (order)
+            erase(order);
+        return order;
+    }
+
+    // Executes `qty` against a resting order, keeping the level aggregate in step.
+    void fill(Order* order, std::uint64_t qty) {
+        order->filledQuantity += qty;
+        order->remainingQuantity -= qty;
+        total_quantity -= qty;
+    }
+
+    // Lowers a resting order's open quantity without moving it in the queue.
+    void reduce(Order* order, std::uint64_t qty) {
+        order->remainingQuantity -= qty;
+        total_quantity -= qty;
+    }
+
+    void swap(OrderQueue& other) noexcept {
+        std::swap(head, other.head);
+        std::swap(tail, other.tail);
+        std::swap(count, other.count);
+        std::swap(total_quantity, other.total_quantity);
+    }
+
+   private:
+    Order*        head           = nullptr;
+    Order*        tail           = nullptr;
+    size_t        count          = 0;
+    std::uint64_t total_quantity = 0;
+};
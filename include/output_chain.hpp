@@ -0,0 +1,121 @@
+#pragma once
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+
+#include "utils/payload.hpp"
+
+/**
+ * @brief Pending output of one connection as a chain of buffers.
+ *        Small writes are coalesced into the tail buffer, so a burst of short
+ *        replies ends up in a handful of chunks; flush() hands up to MAX_IOV
+ *        chunks to the kernel per sendmsg (scatter/gather, like writev) and
+ *        only advances a cursor instead of erasing sent bytes. Shared payloads
+ *        (broadcasts) are queued by reference and never copied.
+ */
+class OutputChain {
+   public:
+    enum class Status { Done, Blocked, Error };
+
+    static constexpr size_t COALESCE_LIMIT = 4096;
+    static constexpr int    MAX_IOV        = 64;
+
+    bool   empty() const noexcept { return pending == 0; }
+    size_t size() const noexcept { return pending; }
+
+    void append(std::string_view data) {
+        if (data.empty())
+            return;
+        if (chunks.empty() || chunks.back().shared ||
+            chunks.back().own.size() + data.size() > COALESCE_LIMIT)
+            chunks.emplace_back();
+        chunks.back().own.append(data);
+        pending += data.size();
+    }
+
+    // Large payloads are moved in as their own chunk rather than copied.
+    void append(std::string &&data) {
+        if (data.size() <= COALESCE_LIMIT) {
+            append(std::string_view(data));
+            return;
+        }
+        pending += data.size();
+        chunks.push_back(Chunk{std::move(data), nullptr});
+    }
+
+    void append(const utils::Payload &data) {
+        if (!data || data->empty())
+            return;
+        pending += data->size();
+        chunks.push_back(Chunk{{}, data});
+    }
+
+    // Writes as much as the socket takes. Blocked means the kernel buffer is
+    // full (EAGAIN) and the rest has to wait for EPOLLOUT.
+    Status flush(int fd) {
+        while (!chunks.empty()) {
+            iovec iov[MAX_IOV];
+            int   n = 0;
+            for (auto it = chunks.begin(); it != chunks.end() && n < MAX_IOV; ++it, ++n) {
+                std::string_view bytes = it->view();
+                size_t           skip  = n == 0 ? offset : 0;
+                iov[n].iov_base        = const_cast<char *>(bytes.data()) + skip;
+                iov[n].iov_len         = bytes.size() - skip;
+            }
+
+            msghdr msg{};
+            msg.msg_iov    = iov;
+            msg.msg_iovlen = n;
+
+            // MSG_NOSIGNAL: a peer that went away is reported as EPIPE, not SIGPIPE
+            ssize_t sent = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    return Status::Blocked;
+                return Status::Error;
+            }
+            consume(static_cast<size_t>(sent));
+        }
+        return Status::Done;
+    }
+
+    void clear() {
+        chunks.clear();
+        offset  = 0;
+        pending = 0;
+    }
+
+   private:
+    void consume(size_t n) {
+        pending -= n;
+        while (n > 0) {
+            size_t left = chunks.front().view().size() - offset;
+            if (n < left) {
+                offset += n;
+                return;
+            }
+            n -= left;
+            chunks.pop_front();
+            offset = 0;
+        }
+    }
+
+    // Either bytes owned by this connection or a reference to a shared payload.
+    struct Chunk {
+        std::string    own;
+        utils::Payload shared;
+
+        std::string_view view() const { return shared ? std::string_view(*shared) : own; }
+    };
+
+    std::deque<Chunk> chunks;
+    size_t            offset  = 0;  // bytes of chunks.front() already sent
+    size_t            pending = 0;
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+// Prices inside the engine are integer multiples of the instrument's tick.
+using Price = std::int64_t;
+
+// Decimal quoting of an instrument: prices carry `decimals` fractional digits
+// and move in steps of `units` x 10^-decimals, e.g. {2, 5} is a 0.05 tick.
+struct TickSize {
+    std::uint32_t decimals = 0;
+    std::int64_t  units    = 1;
+};
+
+namespace detail {
+inline std::int64_t pow10(std::uint32_t n) {
+    std::int64_t p = 1;
+    while (n--) p *= 10;
+    return p;
+}
+}  // namespace detail
+
+/**
+ * @brief Parses a decimal price ("250", "250.5", "250.50") straight into ticks.
+ *        Fails on malformed input, on more significant fractional digits than
+ *        the instrument quotes, on overflow and on prices that are off tick.
+ */
+inline bool parsePrice(std::string_view text, const TickSize &tick, Price &out) {
+    constexpr std::int64_t MAX = std::numeric_limits<std::int64_t>::max();
+
+    std::int64_t  scaled    = 0;
+    std::uint32_t fraction  = 0;
+    bool          seenDot   = false;
+    bool          seenDigit = false;
+
+    for (char c : text) {
+        if (c == '.') {
+            if (seenDot)
+                return false;
+            seenDot = true;
+            continue;
+        }
+        if (c < '0' || c > '9')
+            return false;
+        seenDigit = true;
+
+        if (seenDot) {
+            if (fraction == tick.decimals) {
+                // trailing zeros past the quoted precision are harmless
+                if (c != '0')
+                    return false;
+                continue;
+            }
+            ++fraction;
+        }
+        int digit = c - '0';
+        if (scaled > (MAX - digit) / 10)
+            return false;
+        scaled = scaled * 10 + digit;
+    }
+    if (!seenDigit)
+        return false;
+
+    for (; fraction < tick.decimals; ++fraction) {
+        if (scaled > MAX / 10)
+            return false;
+        scaled *= 10;
+    }
+
+    if (tick.units <= 0 || scaled % tick.units != 0)
+        return false;
+    out = scaled / tick.units;
+    return true;
+}
+
+// Renders ticks with exactly `decimals` fractional digits.
+inline std::string formatPrice(Price ticks, const TickSize &tick) {
+    std::int64_t scaled = ticks * tick.units;
+    std::string  out;
+    if (scaled < 0) {
+        out.push_back('-');
+        scaled = -scaled;
+    }
+    if (tick.decimals == 0)
+        return out + std::to_string(scaled);
+
+    std::int64_t pow  = detail::pow10(tick.decimals);
+    std::string  frac = std::to_string(scaled % pow);
+
+    out += std::to_string(scaled / pow);
+    out.push_back('.');
+    out.append(tick.decimals - frac.size(), '0');
+    out += frac;
+    return out;
+}
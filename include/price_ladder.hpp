@@ -0,0 +1,280 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <level_iterator.hpp>
+#include <order.hpp>
+
+/**
+ * @brief Book side backed by a contiguous array of price levels; a drop-in
+ *        alternative to SideTree.
+ *        Covers `levelCount` prices starting at `basePrice`, `tickSize` apart;
+ *        a level is addressed directly by (price - base) / tick. Occupied levels
+ *        are tracked in a bitmap with a one-bit-per-word summary on top, so the
+ *        next best level after one empties is found with a couple of ctz/clz.
+ *        Orders priced off the ladder are refused (insert returns nullptr).
+ */
+template <typename NodeType>
+class PriceLadder {
+   public:
+    using node_type = NodeType;
+
+    NodeType* low        = nullptr;
+    NodeType* high       = nullptr;
+    size_t    orderCount = 0;
+
+    PriceLadder(Price basePrice, Price tickSize, size_t levelCount);
+
+    NodeType* insert(Order& order);
+    NodeType* remove(Order& order);
+    NodeType* remove(Order& order, NodeType* level);
+    NodeType* find(Price price);
+
+    // Same contract as SideTree::bulkLoad; levels are addressed directly, so
+    // this is just the inserts. Every price must be on the ladder.
+    void bulkLoad(std::span<Order* const> orders) {
+        for (Order* order : orders) insert(*order);
+    }
+
+    bool accepts(Price price) const { return contains(price); }
+
+    // Neighbouring occupied levels, found through the bitmap.
+    NodeType* above(const NodeType* level) const { return at(nextSet(indexOf(level) + 1)); }
+    NodeType* below(const NodeType* level) const {
+        size_t i = indexOf(level);
+        return i == 0 ? nullptr : at(prevSet(i - 1));
+    }
+
+    // Up to `limit` levels from the lowest or the highest price.
+    LevelRange<PriceLadder, false> ascending(size_t limit = SIZE_MAX) const {
+        return {{this, low, limit}};
+    }
+    LevelRange<PriceLadder, true> descending(size_t limit = SIZE_MAX) const {
+        return {{this, high, limit}};
+    }
+
+    void print();
+
+    // Visits up to `limit` levels in ascending price order.
+    template <typename Func>
+    void inorder(Func&& func, size_t limit) const;
+    // Hands every resting order to `release` and drops all levels.
+    void clear(std::function<void(Order*)> release);
+
+    size_t size() const { return orderCount; }
+    bool   empty() const { return orderCount == 0; }
+
+    void updateRange(NodeType* inserted);
+    void recomputeRange();
+
+    bool contains(Price price) const {
+        return price >= base && (price - base) % tick == 0 &&
+               static_cast<size_t>((price - base) / tick) < count;
+    }
+
+    Price  basePrice() const { return base; }
+    Price  tickSize() const { return tick; }
+    size_t levelCount() const { return count; }
+
+   private:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    size_t indexOf(Price price) const { return (price - base) / tick; }
+    size_t indexOf(const NodeType* level) const { return level - levels.get(); }
+
+    NodeType* at(size_t i) const { return i == NONE ? nullptr : &levels[i]; }
+
+    void   mark(size_t i);
+    void   unmark(size_t i);
+    size_t nextSet(size_t from) const;
+    size_t prevSet(size_t from) const;
+
+    Price  base;
+    Price  tick;
+    size_t count;
+
+    std::unique_ptr<NodeType[]> levels;
+    std::vector<uint64_t>       bits;     // one bit per level
+    std::vector<uint64_t>       summary;  // one bit per non-zero word of `bits`
+};
+
+template <typename NodeType>
+PriceLadder<NodeType>::PriceLadder(Price basePrice, Price tickSize, size_t levelCount)
+    : base(basePrice),
+      tick(tickSize > 0 ? tickSize : 1),
+      count(levelCount),
+      levels(new NodeType[levelCount]),
+      bits((levelCount + 63) / 64),
+      summary((bits.size() + 63) / 64) {
+    for (size_t i = 0; i < count; ++i) levels[i].price = base + i * tick;
+}
+
+template <typename NodeType>
+void PriceLadder<NodeType>::updateRange(NodeType* inserted) {
+    if (!low || inserted->price < low->price)
+        low = inserted;
+    if (!high || inserted->price > high->price)
+        high = inserted;
+}
+
+template <typename NodeType>
+void PriceLadder<NodeType>::mark(size_t i) {
+    size_t w = i >> 6;
+    bits[w] |= 1ULL << (i & 63);
+    summary[w >> 6] |= 1ULL << (w & 63);
+}
+
+template <typename NodeType>
+void PriceLadder<NodeType>::unmark(size_t i) {
+    size_t w = i >> 6;
+    bits[w] &= ~(1ULL << (i & 63));
+    if (!bits[w])
+        summary[w >> 6] &= ~(1ULL << (w & 63));
+}
+
+// First occupied level at or above `from`.
+template <typename NodeType>
+size_t PriceLadder<NodeType>::nextSet(size_t from) const {
+    if (from >= count)
+        return NONE;
+
+    size_t   w    = from >> 6;
+    uint64_t word = bits[w] & (~0ULL << (from & 63));
+    if (word)
+        return (w << 6) + std::countr_zero(word);
+
+    size_t s = (w + 1) >> 6;
+    if (s >= summary.size())
+        return NONE;
+    uint64_t sw = summary[s] & (~0ULL << ((w + 1) & 63));
+    while (true) {
+        if (sw) {
+            size_t wi = (s << 6) + std::countr_zero(sw);
+            return (wi << 6) + std::countr_zero(bits[wi]);
+        }
+        if (++s >= summary.size())
+            return NONE;
+        sw = summary[s];
+    }
+}
+
+// Last occupied level at or below `from`.
+template <typename NodeType>
+size_t PriceLadder<NodeType>::prevSet(size_t from) const {
+    if (count == 0)
+        return NONE;
+    if (from >= count)
+        from = count - 1;
+
+    size_t   w    = from >> 6;
+    uint64_t word = bits[w] & (~0ULL >> (63 - (from & 63)));
+    if (word)
+        return (w << 6) + 63 - std::countl_zero(word);
+    if (w == 0)
+        return NONE;
+
+    size_t   target = w - 1;
+    size_t   s      = target >> 6;
+    uint64_t sw     = summary[s] & (~0ULL >> (63 - (target & 63)));
+    while (true) {
+        if (sw) {
+            size_t wi = (s << 6) + 63 - std::countl_zero(sw);
+            return (wi << 6) + 63 - std::countl_zero(bits[wi]);
+        }
+        if (s == 0)
+            return NONE;
+        sw = summary[--s];
+    }
+}
+
+template <typename NodeType>
+NodeType* PriceLadder<NodeType>::insert(Order& order) {
+    if (!contains(order.price))
+        return nullptr;
+
+    size_t    i     = indexOf(order.price);
+    NodeType* level = &levels[i];
+    if (level->level.empty()) {
+        mark(i);
+        updateRange(level);
+    }
+
+    level->level.push_back(&order);
+    orderCount++;
+    return level;
+}
+
+template <typename NodeType>
+NodeType* PriceLadder<NodeType>::remove(Order& order) {
+    NodeType* found = find(order.price);
+
+    if (!found) {
+        return nullptr;
+    }
+
+    return remove(order, found);
+}
+
+template <typename NodeType>
+NodeType* PriceLadder<NodeType>::remove(Order& order, NodeType* level) {
+    level->level.erase(&order);
+    orderCount--;
+
+    if (level->level.empty()) {
+        size_t i = indexOf(level);
+        unmark(i);
+        if (level == low)
+            low = at(nextSet(i + 1));
+        if (level == high)
+            high = i == 0 ? nullptr : at(prevSet(i - 1));
+        return nullptr;
+    }
+
+    return level;
+}
+
+template <typename NodeType>
+NodeType* PriceLadder<NodeType>::find(Price price) {
+    if (!contains(price))
+        return nullptr;
+    NodeType* level = &levels[indexOf(price)];
+    return level->level.empty() ? nullptr : level;
+}
+
+template <typename NodeType>
+void PriceLadder<NodeType>::recomputeRange() {
+    low  = at(nextSet(0));
+    high = at(prevSet(count - 1));
+}
+
+template <typename NodeType>
+template <typename Func>
+void PriceLadder<NodeType>::inorder(Func&& func, size_t limit) const {
+    for (NodeType& level : ascending(limit)) func(&level);
+}
+
+template <typename NodeType>
+void PriceLadder<NodeType>::clear(std::function<void(Order*)> release) {
+    for (size_t i = nextSet(0); i != NONE; i = nextSet(i + 1)) {
+        while (Order* o = levels[i].level.pop_front()) release(o);
+        unmark(i);
+    }
+    low = high = nullptr;
+    orderCount = 0;
+}
+
+template <typename NodeType>
+void PriceLadder<NodeType>::print() {
+    inorder(
+            [](NodeType* node) {
+                std::cout << node->price << ": " << node->quantity() << " ("
+                          << node->orderCount() << ")\n";
+            },
+            SIZE_MAX);
+}
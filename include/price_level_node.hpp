@@ -1,22 +1,22 @@
 #pragma once
-#include <list>
-#include <order.hpp>
+#include <order_queue.hpp>
 
 struct PriceLevelNode {
-    double             price;
-    std::list<Order *> level;
+    Price      price;
+    OrderQueue level;
 
     uint64_t        height = 1;
     PriceLevelNode *left   = nullptr;
     PriceLevelNode *right  = nullptr;
+    PriceLevelNode *parent = nullptr;
 
-    void leanCopy(const PriceLevelNode *other) {
-        if (!other)
-            return;
-        price  = other->price;
-        level  = other->level;
-        height = other->height;
-    }
+    // neighbouring levels in price order (lower / higher)
+    PriceLevelNode *prev = nullptr;
+    PriceLevelNode *next = nullptr;
 
-    explicit PriceLevelNode(const uint64_t p) : price(p) {}
-};
\ No newline at end of file
+    size_t        orderCount() const { return level.size(); }
+    std::uint64_t quantity() const { return level.quantity(); }
+
+    PriceLevelNode() : price(0) {}
+    explicit PriceLevelNode(const Price p) : price(p) {}
+};
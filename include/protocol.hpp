@@ -0,0 +1,159 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "command.hpp"
+#include "order.hpp"
+
+/**
+ * @brief Text protocol as seen from both ends.
+ *        The server builds its order replies with these, and clients such as
+ *        the load generator build requests and read replies with them, so one
+ *        side cannot change a spelling without the other. Lines are '\n'
+ *        terminated; builders include the terminator, parseReply() takes a
+ *        line without it.
+ */
+namespace protocol {
+
+inline constexpr std::string_view OK_AUTH    = "OK AUTH\n";
+inline constexpr std::string_view SUBSCRIBED = "SUBSCRIEBED\n";  // sic; clients match on it
+
+inline std::string_view sideName(Side side) {
+    return side == Side::Buy ? "BUY" : "SELL";
+}
+
+inline std::string_view tifName(TimeInForce tif) {
+    switch (tif) {
+        case TimeInForce::IOC:
+            return "IOC";
+        case TimeInForce::FOK:
+            return "FOK";
+        default:
+            return "GTC";
+    }
+}
+
+// Requests.
+
+inline std::string auth(std::string_view passkey, std::string_view clientId) {
+    return std::string(commandName(Command::Auth)) + " " + std::string(passkey) + " " +
+           std::string(clientId) + "\n";
+}
+
+inline std::string subscribe(std::string_view group) {
+    return std::string(commandName(Command::Sub)) + " " + std::string(group) + "\n";
+}
+
+inline std::string newLimit(Side             side,
+                            std::string_view symbol,
+                            int              quantity,
+                            std::string_view price,
+                            TimeInForce      tif = TimeInForce::GTC) {
+    std::string out(commandName(Command::NewL));
+    out += " ";
+    out += sideName(side);
+    out += " ";
+    out += symbol;
+    out += " " + std::to_string(quantity) + " ";
+    out += price;
+    if (tif != TimeInForce::GTC) {
+        out += " ";
+        out += tifName(tif);
+    }
+    out += "\n";
+    return out;
+}
+
+inline std::string cancel(std::string_view symbol, OrderId id) {
+    return std::string(commandName(Command::Cancel)) + " " + std::string(symbol) + " " +
+           std::to_string(id) + "\n";
+}
+
+// Replies to order entry.
+
+inline std::string requestMade(OrderId id) {
+    return "REQUEST_MADE " + std::to_string(id) + "\n";
+}
+
+inline std::string cancelled(OrderId id) {
+    return "CANCELLED " + std::to_string(id) + "\n";
+}
+
+inline std::string amended(OrderId id) {
+    return "AMENDED " + std::to_string(id) + "\n";
+}
+
+inline std::string exec(std::string_view symbol, uint64_t quantity, std::string_view price) {
+    return "EXEC " + std::string(symbol) + " " + std::to_string(quantity) + "@" +
+           std::string(price) + "\n";
+}
+
+enum class ReplyKind : uint8_t {
+    RequestMade,
+    Cancelled,
+    Amended,
+    Exec,
+    Error,  // ERR <REASON>
+    Auth,   // OK AUTH
+    Subscribed,
+    Other,  // market data, snapshots, DEBUG output, usage text
+};
+
+// Views into the parsed line.
+struct Reply {
+    ReplyKind        kind     = ReplyKind::Other;
+    OrderId          id       = 0;  // RequestMade, Cancelled, Amended
+    std::string_view symbol;        // Exec
+    uint64_t         quantity = 0;  // Exec
+    std::string_view price;         // Exec, as formatted by the instrument
+    std::string_view error;         // Error: the reason, e.g. UNKNOWN_ORDER
+};
+
+inline Reply parseReply(std::string_view line) {
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+
+    Reply  r;
+    size_t sp   = line.find(' ');
+    auto   verb = line.substr(0, sp);
+    auto   rest = sp == std::string_view::npos ? std::string_view{} : line.substr(sp + 1);
+
+    auto withId = [&](ReplyKind kind) {
+        if (parseOrderId(rest, r.id))
+            r.kind = kind;
+        return r;
+    };
+    if (verb == "REQUEST_MADE")
+        return withId(ReplyKind::RequestMade);
+    if (verb == "CANCELLED")
+        return withId(ReplyKind::Cancelled);
+    if (verb == "AMENDED")
+        return withId(ReplyKind::Amended);
+    if (verb == "ERR") {
+        r.kind  = ReplyKind::Error;
+        r.error = rest.substr(0, rest.find(' '));
+        return r;
+    }
+    if (verb == "EXEC") {
+        size_t gap = rest.find(' ');
+        size_t at  = rest.find('@');
+        if (gap == std::string_view::npos || at == std::string_view::npos || at < gap)
+            return r;
+        uint64_t qty = 0;
+        if (!parseOrderId(rest.substr(gap + 1, at - gap - 1), qty))
+            return r;
+        r.kind     = ReplyKind::Exec;
+        r.symbol   = rest.substr(0, gap);
+        r.quantity = qty;
+        r.price    = rest.substr(at + 1);
+        return r;
+    }
+    if (line == OK_AUTH.substr(0, OK_AUTH.size() - 1))
+        r.kind = ReplyKind::Auth;
+    else if (line == SUBSCRIBED.substr(0, SUBSCRIBED.size() - 1))
+        r.kind = ReplyKind::Subscribed;
+    return r;
+}
+
+}  // namespace protocol
@@ -0,0 +1,189 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "price.hpp"
+#include "utils/flat_map.hpp"
+
+/**
+ * @brief Pre-trade checks run before an order reaches the book.
+ *        Everything a check needs is kept up to date as orders rest, trade
+ *        and leave, so screening an order is one lookup of the client's
+ *        counters and a few integer comparisons, never a walk over the
+ *        client's orders.
+ */
+namespace risk {
+
+enum class Verdict : uint8_t {
+    Pass,
+    PriceBand,     // priced too far from the last trade
+    OrderSize,     // more than one order may carry
+    OpenQuantity,  // would leave the client with too much resting
+    OpenNotional,  // would leave the client with too much value resting
+};
+
+// Per-instrument limits; 0 switches a limit off.
+struct Limits {
+    uint32_t bandBps     = 0;  // allowed distance from the last trade, in basis points
+    uint64_t maxOrderQty = 0;
+    uint64_t maxOpenQty  = 0;  // resting quantity per client
+    uint64_t maxNotional = 0;  // resting price x quantity per client, in ticks
+
+    bool tracksExposure() const noexcept { return maxOpenQty != 0 || maxNotional != 0; }
+};
+
+// What a client has resting in one book.
+struct Exposure {
+    uint64_t quantity = 0;
+    uint64_t notional = 0;  // ticks x quantity
+};
+
+// Price x quantity, saturating rather than wrapping on absurd inputs.
+inline uint64_t notional(uint64_t quantity, Price price) noexcept {
+    uint64_t out;
+    if (price <= 0)
+        return 0;
+    if (__builtin_mul_overflow(quantity, static_cast<uint64_t>(price), &out))
+        return UINT64_MAX;
+    return out;
+}
+
+// True if `price` is within `bps` of `reference`. Without a reference (no
+// trade yet) or a band, any price is.
+inline bool withinBand(Price price, Price reference, uint32_t bps) noexcept {
+    if (bps == 0 || reference <= 0)
+        return true;
+    __int128 distance = price > reference ? price - reference : reference - price;
+    return distance * 10000 <= static_cast<__int128>(reference) * bps;
+}
+
+/**
+ * @brief Limits and per-client exposure of one instrument. Lives on the
+ *        engine owning the instrument, so it is only touched by that thread.
+ *        Exposure counts resting orders only: what an order trades on
+ *        arrival never rests, and what rests is released again when it
+ *        trades, is cancelled or is amended.
+ */
+class Checker {
+   public:
+    Checker() = default;
+    explicit Checker(const Limits &l) : limits(l) {}
+
+    const Limits &getLimits() const noexcept { return limits; }
+
+    Exposure exposure(std::string_view client) const {
+        auto it = clients.find(client);
+        return it == clients.end() ? Exposure{} : it->second;
+    }
+
+    // Screens an order of `quantity` at `price` (0 for a market order, which
+    // skips the price checks) for a client holding `held`. `rests` says
+    // whether the order may enter the book and so count against the open
+    // limits.
+    Verdict check(const Exposure &held,
+                  uint64_t        quantity,
+                  Price           price,
+                  Price           reference,
+                  bool            rests) const noexcept {
+        if (limits.maxOrderQty && quantity > limits.maxOrderQty)
+            return Verdict::OrderSize;
+        if (price > 0 && !withinBand(price, reference, limits.bandBps))
+            return Verdict::PriceBand;
+        if (!rests)
+            return Verdict::Pass;
+        if (limits.maxOpenQty && held.quantity + quantity > limits.maxOpenQty)
+            return Verdict::OpenQuantity;
+        uint64_t value = notional(quantity, price);
+        if (limits.maxNotional &&
+            (value > limits.maxNotional || held.notional > limits.maxNotional - value))
+            return Verdict::OpenNotional;
+        return Verdict::Pass;
+    }
+
+    // The same for `client`'s current exposure, less `replaces` when the
+    // order takes the place of one already resting (an amend).
+    Verdict check(std::string_view client,
+                  uint64_t         quantity,
+                  Price            price,
+                  Price            reference,
+                  bool             rests,
+                  const Exposure  &replaces = {}) const {
+        Exposure held;
+        if (rests && limits.tracksExposure()) {
+            held = exposure(client);
+            held.quantity -= std::min(held.quantity, replaces.quantity);
+            held.notional -= std::min(held.notional, replaces.notional);
+        }
+        return check(held, quantity, price, reference, rests);
+    }
+
+    void add(std::string_view client, uint64_t quantity, Price price) {
+        if (!limits.tracksExposure())
+            return;
+        auto it = clients.find(client);
+        if (it == clients.end())
+            it = clients.emplace(std::string(client), Exposure{}).first;
+        it->second.quantity += quantity;
+        it->second.notional += notional(quantity, price);
+    }
+
+    void remove(std::string_view client, uint64_t quantity, Price price) {
+        if (!limits.tracksExposure())
+            return;
+        auto it = clients.find(client);
+        if (it == clients.end())
+            return;
+        uint64_t value       = notional(quantity, price);
+        it->second.quantity -= std::min(it->second.quantity, quantity);
+        it->second.notional -= std::min(it->second.notional, value);
+    }
+
+   private:
+    Limits                                limits;
+    utils::FlatMap<std::string, Exposure> clients;
+};
+
+/**
+ * @brief Token bucket limiting how many messages a session may send: `rate`
+ *        per second on average, up to `burst` back to back. A rate of 0 lets
+ *        everything through. Tokens are kept in nanosecond units, so refills
+ *        are exact integer arithmetic.
+ */
+class Throttle {
+   public:
+    Throttle() = default;
+    Throttle(uint32_t rate, uint32_t burst)
+        : per_second(rate), capacity(uint64_t{burst} * NS), tokens(capacity) {}
+
+    // Takes `cost` tokens if there are that many at `now`.
+    bool admit(std::chrono::steady_clock::time_point now, uint32_t cost = 1) noexcept {
+        if (per_second == 0)
+            return true;
+        int64_t at = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch())
+                             .count();
+        if (at > last) {
+            // capped before multiplying, so a long silence cannot overflow
+            uint64_t elapsed = std::min<uint64_t>(at - last, capacity / per_second + 1);
+            tokens           = std::min(capacity, tokens + elapsed * per_second);
+            last             = at;
+        }
+        uint64_t need = uint64_t{cost} * NS;
+        if (tokens < need)
+            return false;
+        tokens -= need;
+        return true;
+    }
+
+   private:
+    static constexpr uint64_t NS = 1'000'000'000;
+
+    uint64_t per_second = 0;
+    uint64_t capacity   = 0;
+    uint64_t tokens     = 0;
+    int64_t  last       = 0;  // ns of the last refill
+};
+
+}  // namespace risk
@@ -2,13 +2,17 @@
 
 #include <avl_tree.hpp>
 #include <functional>
+#include <level_iterator.hpp>
 #include <price_level_node.hpp>
+#include <span>
 #include <string>
 #include <vector>
 
 template <typename NodeType>
 class SideTree {
    public:
+    using node_type = NodeType;
+
     AVLTree<NodeType> avl;
     NodeType*         root;
     NodeType*         low;
@@ -18,20 +22,46 @@ class SideTree {
 
     explicit SideTree() : root(nullptr), low(nullptr), high(nullptr), orderCount(0) {}
 
-    virtual ~SideTree() = default;
+    // Draw price level nodes from the owner's pool.
+    void setNodePool(utils::ObjectPool<NodeType>* nodePool) { avl.pool = nodePool; }
+
+    NodeType*           insert(Order& order);
+    NodeType*           remove(Order& order);
+    NodeType*           remove(Order& order, NodeType* level);
+    NodeType*           find(Price price);
+
+    // Fills an empty side from orders sorted by price, oldest first within a
+    // price: one node per level and a tree built in O(n), not n inserts.
+    void bulkLoad(std::span<Order* const> orders);
+
+    // Any price can rest in a tree.
+    bool accepts(Price) const { return true; }
 
-    virtual NodeType*           insert(Order& order);
-    virtual NodeType*           remove(Order& order);
-    virtual NodeType*           find(const int& price);
-    virtual std::vector<Order*> top(int length = 1) const;
+    // Neighbouring occupied levels, straight off the threaded links.
+    NodeType* above(const NodeType* level) const { return level->next; }
+    NodeType* below(const NodeType* level) const { return level->prev; }
+
+    // Up to `limit` levels from the lowest or the highest price.
+    LevelRange<SideTree, false> ascending(size_t limit = SIZE_MAX) const {
+        return {{this, low, limit}};
+    }
+    LevelRange<SideTree, true> descending(size_t limit = SIZE_MAX) const {
+        return {{this, high, limit}};
+    }
 
-    virtual void print();
+    void print();
+
+    // Visits up to `limit` levels in ascending price order.
+    template <typename Func>
+    void inorder(Func&& func, size_t limit) const;
+    // Hands every resting order to `release` and drops all levels.
+    void clear(std::function<void(Order*)> release);
 
     size_t size() const { return orderCount; }
     bool   empty() const { return orderCount == 0; }
 
-    virtual void updateRange(NodeType* inserted);
-    virtual void recomputeRange(NodeType* root);
+    void updateRange(NodeType* inserted);
+    void recomputeRange(NodeType* root);
 };
 
 template <typename NodeType>
@@ -49,56 +79,67 @@ void SideTree<NodeType>::recomputeRange(NodeType* root) {
 }
 
 template <typename NodeType>
-NodeType* SideTree<NodeType>::insert(Order& order) {
-    uint64_t price = order.price;
+void SideTree<NodeType>::bulkLoad(std::span<Order* const> orders) {
+    std::vector<NodeType*> levels;
+    for (Order* order : orders) {
+        if (levels.empty() || levels.back()->price != order->price)
+            levels.push_back(avl.createNode(order->price));
+        levels.back()->level.push_back(order);
+    }
 
-    if (!root) {
-        root = new NodeType(price);
-        orderCount++;
-        order.level_posn = root->level.insert(root->level.end(), &order);
-        updateRange(root);
+    root       = avl.build(levels.data(), levels.size());
+    low        = levels.empty() ? nullptr : levels.front();
+    high       = levels.empty() ? nullptr : levels.back();
+    orderCount = orders.size();
+}
 
-        return root;
-    }
+template <typename NodeType>
+NodeType* SideTree<NodeType>::insert(Order& order) {
+    Price price = order.price;
 
     NodeType* found = find(price);
-    if (found) {
-        order.level_posn = found->level.insert(found->level.end(), &order);
-        return found;
+    if (!found) {
+        root = avl.insert(root, price, found);
+        updateRange(found);
     }
 
-    NodeType* inserted = nullptr;
-    NodeType* newRoot  = avl.insert(root, price, inserted);
-    root               = newRoot;
-
-    order.level_posn = inserted->level.insert(inserted->level.end(), &order);
-    updateRange(inserted);
-    return inserted;
+    found->level.push_back(&order);
+    orderCount++;
+    return found;
 }
 
 template <typename NodeType>
 NodeType* SideTree<NodeType>::remove(Order& order) {
-    int       price = order.price;
-    NodeType* found = find(price);
+    NodeType* found = find(order.price);
 
     if (!found) {
         return nullptr;
     }
 
-    found->level.erase(order.level_posn);
+    return remove(order, found);
+}
+
+// Removes an order from the level it is known to rest at. An emptied level is
+// unlinked from the tree directly and the best prices step to its neighbours.
+template <typename NodeType>
+NodeType* SideTree<NodeType>::remove(Order& order, NodeType* level) {
+    level->level.erase(&order);
     orderCount--;
 
-    if (found->level.empty()) {
-        root = avl.remove(root, price);
-        std::cout << "Price Level Removed\n";
+    if (level->level.empty()) {
+        if (level == low)
+            low = level->next;
+        if (level == high)
+            high = level->prev;
+        root = avl.removeNode(root, level);
         return nullptr;
     }
 
-    return found;
+    return level;
 }
 
 template <typename NodeType>
-NodeType* SideTree<NodeType>::find(const int& price) {
+NodeType* SideTree<NodeType>::find(Price price) {
     if (!root)
         return nullptr;
 
@@ -123,6 +164,21 @@ void SideTree<NodeType>::print() {
 }
 
 template <typename NodeType>
-std::vector<Order*> SideTree<NodeType>::top(int length) const {
-    return {};
+template <typename Func>
+void SideTree<NodeType>::inorder(Func&& func, size_t limit) const {
+    for (NodeType& level : ascending(limit)) func(&level);
+}
+
+template <typename NodeType>
+void SideTree<NodeType>::clear(std::function<void(Order*)> release) {
+    avl.inorder(
+            root,
+            [&](NodeType* node) {
+                while (Order* o = node->level.pop_front()) release(o);
+            },
+            SIZE_MAX);
+    avl.freeTree(root);
+    root = low = high = nullptr;
+    orderCount        = 0;
 }
+
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+
+#include "journal.hpp"
+
+class Instrument;
+
+/**
+ * @brief Point-in-time image of one instrument, so recovery does not have to
+ *        replay a whole day of journal.
+ *        A snapshot holds the trade state (last trade, OHLC, VWAP), the id
+ *        sequence and every resting order, and records the journal position
+ *        it was taken at; recovery loads it and replays only later records.
+ *
+ *        The layout is columnar: a fixed header, then per side the level
+ *        prices and order counts, then the order fields one column at a time
+ *        (ids, remaining, filled, arrival, time in force, client), then the
+ *        client id table. Orders are stored by ascending price and FIFO within
+ *        a price, so loading is one pass that builds each side in O(n).
+ *        Files are written to a temporary name, synced and renamed, and the
+ *        directory is synced after, so a crash leaves either the old snapshot
+ *        or the new one.
+ */
+namespace snapshot {
+
+// <dir>/<symbol>.snapshot
+std::string pathFor(const std::string &dir, const std::string &symbol);
+
+// Saves `instrument` as of journal position `at`. Returns false on an I/O
+// error, leaving any previous snapshot in place unless only the final sync of
+// the directory failed.
+bool write(const Instrument &instrument, const journal::Position &at, const std::string &path);
+
+// Restores an instrument that has no orders yet and sets `at` to the position
+// the snapshot was taken at. The file is checked in full before anything is
+// changed; a damaged or foreign snapshot returns false and leaves the
+// instrument as it was.
+bool load(Instrument &instrument, const std::string &path, journal::Position &at);
+
+}  // namespace snapshot
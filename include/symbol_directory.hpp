@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/flat_map.hpp"
+
+// Dense index of an instrument, assigned in the order symbols are interned.
+using SymbolId = uint32_t;
+
+constexpr SymbolId NO_SYMBOL = UINT32_MAX;
+
+/**
+ * @brief Interns symbols to dense ids. A symbol is hashed once, when it comes
+ *        off the wire. Everything keyed by instrument behind that is a vector
+ *        indexed by the id. Ids are never reused or removed, so a table sized
+ *        once stays valid.
+ */
+class SymbolDirectory {
+   public:
+    // The id of `symbol`, assigning the next one if it is new.
+    SymbolId intern(std::string_view symbol) {
+        auto [it, added] = ids.emplace(std::string(symbol), static_cast<SymbolId>(names.size()));
+        if (added)
+            names.emplace_back(symbol);
+        return it->second;
+    }
+
+    SymbolId find(std::string_view symbol) const noexcept {
+        auto it = ids.find(symbol);
+        return it == ids.end() ? NO_SYMBOL : it->second;
+    }
+
+    const std::string &name(SymbolId id) const { return names[id]; }
+    size_t             size() const noexcept { return names.size(); }
+
+   private:
+    utils::FlatMap<std::string, SymbolId> ids;
+    std::vector<std::string>              names;  // by id
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace utils {
+
+// FNV-1a over `len` bytes; pass the previous result as `h` to continue over
+// several buffers. Catches torn and corrupted writes, nothing adversarial.
+inline uint32_t fnv1a(const void *data, size_t len, uint32_t h = 2166136261u) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < len; ++i) h = (h ^ bytes[i]) * 16777619u;
+    return h;
+}
+
+}  // namespace utils
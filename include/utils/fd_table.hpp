@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @brief Per-connection state indexed by file descriptor.
+ *        The kernel hands out the lowest free fd, so descriptors stay dense
+ *        and a plain vector indexed by fd beats any hash or tree: a lookup is
+ *        a bounds check and a load. `T` is a nullable handle (shared_ptr,
+ *        pointer); an empty handle marks a free slot.
+ */
+template <typename T>
+class FdTable {
+   public:
+    size_t size() const noexcept { return count; }
+    bool   empty() const noexcept { return count == 0; }
+
+    // The entry for `fd`, or nullptr if there is none.
+    T *find(int fd) {
+        if (fd < 0 || static_cast<size_t>(fd) >= slots.size() || !slots[fd])
+            return nullptr;
+        return &slots[fd];
+    }
+
+    void insert(int fd, T value) {
+        if (static_cast<size_t>(fd) >= slots.size())
+            slots.resize(static_cast<size_t>(fd) + 1);
+        if (!slots[fd])
+            ++count;
+        slots[fd] = std::move(value);
+    }
+
+    void erase(int fd) {
+        if (T *slot = find(fd)) {
+            *slot = T{};
+            --count;
+        }
+    }
+
+    // Calls f(fd, entry) for every entry, in fd order.
+    template <typename F>
+    void forEach(F &&f) {
+        for (size_t fd = 0; fd < slots.size(); ++fd)
+            if (slots[fd])
+                f(static_cast<int>(fd), slots[fd]);
+    }
+
+    void clear() {
+        slots.clear();
+        count = 0;
+    }
+
+   private:
+    std::vector<T> slots;
+    size_t         count = 0;
+};
+
+}  // namespace utils
@@ -0,0 +1,229 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+// Strings hash through their view, so lookups by string_view or literal
+// never build a temporary std::string.
+template <typename K>
+struct FlatHash : std::hash<K> {};
+
+template <>
+struct FlatHash<std::string> {
+    size_t operator()(std::string_view s) const noexcept {
+        return std::hash<std::string_view>{}(s);
+    }
+};
+
+/**
+ * @brief Hash map with open addressing and linear probing.
+ *        Entries live in one flat array, next to an array of their hashes, so
+ *        a lookup is one multiply and a short scan of adjacent slots instead
+ *        of a walk through separately allocated nodes. Hashes are spread with
+ *        a Fibonacci multiply, so dense keys such as order ids are fine.
+ *        Deletion shifts the following entries back (no tombstones), which
+ *        keeps probe sequences short under churn. Any insert or erase may move
+ *        entries and invalidates iterators and references.
+ */
+template <typename K, typename V, typename Hash = FlatHash<K>, typename Eq = std::equal_to<>>
+class FlatMap {
+   public:
+    using value_type = std::pair<K, V>;
+
+    template <bool Const>
+    class Iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = FlatMap::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using Map               = std::conditional_t<Const, const FlatMap, FlatMap>;
+        using reference         = std::conditional_t<Const, const value_type &, value_type &>;
+        using pointer           = std::conditional_t<Const, const value_type *, value_type *>;
+
+        Iterator() = default;
+        Iterator(Map *m, size_t i) : map(m), index(i) { skip(); }
+
+        reference operator*() const { return map->slots[index]; }
+        pointer   operator->() const { return &map->slots[index]; }
+
+        Iterator &operator++() {
+            ++index;
+            skip();
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+        bool operator==(const Iterator &other) const { return index == other.index; }
+
+       private:
+        friend class FlatMap;
+
+        void skip() {
+            while (index < map->hashes.size() && map->hashes[index] == EMPTY) ++index;
+        }
+
+        Map   *map   = nullptr;
+        size_t index = 0;
+    };
+
+    using iterator       = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit FlatMap(size_t capacity = MIN_CAPACITY) { rehash(capacityFor(capacity)); }
+
+    size_t size() const noexcept { return count; }
+    bool   empty() const noexcept { return count == 0; }
+
+    iterator       begin() { return iterator(this, 0); }
+    iterator       end() { return iterator(this, hashes.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, hashes.size()); }
+
+    template <typename Q>
+    iterator find(const Q &key) {
+        return iterator(this, locate(key, hashOf(key)));
+    }
+    template <typename Q>
+    const_iterator find(const Q &key) const {
+        return const_iterator(this, locate(key, hashOf(key)));
+    }
+    template <typename Q>
+    bool contains(const Q &key) const {
+        return locate(key, hashOf(key)) != hashes.size();
+    }
+
+    // Inserts if the key is new; the bool tells which happened.
+    std::pair<iterator, bool> emplace(K key, V value) {
+        uint64_t h = hashOf(key);
+        size_t   i = locate(key, h);
+        if (i != hashes.size())
+            return {iterator(this, i), false};
+
+        if ((count + 1) * 4 > hashes.size() * 3)
+            rehash(hashes.size() * 2);
+        i         = place(h);
+        slots[i]  = value_type(std::move(key), std::move(value));
+        hashes[i] = h;
+        ++count;
+        return {iterator(this, i), true};
+    }
+
+    V &operator[](const K &key) { return emplace(key, V{}).first->second; }
+
+    void erase(iterator it) { eraseAt(it.index); }
+
+    template <typename Q>
+    size_t erase(const Q &key) {
+        size_t i = locate(key, hashOf(key));
+        if (i == hashes.size())
+            return 0;
+        eraseAt(i);
+        return 1;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < hashes.size(); ++i) {
+            if (hashes[i] != EMPTY) {
+                slots[i]  = value_type{};
+                hashes[i] = EMPTY;
+            }
+        }
+        count = 0;
+    }
+
+    void reserve(size_t n) {
+        size_t want = capacityFor(n);
+        if (want > hashes.size())
+            rehash(want);
+    }
+
+   private:
+    static constexpr uint64_t EMPTY        = 0;
+    static constexpr size_t   MIN_CAPACITY = 16;
+
+    // at most 3/4 full
+    static size_t capacityFor(size_t n) {
+        size_t cap = MIN_CAPACITY;
+        while (n * 4 > cap * 3) cap *= 2;
+        return cap;
+    }
+
+    // Fibonacci hashing: the high bits of the product are well mixed and pick
+    // the slot. The full value is kept to skip most key compares and to rehash
+    // without hashing the keys again.
+    template <typename Q>
+    static uint64_t hashOf(const Q &key) {
+        return (static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull) | 1;  // never EMPTY
+    }
+
+    size_t home(uint64_t h) const { return static_cast<size_t>(h >> shift); }
+
+    template <typename Q>
+    size_t locate(const Q &key, uint64_t h) const {
+        for (size_t i = home(h);; i = (i + 1) & mask) {
+            if (hashes[i] == EMPTY)
+                return hashes.size();
+            if (hashes[i] == h && Eq{}(slots[i].first, key))
+                return i;
+        }
+    }
+
+    size_t place(uint64_t h) const {
+        size_t i = home(h);
+        while (hashes[i] != EMPTY) i = (i + 1) & mask;
+        return i;
+    }
+
+    void eraseAt(size_t i) {
+        // pull later entries of the same probe run back over the hole
+        for (size_t j = (i + 1) & mask; hashes[j] != EMPTY; j = (j + 1) & mask) {
+            size_t h     = home(hashes[j]);
+            bool   stays = i <= j ? (i < h && h <= j) : (i < h || h <= j);
+            if (stays)
+                continue;
+            slots[i]  = std::move(slots[j]);
+            hashes[i] = hashes[j];
+            i         = j;
+        }
+        slots[i]  = value_type{};
+        hashes[i] = EMPTY;
+        --count;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<value_type> oldSlots  = std::move(slots);
+        std::vector<uint64_t>   oldHashes = std::move(hashes);
+
+        slots.assign(capacity, value_type{});
+        hashes.assign(capacity, EMPTY);
+        mask  = capacity - 1;
+        shift = 64 - std::countr_zero(capacity);
+
+        for (size_t k = 0; k < oldHashes.size(); ++k) {
+            if (oldHashes[k] == EMPTY)
+                continue;
+            size_t i  = place(oldHashes[k]);
+            slots[i]  = std::move(oldSlots[k]);
+            hashes[i] = oldHashes[k];
+        }
+    }
+
+    std::vector<value_type> slots;
+    std::vector<uint64_t>   hashes;
+    size_t                  count = 0;
+    size_t                  mask  = 0;
+    int                     shift = 0;
+};
+
+}  // namespace utils
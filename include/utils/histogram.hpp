@@ -0,0 +1,116 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace utils {
+
+/**
+ * @brief Log-linear (HDR-style) histogram of unsigned values.
+ *        Every power of two is split into 2^SUB_BITS equal buckets, so a
+ *        recorded value is known to within 1/32 of itself from 1 up to 2^40,
+ *        in a fixed 9 KB and with O(1) recording: one bit scan and a shift.
+ *        Larger values land in the last bucket.
+ *        One thread records; any thread may read at the same time. Counters are
+ *        relaxed atomics written with plain load/store pairs, which costs the
+ *        writer nothing over ordinary integers, and a reader sees each counter
+ *        whole (but not necessarily all of them from the same instant).
+ */
+class Histogram {
+   public:
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr unsigned MAX_BITS = 40;
+    static constexpr size_t   SUB      = size_t(1) << SUB_BITS;
+    static constexpr size_t   BUCKETS  = (MAX_BITS - SUB_BITS + 1) * SUB;
+
+    Histogram() = default;
+
+    Histogram(const Histogram &)            = delete;
+    Histogram &operator=(const Histogram &) = delete;
+
+    // Writer thread only.
+    void record(uint64_t value) noexcept {
+        bump(counts[bucketOf(value)], 1);
+        bump(total, 1);
+        bump(sum, value);
+        if (value > max_.load(std::memory_order_relaxed))
+            max_.store(value, std::memory_order_relaxed);
+        if (value < min_.load(std::memory_order_relaxed))
+            min_.store(value, std::memory_order_relaxed);
+    }
+
+    // Adds everything `other` has recorded so far. The caller must be the only
+    // writer of this histogram (typically a local one collecting several).
+    void add(const Histogram &other) noexcept {
+        for (size_t i = 0; i < BUCKETS; ++i)
+            bump(counts[i], other.counts[i].load(std::memory_order_relaxed));
+        bump(total, other.count());
+        bump(sum, other.sum.load(std::memory_order_relaxed));
+        if (other.max() > max())
+            max_.store(other.max(), std::memory_order_relaxed);
+        if (other.count() > 0 && other.min() < min_.load(std::memory_order_relaxed))
+            min_.store(other.min(), std::memory_order_relaxed);
+    }
+
+    uint64_t count() const noexcept { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const noexcept { return max_.load(std::memory_order_relaxed); }
+    uint64_t min() const noexcept {
+        return count() == 0 ? 0 : min_.load(std::memory_order_relaxed);
+    }
+    double mean() const noexcept {
+        uint64_t n = count();
+        return n == 0 ? 0.0 : static_cast<double>(sum.load(std::memory_order_relaxed)) / n;
+    }
+
+    // Smallest value v such that at least `p` percent of the recorded values
+    // are <= v, rounded up to the top of its bucket and capped at max().
+    uint64_t percentile(double p) const noexcept {
+        uint64_t n = count();
+        if (n == 0)
+            return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(n) + 0.5);
+        rank          = rank < 1 ? 1 : (rank > n ? n : rank);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return std::min(highestIn(i), max());
+        }
+        return max();
+    }
+
+    static size_t bucketOf(uint64_t value) noexcept {
+        if (value >= (uint64_t(1) << MAX_BITS))
+            return BUCKETS - 1;
+        if (value < SUB)
+            return static_cast<size_t>(value);
+        unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - SUB_BITS;
+        return shift * SUB + static_cast<size_t>(value >> shift);
+    }
+
+    static uint64_t lowestIn(size_t bucket) noexcept {
+        if (bucket < SUB)
+            return bucket;
+        size_t shift = bucket / SUB - 1;
+        return (uint64_t(bucket % SUB) + SUB) << shift;
+    }
+
+    static uint64_t highestIn(size_t bucket) noexcept { return lowestIn(bucket + 1) - 1; }
+
+   private:
+    static void bump(std::atomic<uint64_t> &c, uint64_t by) noexcept {
+        c.store(c.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> counts{};
+    std::atomic<uint64_t>                      total{0};
+    std::atomic<uint64_t>                      sum{0};
+    std::atomic<uint64_t>                      max_{0};
+    std::atomic<uint64_t>                      min_{UINT64_MAX};
+};
+
+}  // namespace utils
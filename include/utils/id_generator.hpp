@@ -1,15 +1,25 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
-#include <string>
 
 namespace utils {
 /**
- * @brief Thread‑safe generator for pseudo‑random 64‑bit IDs.
- *        Collision probability is negligible for most back‑testing
- *        or intraday real‑time workloads.
+ * @brief Monotonic 64-bit ID sequence.
+ *        Each owner (e.g. an Instrument) keeps its own sequence, so IDs are
+ *        dense, ordered by creation and never collide within that owner.
+ *        next() is a single relaxed fetch_add and safe to call from any thread.
  */
 class IdGenerator {
    public:
-    static std::string next();
+    explicit IdGenerator(uint64_t start = 1) : seq(start) {}
+
+    uint64_t next() noexcept { return seq.fetch_add(1, std::memory_order_relaxed); }
+
+    // The id next() will hand out; restore() continues a saved sequence.
+    uint64_t peek() const noexcept { return seq.load(std::memory_order_relaxed); }
+    void     restore(uint64_t start) noexcept { seq.store(start, std::memory_order_relaxed); }
+
+   private:
+    std::atomic<uint64_t> seq;
 };
 }  // namespace utils
@@ -0,0 +1,120 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @brief Fixed-size block allocator.
+ *        Blocks are carved out of slabs which are only returned to the system
+ *        when the pool is destroyed. Released blocks are pushed on an intrusive
+ *        free list and handed out again before a new slab is requested, so a
+ *        warmed up pool never touches the global heap.
+ *        Not thread-safe: each pool has a single owner (e.g. an Instrument).
+ */
+class SlabPool {
+   public:
+    explicit SlabPool(std::size_t blockSize, std::size_t blocksPerSlab = 1024)
+        : block_size(roundUp(std::max(blockSize, sizeof(FreeBlock)))),
+          blocks_per_slab(std::max<std::size_t>(blocksPerSlab, 1)) {}
+
+    SlabPool(const SlabPool &)            = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+
+    void *allocate() {
+        if (!free_list)
+            grow();
+        FreeBlock *block = free_list;
+        free_list        = block->next;
+        ++in_use;
+        return block;
+    }
+
+    void deallocate(void *p) noexcept {
+        if (!p)
+            return;
+        auto *block = static_cast<FreeBlock *>(p);
+        block->next = free_list;
+        free_list   = block;
+        --in_use;
+    }
+
+    // Make sure at least `blocks` allocations can be served without growing.
+    void reserve(std::size_t blocks) {
+        while (capacity() - in_use < blocks) grow();
+    }
+
+    std::size_t blockSize() const noexcept { return block_size; }
+    std::size_t capacity() const noexcept { return slabs.size() * blocks_per_slab; }
+    std::size_t inUse() const noexcept { return in_use; }
+
+   private:
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    static constexpr std::size_t ALIGNMENT = alignof(std::max_align_t);
+
+    static std::size_t roundUp(std::size_t n) { return (n + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+
+    void grow() {
+        slabs.emplace_back(new std::byte[block_size * blocks_per_slab]);
+        std::byte *base = slabs.back().get();
+
+        // thread the new slab onto the free list back to front so blocks are
+        // handed out in address order
+        for (std::size_t i = blocks_per_slab; i-- > 0;) {
+            auto *block = reinterpret_cast<FreeBlock *>(base + i * block_size);
+            block->next = free_list;
+            free_list   = block;
+        }
+    }
+
+    std::size_t                               block_size;
+    std::size_t                               blocks_per_slab;
+    std::size_t                               in_use    = 0;
+    FreeBlock                                *free_list = nullptr;
+    std::vector<std::unique_ptr<std::byte[]>> slabs;
+};
+
+/**
+ * @brief Typed front end over SlabPool: constructs objects in recycled blocks.
+ */
+template <typename T>
+class ObjectPool {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+
+   public:
+    explicit ObjectPool(std::size_t objectsPerSlab = 1024) : slab(sizeof(T), objectsPerSlab) {}
+
+    template <typename... Args>
+    T *create(Args &&...args) {
+        void *p = slab.allocate();
+        try {
+            return new (p) T(std::forward<Args>(args)...);
+        } catch (...) {
+            slab.deallocate(p);
+            throw;
+        }
+    }
+
+    void destroy(T *obj) noexcept {
+        if (!obj)
+            return;
+        obj->~T();
+        slab.deallocate(obj);
+    }
+
+    void        reserve(std::size_t n) { slab.reserve(n); }
+    std::size_t capacity() const noexcept { return slab.capacity(); }
+    std::size_t inUse() const noexcept { return slab.inUse(); }
+
+   private:
+    SlabPool slab;
+};
+
+}  // namespace utils
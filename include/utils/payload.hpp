@@ -0,0 +1,19 @@
+#pragma once
+#include <memory>
+#include <string>
+
+namespace utils {
+
+/**
+ * @brief Immutable, reference-counted message bytes.
+ *        A broadcast is encoded once into a Payload and every recipient's
+ *        output queue holds a reference to it instead of a copy. The count is
+ *        atomic, so an engine can hand the same payload to several reactors.
+ */
+using Payload = std::shared_ptr<const std::string>;
+
+inline Payload makePayload(std::string bytes) {
+    return std::make_shared<const std::string>(std::move(bytes));
+}
+
+}  // namespace utils
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace utils {
+
+/**
+ * @brief Bounded lock-free ring for exactly one producer and one consumer thread.
+ *        Capacity is rounded up to a power of two. Each side keeps a private copy
+ *        of the other side's index and only re-reads the shared one when the ring
+ *        looks full (producer) or empty (consumer), so a steady stream costs no
+ *        cache-line ping-pong per element.
+ */
+template <typename T>
+class SpscRing {
+   public:
+    explicit SpscRing(std::size_t capacity)
+        : mask(roundUp(capacity) - 1), slots(new T[mask + 1]) {}
+
+    SpscRing(const SpscRing &)            = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer side. Leaves `value` untouched and returns false if the ring is full.
+    bool tryPush(T &&value) {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head > mask) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head > mask)
+                return false;
+        }
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the ring is empty.
+    bool tryPop(T &out) {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail)
+                return false;
+        }
+        out = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Exact only when called from one of the two owning threads.
+    bool empty() const noexcept {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const noexcept { return mask + 1; }
+
+   private:
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    static std::size_t roundUp(std::size_t n) {
+        std::size_t p = 2;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    const std::size_t    mask;
+    std::unique_ptr<T[]> slots;
+
+    // consumer-owned
+    alignas(CACHE_LINE) std::atomic<std::size_t> head{0};
+    std::size_t cached_tail = 0;
+
+    // producer-owned
+    alignas(CACHE_LINE) std::atomic<std::size_t> tail{0};
+    std::size_t cached_head = 0;
+};
+
+}  // namespace utils
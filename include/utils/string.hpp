@@ -1,4 +1,7 @@
 #pragma once
+#include <algorithm>
+#include <chrono>
+#include <ctime>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -0,0 +1,172 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @brief Hierarchical timing wheel: O(1) schedule and cancel, and advancing
+ *        costs only the timers that expire plus one slot visit per tick.
+ *        Time is in caller-chosen ticks. Level 0 has one slot per tick for
+ *        the next 64 ticks, and each higher level has slots 64 times as wide.
+ *        When the clock enters a wider slot, that slot's timers are moved to
+ *        the levels below, so each timer is moved at most LEVELS - 1 times.
+ *        Deadlines more than 64^LEVELS ticks away are parked in the top level
+ *        and placed again each time they come around.
+ *        Not thread-safe: one wheel belongs to one thread.
+ */
+template <typename T>
+class TimerWheel {
+   public:
+    // Names a scheduled timer. Cancelling a timer that fired or was already
+    // cancelled is a harmless no-op, even after its node has been reused.
+    struct Handle {
+        uint32_t index      = NIL;
+        uint32_t generation = 0;
+    };
+
+    static constexpr size_t   SLOT_BITS = 6;
+    static constexpr size_t   SLOTS     = size_t{1} << SLOT_BITS;
+    static constexpr size_t   LEVELS    = 4;
+    static constexpr uint64_t SPAN      = uint64_t{1} << (SLOT_BITS * LEVELS);
+
+    explicit TimerWheel(uint64_t now = 0) : current(now) {
+        for (auto &level : heads) level.fill(NIL);
+    }
+
+    uint64_t now() const noexcept { return current; }
+    size_t   size() const noexcept { return count; }
+    bool     empty() const noexcept { return count == 0; }
+
+    // Fires `value` on the first advance() to `at` or later. A deadline that
+    // is not in the future fires on the next tick.
+    Handle schedule(uint64_t at, T value) {
+        uint32_t i;
+        if (free_list != NIL) {
+            i         = free_list;
+            free_list = nodes[i].next;
+        } else {
+            i = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+        }
+        Node &n  = nodes[i];
+        n.value  = std::move(value);
+        n.at     = std::max(at, current + 1);
+        n.linked = true;
+        link(i);
+        ++count;
+        return Handle{i, n.generation};
+    }
+
+    // Returns false if the timer already fired or was cancelled.
+    bool cancel(Handle h) {
+        if (h.index >= nodes.size() || nodes[h.index].generation != h.generation ||
+            !nodes[h.index].linked)
+            return false;
+        unlink(h.index);
+        release(h.index);
+        return true;
+    }
+
+    // Moves the clock to `to`, calling fire(value) for every timer that is
+    // due, tick by tick. fire may schedule and cancel timers.
+    template <typename F>
+    void advance(uint64_t to, F &&fire) {
+        while (current < to) {
+            if (count == 0) {
+                current = to;
+                return;
+            }
+            ++current;
+            for (size_t level = 1; level < LEVELS; ++level) {
+                if ((current >> (SLOT_BITS * (level - 1))) & (SLOTS - 1))
+                    break;
+                cascade(level);
+            }
+            uint32_t &head = heads[0][current & (SLOTS - 1)];
+            while (head != NIL) {
+                uint32_t i = head;
+                unlink(i);
+                T value = std::move(nodes[i].value);
+                release(i);
+                fire(value);
+            }
+        }
+    }
+
+   private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Node {
+        T        value{};
+        uint64_t at         = 0;
+        uint32_t prev       = NIL;
+        uint32_t next       = NIL;  // next free node while on the free list
+        uint32_t generation = 0;
+        uint8_t  level      = 0;
+        uint8_t  slot       = 0;
+        bool     linked     = false;
+    };
+
+    uint64_t                                        current;
+    size_t                                          count     = 0;
+    uint32_t                                        free_list = NIL;
+    std::vector<Node>                               nodes;
+    std::array<std::array<uint32_t, SLOTS>, LEVELS> heads;  // first node of each slot
+
+    // The slot `at` belongs to as seen from `current`. A deadline equal to
+    // `current` only happens while cascading and lands in the slot about to fire.
+    void link(uint32_t i) {
+        Node    &n     = nodes[i];
+        uint64_t at    = std::min(n.at, current + SPAN - 1);
+        uint64_t delta = at - current;
+        size_t   level = 0;
+        while (level + 1 < LEVELS && delta >= (uint64_t{1} << (SLOT_BITS * (level + 1)))) ++level;
+        n.level = static_cast<uint8_t>(level);
+        n.slot  = static_cast<uint8_t>((at >> (SLOT_BITS * level)) & (SLOTS - 1));
+
+        uint32_t &head = heads[level][n.slot];
+        n.prev         = NIL;
+        n.next         = head;
+        if (head != NIL)
+            nodes[head].prev = i;
+        head = i;
+    }
+
+    void unlink(uint32_t i) {
+        Node &n = nodes[i];
+        if (n.prev != NIL)
+            nodes[n.prev].next = n.next;
+        else
+            heads[n.level][n.slot] = n.next;
+        if (n.next != NIL)
+            nodes[n.next].prev = n.prev;
+    }
+
+    void release(uint32_t i) {
+        Node &n = nodes[i];
+        n.value  = T{};
+        n.linked = false;
+        ++n.generation;
+        n.next    = free_list;
+        free_list = i;
+        --count;
+    }
+
+    // The clock entered this level's current slot: spread its timers below.
+    void cascade(size_t level) {
+        uint32_t &head = heads[level][(current >> (SLOT_BITS * level)) & (SLOTS - 1)];
+        uint32_t  i    = std::exchange(head, NIL);
+        while (i != NIL) {
+            uint32_t next = nodes[i].next;
+            link(i);
+            i = next;
+        }
+    }
+};
+
+}  // namespace utils
@@ -0,0 +1,53 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace utils {
+
+/**
+ * @brief Cheap timestamps for latency measurement.
+ *        On x86 this reads the time stamp counter: a handful of cycles and no
+ *        system call, constant rate and in step across cores on any CPU with an
+ *        invariant TSC. Elsewhere it falls back to the steady clock in ns.
+ *        Ticks are only meant to be subtracted from each other; ticksToNs()
+ *        turns a difference into time.
+ */
+inline uint64_t tsc() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+#endif
+}
+
+// Nanoseconds per tick, measured against the steady clock on first use
+// (which takes about 10 ms).
+inline double nsPerTick() {
+    static const double ratio = [] {
+#if defined(__x86_64__) || defined(__i386__)
+        using clock = std::chrono::steady_clock;
+        auto     t0 = clock::now();
+        uint64_t c0 = tsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        uint64_t c1 = tsc();
+        auto     ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0);
+        return c1 > c0 ? static_cast<double>(ns.count()) / static_cast<double>(c1 - c0) : 1.0;
+#else
+        return 1.0;
+#endif
+    }();
+    return ratio;
+}
+
+inline double ticksToNs(uint64_t ticks) {
+    return static_cast<double>(ticks) * nsPerTick();
+}
+
+}  // namespace utils
@@ -0,0 +1,227 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "order.hpp"
+
+/**
+ * @brief Binary order-entry protocol, offered next to the text protocol.
+ *        A session switches with the text command `BINARY`; every byte after
+ *        that line is a frame. Frames are packed, little-endian structs that
+ *        start with a Header whose `length` covers the whole frame. Prices are
+ *        integer ticks of the instrument, symbols are NUL-padded to 8 bytes.
+ *        Text the server has no binary form for (market data, SEND) reaches a
+ *        binary session wrapped in a Text frame.
+ */
+namespace wire {
+
+static_assert(std::endian::native == std::endian::little, "frames are memcpy'd as is");
+
+enum class MsgType : uint8_t {
+    // client -> server
+    NewOrder = 0x01,
+    Cancel   = 0x02,
+    Batch    = 0x03,
+    Amend    = 0x04,
+    // server -> client
+    Ack      = 0x81,
+    Exec     = 0x82,
+    Reject   = 0x83,
+    Text     = 0x84,
+    BatchAck = 0x85,
+};
+
+enum class AckKind : uint8_t { New = 1, Cancelled = 2, Amended = 3 };
+
+enum class RejectReason : uint8_t {
+    Unauthorized = 1,
+    BadMessage   = 2,
+    BadSymbol    = 3,
+    BadSide      = 4,
+    BadQty       = 5,
+    BadPrice     = 6,
+    UnknownOrder = 7,
+    Busy         = 8,
+    NoLiquidity  = 9,   // FOK or market order that could not trade
+    PriceBand    = 10,  // pre-trade risk: too far from the last trade
+    OrderSize    = 11,  // pre-trade risk: order larger than allowed
+    OpenQuantity = 12,  // pre-trade risk: too much quantity resting
+    OpenNotional = 13,  // pre-trade risk: too much value resting
+    Throttled    = 14,  // sending faster than the session's rate limit
+    Journal      = 15,  // the engine's journal failed, so nothing more can be recorded
+};
+
+constexpr size_t SYMBOL_LEN = 8;
+constexpr size_t BATCH_MAX  = 256;  // orders per batch
+
+#pragma pack(push, 1)
+struct Header {
+    uint16_t length;
+    MsgType  type;
+};
+
+struct NewOrder {
+    Header   hdr;
+    char     symbol[SYMBOL_LEN];
+    uint8_t  side;  // 0 buy, 1 sell
+    uint32_t quantity;
+    int64_t  price;        // ignored for market orders
+    uint8_t  type;         // 0 limit, 1 market
+    uint8_t  timeInForce;  // 0 GTC, 1 IOC, 2 FOK
+};
+
+struct Cancel {
+    Header   hdr;
+    char     symbol[SYMBOL_LEN];
+    uint64_t orderId;
+};
+
+// Cancel-replace of a resting order; price 0 keeps the current price.
+struct Amend {
+    Header   hdr;
+    char     symbol[SYMBOL_LEN];
+    uint64_t orderId;
+    uint32_t quantity;  // new open quantity
+    int64_t  price;
+};
+
+struct Ack {
+    Header   hdr;
+    AckKind  kind;
+    uint64_t orderId;
+};
+
+struct Exec {
+    Header   hdr;
+    char     symbol[SYMBOL_LEN];
+    uint64_t orderId;
+    uint32_t quantity;
+    int64_t  price;
+};
+
+struct Reject {
+    Header       hdr;
+    RejectReason reason;
+};
+
+// Many orders for one symbol: a BatchHeader followed by `count` entries.
+struct BatchHeader {
+    Header   hdr;
+    char     symbol[SYMBOL_LEN];
+    uint16_t count;
+};
+
+struct BatchEntry {
+    uint8_t  side;         // 0 buy, 1 sell
+    uint8_t  type;         // 0 limit, 1 market
+    uint8_t  timeInForce;  // 0 GTC, 1 IOC, 2 FOK
+    uint32_t quantity;
+    int64_t  price;
+};
+
+// One answer per batch. The orders were numbered firstOrderId, firstOrderId + 1, ...
+// in batch order; `rejected` BatchRejects follow for the ones that did not make it.
+struct BatchAck {
+    Header   hdr;
+    char     symbol[SYMBOL_LEN];
+    uint64_t firstOrderId;
+    uint16_t count;
+    uint16_t rejected;
+};
+
+struct BatchReject {
+    uint16_t     index;
+    RejectReason reason;
+};
+#pragma pack(pop)
+
+// Largest frame a client may send; anything longer is a protocol error.
+constexpr size_t MAX_INBOUND = std::max({sizeof(NewOrder),
+                                         sizeof(Cancel),
+                                         sizeof(Amend),
+                                         sizeof(BatchHeader) + BATCH_MAX * sizeof(BatchEntry)});
+
+inline std::string_view symbolOf(const char (&symbol)[SYMBOL_LEN]) {
+    return std::string_view(symbol, strnlen(symbol, SYMBOL_LEN));
+}
+
+inline void setSymbol(char (&dst)[SYMBOL_LEN], std::string_view symbol) {
+    std::memset(dst, 0, SYMBOL_LEN);
+    std::memcpy(dst, symbol.data(), std::min(symbol.size(), SYMBOL_LEN));
+}
+
+// Appends `msg` to `out` with its header filled in.
+template <typename Msg>
+void append(std::string &out, Msg msg, MsgType type) {
+    msg.hdr = Header{sizeof(Msg), type};
+    out.append(reinterpret_cast<const char *>(&msg), sizeof(Msg));
+}
+
+template <typename Msg>
+std::string encode(Msg msg, MsgType type) {
+    std::string out;
+    append(out, msg, type);
+    return out;
+}
+
+inline std::string ack(AckKind kind, OrderId id) {
+    Ack m{};
+    m.kind    = kind;
+    m.orderId = id;
+    return encode(m, MsgType::Ack);
+}
+
+inline std::string reject(RejectReason reason) {
+    Reject m{};
+    m.reason = reason;
+    return encode(m, MsgType::Reject);
+}
+
+inline std::string exec(std::string_view symbol, OrderId id, uint64_t qty, Price price) {
+    Exec m{};
+    setSymbol(m.symbol, symbol);
+    m.orderId  = id;
+    m.quantity = static_cast<uint32_t>(qty);
+    m.price    = price;
+    return encode(m, MsgType::Exec);
+}
+
+inline std::string batchAck(std::string_view                symbol,
+                            OrderId                         first,
+                            size_t                          count,
+                            const std::vector<BatchReject> &rejected) {
+    BatchAck m{};
+    setSymbol(m.symbol, symbol);
+    m.firstOrderId = first;
+    m.count        = static_cast<uint16_t>(count);
+    m.rejected     = static_cast<uint16_t>(rejected.size());
+
+    std::string out;
+    append(out, m, MsgType::BatchAck);
+    out.append(reinterpret_cast<const char *>(rejected.data()),
+               rejected.size() * sizeof(BatchReject));
+    // the header covers the whole frame, rejects included
+    uint16_t length = static_cast<uint16_t>(out.size());
+    std::memcpy(out.data(), &length, sizeof(length));
+    return out;
+}
+
+// Frames free-form text for a binary session, split if it exceeds one frame.
+inline void appendText(std::string &out, std::string_view text) {
+    constexpr size_t CHUNK = UINT16_MAX - sizeof(Header);
+    do {
+        size_t n = std::min(text.size(), CHUNK);
+        Header h{static_cast<uint16_t>(sizeof(Header) + n), MsgType::Text};
+        out.append(reinterpret_cast<const char *>(&h), sizeof(h));
+        out.append(text.data(), n);
+        text.remove_prefix(n);
+    } while (!text.empty());
+}
+
+}  // namespace wire
@@ -0,0 +1,331 @@
+#include "backtest.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "command.hpp"
+#include "instrument.hpp"
+#include "journal.hpp"
+#include "utils/flat_map.hpp"
+
+namespace backtest {
+
+namespace {
+
+constexpr size_t FIELDS = 9;
+
+// Finds the stream of `symbol`, adding it on first sight.
+class StreamIndex {
+   public:
+    explicit StreamIndex(std::vector<Stream> &streams) : streams(streams) {}
+
+    Stream &get(std::string_view symbol) {
+        auto it = index.find(symbol);
+        if (it != index.end())
+            return streams[it->second];
+        index.emplace(std::string(symbol), streams.size());
+        streams.push_back(Stream{std::string(symbol), {}});
+        return streams.back();
+    }
+
+   private:
+    std::vector<Stream>                &streams;
+    utils::FlatMap<std::string, size_t> index;
+};
+
+// Collects the trades of one replay. Executions come in pairs, buyer first.
+class Recorder final : public InstrumentListener {
+   public:
+    Recorder(Result &result, const utils::FlatMap<OrderId, uint64_t> &refs, bool log)
+        : result(result), refs(refs), log(log) {}
+
+    int64_t now = 0;
+
+    void notifyUser(const std::string &, std::string) override {}
+    void notifyGroup(const std::string &, std::string) override {}
+    void notifyConflated(const Instrument &, const std::string &, std::string) override {}
+
+    void notifyExecution(const Instrument &instrument, const Execution &execution) override {
+        auto     it  = refs.find(execution.orderId);
+        uint64_t ref = it == refs.end() ? 0 : it->second;
+        if (!seller) {
+            buyer  = ref;
+            seller = true;
+            return;
+        }
+        seller = false;
+        ++result.fills;
+        if (!log)
+            return;
+        result.fillLog += std::to_string(now) + "," + instrument.getSymbol() + "," +
+                          std::to_string(buyer) + "," + std::to_string(ref) + "," +
+                          instrument.formatPrice(execution.price) + "," +
+                          std::to_string(execution.quantity) + "\n";
+    }
+
+   private:
+    Result                                  &result;
+    const utils::FlatMap<OrderId, uint64_t> &refs;
+    bool                                     log;
+    uint64_t                                 buyer  = 0;
+    bool                                     seller = false;  // the next execution is the sell side
+};
+
+bool parseInt(std::string_view tok, int64_t &out) {
+    auto [p, ec] = std::from_chars(tok.data(), tok.data() + tok.size(), out);
+    return ec == std::errc() && p == tok.data() + tok.size();
+}
+
+}  // namespace
+
+bool parseCsvLine(std::string_view line,
+                  const TickSize  &tick,
+                  std::string     &symbol,
+                  Event           &event,
+                  std::string     &error) {
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+
+    std::array<std::string_view, FIELDS> f{};
+    size_t                               n = 0;
+    for (size_t start = 0;;) {
+        size_t comma = line.find(',', start);
+        if (n == FIELDS) {
+            error = "too many fields";
+            return false;
+        }
+        f[n++] = line.substr(start, comma - start);
+        if (comma == std::string_view::npos)
+            break;
+        start = comma + 1;
+    }
+    if (n < 5) {
+        error = "expected timestamp,symbol,action,ref,client";
+        return false;
+    }
+
+    Event ev;
+    if (!parseInt(f[0], ev.timestamp)) {
+        error = "bad timestamp";
+        return false;
+    }
+    if (f[1].empty()) {
+        error = "missing symbol";
+        return false;
+    }
+    if (f[2] == "NEWL")
+        ev.action = Action::NewLimit;
+    else if (f[2] == "NEWM")
+        ev.action = Action::NewMarket;
+    else if (f[2] == "CANCEL")
+        ev.action = Action::Cancel;
+    else if (f[2] == "AMEND")
+        ev.action = Action::Amend;
+    else {
+        error = "unknown action";
+        return false;
+    }
+    if (!parseOrderId(f[3], ev.ref)) {
+        error = "bad ref";
+        return false;
+    }
+    if (f[4].empty()) {
+        error = "missing client";
+        return false;
+    }
+    if (f[4].size() > ClientId::CAPACITY) {
+        error = "client id too long";
+        return false;
+    }
+    ev.clientId = std::string(f[4]);
+
+    bool isNew = ev.action == Action::NewLimit || ev.action == Action::NewMarket;
+    if (isNew && !parseSide(f[5], ev.side)) {
+        error = "bad side";
+        return false;
+    }
+    bool hasPrice = ev.action == Action::NewLimit || (ev.action == Action::Amend && !f[6].empty());
+    if (hasPrice && (!::parsePrice(f[6], tick, ev.price) || ev.price <= 0)) {
+        error = "bad price";
+        return false;
+    }
+    if (ev.action != Action::Cancel && !parseQuantity(f[7], ev.quantity)) {
+        error = "bad quantity";
+        return false;
+    }
+    if (!f[8].empty() && !parseTimeInForce(f[8], ev.tif)) {
+        error = "bad time in force";
+        return false;
+    }
+
+    symbol = std::string(f[1]);
+    event  = std::move(ev);
+    return true;
+}
+
+bool loadCsv(const std::string   &path,
+             const TickSize      &tick,
+             std::vector<Stream> &streams,
+             std::string         &error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    StreamIndex index(streams);
+    std::string line, symbol, why;
+    Event       ev;
+    for (size_t lineNo = 1; std::getline(in, line); ++lineNo) {
+        if (line.empty() || line[0] == '#' || line.starts_with("timestamp") || line == "\r")
+            continue;
+        if (!parseCsvLine(line, tick, symbol, ev, why)) {
+            error = path + ":" + std::to_string(lineNo) + ": " + why;
+            return false;
+        }
+        index.get(symbol).events.push_back(std::move(ev));
+    }
+    return true;
+}
+
+bool loadJournal(const std::string &dir, std::vector<Stream> &streams, std::string &error) {
+    StreamIndex index(streams);
+    auto        visit = [&](const journal::Position &, const journal::Record &r) {
+        if (r.kind == journal::RecordKind::Fill)
+            return;
+
+        Stream &stream = index.get(journal::field(r.symbol, journal::SYMBOL_LEN));
+        Event   ev;
+        ev.timestamp = stream.events.empty() ? 0 : stream.events.back().timestamp;
+        ev.ref       = r.orderId;
+        ev.clientId  = std::string(journal::field(r.clientId, journal::CLIENT_ID_LEN));
+        ev.price     = r.price;
+        ev.quantity  = static_cast<int>(r.quantity);
+        switch (r.kind) {
+            case journal::RecordKind::New:
+                ev.action    = r.type == 1 ? Action::NewMarket : Action::NewLimit;
+                ev.timestamp = static_cast<int64_t>(r.timestamp);
+                ev.side      = r.side == 0 ? Side::Buy : Side::Sell;
+                ev.tif       = static_cast<TimeInForce>(r.timeInForce);
+                break;
+            case journal::RecordKind::Cancel:
+                ev.action = Action::Cancel;
+                break;
+            default:
+                ev.action = Action::Amend;
+                break;
+        }
+        stream.events.push_back(std::move(ev));
+    };
+    if (journal::read(dir, visit) == 0) {
+        error = "no journal records in " + dir;
+        return false;
+    }
+    return true;
+}
+
+Result run(const Stream &stream, const TickSize &tick, const BookSpec &book, bool logFills) {
+    Result result;
+    result.symbol = stream.symbol;
+    result.events = stream.events.size();
+
+    auto instrument = makeInstrument(
+            InstrumentSpec{.symbol = stream.symbol, .tick = tick, .book = book});
+
+    utils::FlatMap<uint64_t, OrderId> ids;   // source ref -> id in this replay
+    utils::FlatMap<OrderId, uint64_t> refs;  // and back, for the fill log
+    ids.reserve(stream.events.size());
+    refs.reserve(stream.events.size());
+
+    Recorder recorder(result, refs, logFills);
+    instrument->setListener(&recorder);
+
+    for (const Event &ev : stream.events) {
+        recorder.now = ev.timestamp;
+        instrument->setSimulatedTime(std::chrono::system_clock::time_point(
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                        std::chrono::nanoseconds(ev.timestamp))));
+
+        switch (ev.action) {
+            case Action::NewLimit:
+            case Action::NewMarket: {
+                OrderType type =
+                        ev.action == Action::NewMarket ? OrderType::Market : OrderType::Limit;
+                Order *order = instrument->createOrder(OrderRequest{
+                        ev.clientId, stream.symbol, ev.side, type, ev.price, ev.quantity, ev.tif});
+                order->setArrivalFromNs(static_cast<uint64_t>(ev.timestamp));
+                ids[ev.ref]      = order->getId();
+                refs[order->id]  = ev.ref;
+                Placement placed = instrument->placeOrder(*order);
+                if (placed == Placement::Refused || placed == Placement::Killed)
+                    ++result.refused;
+                break;
+            }
+            case Action::Cancel: {
+                auto it = ids.find(ev.ref);
+                if (it == ids.end() || !instrument->cancelOrder(it->second, ev.clientId))
+                    ++result.refused;
+                break;
+            }
+            case Action::Amend: {
+                auto it = ids.find(ev.ref);
+                if (it == ids.end()) {
+                    ++result.refused;
+                    break;
+                }
+                Price price = ev.price;
+                if (price == 0) {
+                    Order *order = instrument->findOrder(it->second);
+                    price        = order ? order->price : 0;
+                }
+                Amendment done = instrument->amendOrder(
+                        it->second, ev.clientId, static_cast<uint64_t>(ev.quantity), price);
+                if (done == Amendment::Unknown || done == Amendment::Refused)
+                    ++result.refused;
+                break;
+            }
+        }
+    }
+
+    result.volume = instrument->getVolumeToday();
+    result.vwap   = instrument->getVWAP();
+    result.open   = instrument->getOpen();
+    result.high   = instrument->getHigh();
+    result.low    = instrument->getLow();
+    result.close  = instrument->getClose();
+    instrument->forEachLevel(Side::Buy, [&](PriceLevelNode *) { ++result.bidLevels; }, SIZE_MAX);
+    instrument->forEachLevel(Side::Sell, [&](PriceLevelNode *) { ++result.askLevels; }, SIZE_MAX);
+    result.restingOrders = instrument->getOrderMap().size();
+
+    instrument->setListener(nullptr);
+    return result;
+}
+
+std::vector<Result> runAll(const std::vector<Stream> &streams,
+                           const TickSize            &tick,
+                           const BookSpec            &book,
+                           size_t                     threads,
+                           bool                       logFills) {
+    std::vector<Result> results(streams.size());
+    std::atomic<size_t> next{0};
+
+    // symbols are handed out one at a time, so a long stream does not hold up a whole share
+    auto worker = [&] {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < streams.size();)
+            results[i] = run(streams[i], tick, book, logFills);
+    };
+
+    threads = std::clamp<size_t>(threads, 1, std::max<size_t>(streams.size(), 1));
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool) t.join();
+    return results;
+}
+
+}  // namespace backtest
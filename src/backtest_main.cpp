@@ -0,0 +1,80 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "backtest.hpp"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <events.csv|journal_dir> [avl|ladder] [threads] [fills.csv]\n";
+        return 1;
+    }
+    std::string input = argv[1];
+
+    // quoted in cents, as the server's instruments are
+    TickSize tick{2, 1};
+    BookSpec book{};
+    if (argc >= 3 && std::string(argv[2]) == "ladder") {
+        book.type      = BookType::Ladder;
+        book.basePrice = 1;
+        book.levels    = 1 << 16;
+    }
+    size_t threads =
+            argc >= 4 ? std::stoul(argv[3]) : std::max(std::thread::hardware_concurrency(), 1u);
+    std::string fillsPath = argc >= 5 ? argv[4] : "";
+
+    std::vector<backtest::Stream> streams;
+    std::string                   error;
+    bool                          loaded = std::filesystem::is_directory(input)
+                                                   ? backtest::loadJournal(input, streams, error)
+                                                   : backtest::loadCsv(input, tick, streams, error);
+    if (!loaded) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    auto start   = std::chrono::steady_clock::now();
+    auto results = backtest::runAll(streams, tick, book, threads, !fillsPath.empty());
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t events = 0;
+    for (auto& r : results) {
+        events += r.events;
+        std::printf("%-8s events=%zu refused=%zu trades=%zu volume=%llu vwap=%.4f "
+                    "ohlc=%s/%s/%s/%s book=%zu/%zu levels, %zu orders\n",
+                    r.symbol.c_str(),
+                    r.events,
+                    r.refused,
+                    r.fills,
+                    static_cast<unsigned long long>(r.volume),
+                    r.vwap * tick.units / detail::pow10(tick.decimals),
+                    formatPrice(r.open, tick).c_str(),
+                    formatPrice(r.high, tick).c_str(),
+                    formatPrice(r.low, tick).c_str(),
+                    formatPrice(r.close, tick).c_str(),
+                    r.bidLevels,
+                    r.askLevels,
+                    r.restingOrders);
+    }
+    std::printf("Replayed %zu events of %zu symbols in %.3f s (%.0f events/s)\n",
+                events,
+                results.size(),
+                elapsed,
+                elapsed > 0 ? events / elapsed : 0.0);
+
+    if (!fillsPath.empty()) {
+        std::ofstream out(fillsPath);
+        out << "timestamp_ns,symbol,buy_ref,sell_ref,price,quantity\n";
+        for (auto& r : results) out << r.fillLog;
+        if (!out) {
+            std::cerr << "cannot write " << fillsPath << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "config.hpp"
+
+#include <charconv>
+#include <fstream>
+#include <unordered_set>
+
+#include "journal.hpp"
+#include "utils/string.hpp"
+#include "wire.hpp"
+
+namespace config {
+
+namespace {
+
+std::vector<std::string_view> words(std::string_view line) {
+    std::vector<std::string_view> out;
+    for (size_t pos = 0; pos < line.size();) {
+        size_t start = line.find_first_not_of(" \t\r", pos);
+        if (start == std::string_view::npos)
+            break;
+        size_t end = std::min(line.find_first_of(" \t\r", start), line.size());
+        out.push_back(line.substr(start, end - start));
+        pos = end;
+    }
+    return out;
+}
+
+template <typename T>
+bool parseNumber(std::string_view tok, T &out) {
+    auto [p, ec] = std::from_chars(tok.data(), tok.data() + tok.size(), out);
+    return ec == std::errc() && p == tok.data() + tok.size();
+}
+
+// "0.05" is two decimals in units of five.
+bool parseTick(std::string_view text, TickSize &tick) {
+    size_t   dot      = text.find('.');
+    uint32_t decimals = dot == std::string_view::npos ? 0 : uint32_t(text.size() - dot - 1);
+    Price    units    = 0;
+    if (decimals > 9 || !parsePrice(text, TickSize{decimals, 1}, units) || units <= 0)
+        return false;
+    tick = TickSize{decimals, units};
+    return true;
+}
+
+}  // namespace
+
+bool parseInstrument(std::string_view line, InstrumentSpec &spec, std::string &error) {
+    auto parts = words(line.substr(0, line.find('#')));
+    if (parts.empty()) {
+        error = "missing symbol";
+        return false;
+    }
+    // the binary protocol and the journal carry symbols in fixed fields
+    if (parts[0].size() > std::min(wire::SYMBOL_LEN, journal::SYMBOL_LEN) ||
+        parts[0].find('=') != std::string_view::npos) {
+        error = "bad symbol: " + std::string(parts[0]);
+        return false;
+    }
+
+    spec        = InstrumentSpec{};
+    spec.symbol = std::string(parts[0]);
+    to_upper(spec.symbol);  // the text protocol upper-cases symbols before looking them up
+
+    bool             hasTick = false;
+    std::string_view base;      // prices depend on the tick, which may come later on the line
+    std::string_view notional;
+    for (size_t i = 1; i < parts.size(); ++i) {
+        size_t eq = parts[i].find('=');
+        if (eq == std::string_view::npos) {
+            error = "expected key=value: " + std::string(parts[i]);
+            return false;
+        }
+        std::string_view key = parts[i].substr(0, eq), value = parts[i].substr(eq + 1);
+        bool             ok  = true;
+        if (key == "tick")
+            ok = hasTick = parseTick(value, spec.tick);
+        else if (key == "book") {
+            ok             = value == "avl" || value == "ladder";
+            spec.book.type = value == "ladder" ? BookType::Ladder : BookType::AVL;
+        } else if (key == "base")
+            base = value;
+        else if (key == "levels")
+            ok = parseNumber(value, spec.book.levels) && spec.book.levels > 0;
+        else if (key == "band_bps")
+            ok = parseNumber(value, spec.limits.bandBps);
+        else if (key == "max_qty")
+            ok = parseNumber(value, spec.limits.maxOrderQty);
+        else if (key == "max_open_qty")
+            ok = parseNumber(value, spec.limits.maxOpenQty);
+        else if (key == "max_notional")
+            notional = value;
+        else if (key == "engine")
+            ok = parseNumber(value, spec.engine);
+        else {
+            error = "unknown key: " + std::string(key);
+            return false;
+        }
+        if (!ok) {
+            error = "bad value for " + std::string(key) + ": " + std::string(value);
+            return false;
+        }
+    }
+    if (!hasTick) {
+        error = "missing tick";
+        return false;
+    }
+
+    if (spec.book.type == BookType::Ladder) {
+        spec.book.basePrice = 1;
+        if (!base.empty() && (!parsePrice(base, spec.tick, spec.book.basePrice) ||
+                              spec.book.basePrice <= 0)) {
+            error = "bad value for base: " + std::string(base);
+            return false;
+        }
+        if (spec.book.levels == 0)
+            spec.book.levels = 1 << 16;
+    }
+
+    Price maxNotional = 0;
+    if (!notional.empty() && (!parsePrice(notional, spec.tick, maxNotional) || maxNotional <= 0)) {
+        error = "bad value for max_notional: " + std::string(notional);
+        return false;
+    }
+    spec.limits.maxNotional = static_cast<uint64_t>(maxNotional);
+    return true;
+}
+
+bool loadInstruments(const std::string           &path,
+                     std::vector<InstrumentSpec> &specs,
+                     std::string                 &error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::unordered_set<std::string> seen;
+    std::string                     line;
+    for (size_t number = 1; std::getline(in, line); ++number) {
+        if (words(line.substr(0, line.find('#'))).empty())
+            continue;
+        InstrumentSpec spec;
+        std::string    why;
+        if (!parseInstrument(line, spec, why)) {
+            error = path + ":" + std::to_string(number) + ": " + why;
+            return false;
+        }
+        if (!seen.insert(spec.symbol).second) {
+            error = path + ":" + std::to_string(number) + ": " + spec.symbol + " defined twice";
+            return false;
+        }
+        specs.push_back(std::move(spec));
+    }
+    return true;
+}
+
+}  // namespace config
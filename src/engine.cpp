@@ -0,0 +1,559 @@
+#include "engine.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "logger.hpp"
+#include "protocol.hpp"
+
+Engine::Engine(std::vector<int> wakeFds, std::chrono::microseconds mdInterval, size_t ringCapacity)
+    : md_interval(mdInterval) {
+    for (int fd : wakeFds) links.push_back(std::make_unique<Link>(fd, ringCapacity));
+}
+
+Engine::~Engine() {
+    stop();
+}
+
+void Engine::start() {
+    if (running.exchange(true))
+        return;
+    thread = std::thread(&Engine::run, this);
+}
+
+void Engine::stop() {
+    running.store(false);
+    parked.store(false);
+    parked.notify_one();
+    if (thread.joinable())
+        thread.join();
+    if (wal) {
+        wal->commit();
+        releaseStaged();
+        takeSnapshots(true);
+    }
+}
+
+bool Engine::submit(size_t reactor, EngineCommand &&cmd) {
+    cmd.replyTo.reactor = reactor;
+    cmd.queued          = utils::tsc();
+    if (!links[reactor]->inbound.tryPush(std::move(cmd)))
+        return false;
+
+    // pairs with the fence in run(): either the engine sees the command or we see it parked
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked.load(std::memory_order_relaxed)) {
+        parked.store(false, std::memory_order_relaxed);
+        parked.notify_one();
+    }
+    return true;
+}
+
+bool Engine::idle() const {
+    for (auto &link : links)
+        if (!link->inbound.empty())
+            return false;
+    return true;
+}
+
+void Engine::run() {
+    EngineCommand cmd;
+    int           spins = 0;
+    int           burst = 0;
+
+    while (running.load(std::memory_order_relaxed)) {
+        // one command per reactor per pass keeps a busy reactor from starving the others
+        bool worked = false;
+        for (auto &link : links) {
+            if (link->inbound.tryPop(cmd)) {
+                uint64_t start = utils::tsc();
+                stats.record(Stage::Dispatch, cmd.queued, start);
+                execute(cmd);
+                stats.record(Stage::Match, start, utils::tsc());
+                worked = true;
+            }
+        }
+        if (worked && ++burst < MAX_BURST) {
+            spins = 0;
+            continue;
+        }
+        burst = 0;
+
+        // one market data update and one wake-up per burst of commands rather than one per event
+        publishMarketData();
+        // group commit: the burst is durable before any of its replies can be seen
+        if (wal) {
+            wal->commit();
+            releaseStaged();
+        }
+        for (auto &link : links)
+            if (link->pending_wake)
+                wake(*link);
+        if (wal)
+            takeSnapshots(false);
+
+        if (worked) {
+            spins = 0;
+            continue;
+        }
+        if (!md_dirty.empty()) {
+            // held back by md_interval; parking now would delay it until the next command
+            std::this_thread::yield();
+            continue;
+        }
+        if (++spins < SPIN_LIMIT)
+            continue;
+
+        parked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (idle() && running.load(std::memory_order_relaxed))
+            parked.wait(true);
+        parked.store(false, std::memory_order_relaxed);
+        spins = 0;
+    }
+}
+
+void Engine::publishMarketData() {
+    if (md_dirty.empty())
+        return;
+    auto now = std::chrono::steady_clock::now();
+    if (md_interval.count() > 0 && now - last_md < md_interval)
+        return;
+
+    for (Instrument *instrument : md_dirty) instrument->publishMarketData();
+    md_dirty.clear();
+    last_md = now;
+}
+
+// Runs on the engine thread between bursts, so the books hold still; the
+// engine does not take commands while it writes.
+void Engine::takeSnapshots(bool force) {
+    // a book the journal fell behind must not be saved as if it were recorded
+    if (snapshot_every.count() <= 0 || wal->failed() || wal->records() == snapshot_seq)
+        return;
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - last_snapshot < snapshot_every)
+        return;
+
+    journal::Position at      = wal->position();
+    bool              written = true;
+    for (Instrument *instrument : owned)
+        written &= snapshot::write(
+                *instrument, at, snapshot::pathFor(wal->directory(), instrument->getSymbol()));
+    // with every book saved, the segments written before `at` are no longer needed
+    if (written)
+        wal->prune(at.sequence);
+    snapshot_seq  = at.sequence;
+    last_snapshot = now;
+}
+
+void Engine::markDirty(Instrument *instrument) {
+    if (instrument->hasPendingMarketData() &&
+        std::find(md_dirty.begin(), md_dirty.end(), instrument) == md_dirty.end())
+        md_dirty.push_back(instrument);
+}
+
+void Engine::adopt(Instrument &instrument) {
+    instrument.setListener(this);
+    owned.push_back(&instrument);
+
+    risk::Checker checker(instrument.getLimits());
+    for (auto &[id, order] : instrument.getOrderMap())
+        checker.add(order->clientId, order->remainingQuantity, order->price);
+    checkers.emplace(&instrument, std::move(checker));
+}
+
+risk::Checker &Engine::checkerFor(const Instrument &instrument) {
+    auto it = checkers.find(&instrument);
+    if (it == checkers.end())
+        it = checkers.emplace(&instrument, risk::Checker(instrument.getLimits())).first;
+    return it->second;
+}
+
+// Only what is left of a GTC limit order enters the book; market orders have
+// no price to check.
+static bool mayRest(const OrderRequest &req) {
+    return req.type == OrderType::Limit && req.tif == TimeInForce::GTC;
+}
+
+static Price limitPrice(const OrderRequest &req) {
+    return req.type == OrderType::Limit ? req.price : 0;
+}
+
+static risk::Verdict screen(const risk::Checker &checker,
+                            const Instrument    &instrument,
+                            const OrderRequest  &req) {
+    return checker.check(req.clientId,
+                         static_cast<uint64_t>(req.quantity),
+                         limitPrice(req),
+                         instrument.getLastTradePrice(),
+                         mayRest(req));
+}
+
+void Engine::execute(EngineCommand &cmd) {
+    Instrument *instrument = cmd.instrument;
+
+    // once the journal has failed nothing that changes a book can be recorded,
+    // so it is refused rather than acknowledged and lost on a restart
+    if (wal && wal->failed() && cmd.kind != EngineCommand::Kind::Query &&
+        cmd.kind != EngineCommand::Kind::Publish) {
+        reject(cmd.replyTo, wire::RejectReason::Journal, "ERR JOURNAL_FAILED\n");
+        return;
+    }
+
+    switch (cmd.kind) {
+        case EngineCommand::Kind::NewOrder: {
+            LatencyStats::bump(stats.orders);
+            risk::Checker &checker = checkerFor(*instrument);
+            // refused before it draws an id or is journaled, as if it never arrived
+            if (risk::Verdict verdict = screen(checker, *instrument, cmd.order);
+                verdict != risk::Verdict::Pass) {
+                rejectRisk(cmd.replyTo, verdict);
+                return;
+            }
+
+            Order  *order = instrument->createOrder(cmd.order);
+            OrderId id    = order->getId();  // the order may be gone after placing it
+            if (wal)
+                wal->newOrder(*instrument, *order);
+
+            active_order        = id;
+            Placement placement = instrument->placeOrder(*order);
+            active_order        = 0;
+            if (placement == Placement::Rested)
+                checker.add(order->clientId, order->remainingQuantity, order->price);
+
+            switch (placement) {
+                case Placement::Refused:
+                    reject(cmd.replyTo, wire::RejectReason::BadPrice, "ERR BAD_PRICE\n");
+                    return;
+                case Placement::Killed:
+                    reject(cmd.replyTo, wire::RejectReason::NoLiquidity, "ERR NO_LIQUIDITY\n");
+                    return;
+                case Placement::Cancelled:
+                    // executions went out already; the unfilled rest is dropped
+                    ack(cmd.replyTo, wire::AckKind::New, id, protocol::requestMade(id));
+                    ack(cmd.replyTo, wire::AckKind::Cancelled, id, protocol::cancelled(id));
+                    break;
+                case Placement::Filled:
+                case Placement::Rested:
+                    ack(cmd.replyTo, wire::AckKind::New, id, protocol::requestMade(id));
+                    break;
+            }
+            markDirty(instrument);
+            return;
+        }
+        case EngineCommand::Kind::Cancel: {
+            // what it releases, read while the order is still there
+            Order   *order    = instrument->findOrder(cmd.orderId);
+            uint64_t quantity = order ? order->remainingQuantity : 0;
+            Price    price    = order ? order->price : 0;
+
+            if (!instrument->cancelOrder(cmd.orderId, cmd.order.clientId)) {
+                reject(cmd.replyTo, wire::RejectReason::UnknownOrder, "ERR UNKNOWN_ORDER\n");
+                return;
+            }
+            // a cancel trades nothing, so journaling it afterwards keeps the order of
+            // records, and unknown or foreign ids leave nothing to replay
+            if (wal)
+                wal->cancel(*instrument, cmd.order.clientId, cmd.orderId);
+            checkerFor(*instrument).remove(cmd.order.clientId, quantity, price);
+            markDirty(instrument);
+            ack(cmd.replyTo,
+                wire::AckKind::Cancelled,
+                cmd.orderId,
+                protocol::cancelled(cmd.orderId));
+            return;
+        }
+        case EngineCommand::Kind::Amend: {
+            // price 0 keeps the order's price; looked up here, where the book is
+            Order *order = instrument->findOrder(cmd.orderId);
+            Price  price = cmd.order.price;
+            if (price == 0)
+                price = order ? order->price : 0;
+
+            // the amended order takes the place of the resting one in the
+            // client's exposure; someone else's or an unknown order is left
+            // for the book to refuse
+            risk::Checker &checker   = checkerFor(*instrument);
+            bool           mine      = order && order->clientId == cmd.order.clientId;
+            uint64_t       heldQty   = mine ? order->remainingQuantity : 0;
+            Price          heldPrice = mine ? order->price : 0;
+            if (mine) {
+                risk::Verdict verdict =
+                        checker.check(cmd.order.clientId,
+                                      static_cast<uint64_t>(cmd.order.quantity),
+                                      price,
+                                      instrument->getLastTradePrice(),
+                                      true,
+                                      risk::Exposure{heldQty, risk::notional(heldQty, heldPrice)});
+                if (verdict != risk::Verdict::Pass) {
+                    rejectRisk(cmd.replyTo, verdict);
+                    return;
+                }
+            }
+
+            // journaled ahead of the fills it may cause, and only if the book takes
+            // it: unknown, foreign and off-book amends change nothing to replay
+            if (wal && mine && instrument->accepts(order->side, price))
+                wal->amend(*instrument,
+                           cmd.order.clientId,
+                           cmd.orderId,
+                           static_cast<uint64_t>(cmd.order.quantity),
+                           price);
+            active_order        = cmd.orderId;
+            Amendment amendment = instrument->amendOrder(cmd.orderId,
+                                                         cmd.order.clientId,
+                                                         static_cast<uint64_t>(cmd.order.quantity),
+                                                         price);
+            active_order        = 0;
+            switch (amendment) {
+                case Amendment::Unknown:
+                    reject(cmd.replyTo, wire::RejectReason::UnknownOrder, "ERR UNKNOWN_ORDER\n");
+                    return;
+                case Amendment::Refused:
+                    reject(cmd.replyTo, wire::RejectReason::BadPrice, "ERR BAD_PRICE\n");
+                    return;
+                case Amendment::Reduced:
+                case Amendment::Requeued:
+                case Amendment::Filled:
+                    break;
+            }
+            checker.remove(cmd.order.clientId, heldQty, heldPrice);
+            if (Order *now = instrument->findOrder(cmd.orderId))
+                checker.add(now->clientId, now->remainingQuantity, now->price);
+            markDirty(instrument);
+            ack(cmd.replyTo, wire::AckKind::Amended, cmd.orderId, protocol::amended(cmd.orderId));
+            return;
+        }
+        case EngineCommand::Kind::Query:
+            reply(cmd.replyTo, cmd.query(*instrument));
+            return;
+        case EngineCommand::Kind::Publish:
+            notifyGroup(cmd.group, std::move(cmd.text));
+            return;
+        case EngineCommand::Kind::Batch:
+            LatencyStats::bump(stats.orders, cmd.batch.size());
+            placeBatch(cmd);
+            return;
+    }
+}
+
+// Places every order of the batch in one go and answers once. Ids are drawn
+// back to back from the instrument, so the ack only needs the first one.
+void Engine::placeBatch(EngineCommand &cmd) {
+    Instrument *instrument = cmd.instrument;
+
+    // screened as a whole first, each order counting what the ones before it
+    // would leave resting; a batch comes from one session, so one client
+    risk::Checker &checker   = checkerFor(*instrument);
+    Price          reference = instrument->getLastTradePrice();
+    risk::Exposure held;
+    if (!cmd.batch.empty())
+        held = checker.exposure(cmd.batch.front().clientId);
+    for (const OrderRequest &req : cmd.batch) {
+        uint64_t      quantity = static_cast<uint64_t>(req.quantity);
+        Price         price    = limitPrice(req);
+        risk::Verdict verdict  = checker.check(held, quantity, price, reference, mayRest(req));
+        if (verdict != risk::Verdict::Pass) {
+            rejectRisk(cmd.replyTo, verdict, instrument->getSymbol());
+            return;
+        }
+        if (mayRest(req)) {
+            held.quantity += quantity;
+            held.notional += risk::notional(quantity, price);
+        }
+    }
+
+    OrderId                        first = 0;
+    std::vector<wire::BatchReject>   rejected;
+    for (size_t i = 0; i < cmd.batch.size(); ++i) {
+        Order *order = instrument->createOrder(cmd.batch[i]);
+        if (i == 0)
+            first = order->getId();
+        if (wal)
+            wal->newOrder(*instrument, *order);
+
+        active_order        = order->getId();
+        Placement placement = instrument->placeOrder(*order);
+        active_order        = 0;
+        if (placement == Placement::Rested)
+            checker.add(order->clientId, order->remainingQuantity, order->price);
+
+        switch (placement) {
+            case Placement::Refused:
+                rejected.push_back({static_cast<uint16_t>(i), wire::RejectReason::BadPrice});
+                break;
+            case Placement::Killed:
+                rejected.push_back({static_cast<uint16_t>(i), wire::RejectReason::NoLiquidity});
+                break;
+            default:
+                break;
+        }
+    }
+    markDirty(instrument);
+
+    std::string out;
+    if (cmd.replyTo.binary) {
+        out = wire::batchAck(instrument->getSymbol(), first, cmd.batch.size(), rejected);
+    } else {
+        out = "BATCH_ACK " + instrument->getSymbol() + " " + std::to_string(first) + " " +
+              std::to_string(cmd.batch.size());
+        for (auto &r : rejected)
+            out += " REJ " + std::to_string(r.index) + ":" +
+                   (r.reason == wire::RejectReason::BadPrice ? "BAD_PRICE" : "NO_LIQUIDITY");
+        out += "\n";
+    }
+    publish(*links[cmd.replyTo.reactor],
+            EngineEvent{.kind    = EngineEvent::Kind::Reply,
+                        .replyTo = cmd.replyTo,
+                        .text    = std::move(out)});
+}
+
+void Engine::notifyUser(const std::string &clientId, std::string message) {
+    // the engine does not know which reactor holds the client's session
+    broadcast(EngineEvent{
+            .kind = EngineEvent::Kind::User, .target = clientId, .text = std::move(message)});
+}
+
+void Engine::notifyGroup(const std::string &group, std::string message) {
+    broadcast(EngineEvent{.kind    = EngineEvent::Kind::Group,
+                          .target  = group,
+                          .payload = utils::makePayload(std::move(message))});
+}
+
+void Engine::notifyExecution(const Instrument &instrument, const Execution &execution) {
+    LatencyStats::bump(stats.executions);
+    if (wal)
+        wal->fill(instrument, execution);
+    // a resting order traded: that much of its client's exposure is gone
+    if (execution.orderId != active_order)
+        checkerFor(instrument).remove(execution.clientId, execution.quantity, execution.price);
+
+    std::string text = protocol::exec(instrument.getSymbol(),
+                                      execution.quantity,
+                                      instrument.formatPrice(execution.price));
+    std::string binary = wire::exec(
+            instrument.getSymbol(), execution.orderId, execution.quantity, execution.price);
+
+    broadcast(EngineEvent{.kind   = EngineEvent::Kind::User,
+                          .target = std::string(execution.clientId),
+                          .text   = std::move(text),
+                          .binary = std::move(binary)});
+}
+
+void Engine::notifyConflated(const Instrument &instrument,
+                             const std::string &group,
+                             std::string        message) {
+    broadcast(EngineEvent{.kind    = EngineEvent::Kind::Group,
+                          .target  = group,
+                          .payload = utils::makePayload(std::move(message)),
+                          .key     = instrument.getSymbol()});
+}
+
+// Replies are only ever read by the session that asked, so they are built in its format.
+void Engine::reply(const ReplyTo &to, std::string text) {
+    if (to.binary) {
+        std::string framed;
+        wire::appendText(framed, text);
+        text = std::move(framed);
+    }
+    publish(*links[to.reactor],
+            EngineEvent{.kind = EngineEvent::Kind::Reply, .replyTo = to, .text = std::move(text)});
+}
+
+void Engine::ack(const ReplyTo &to, wire::AckKind kind, OrderId id, std::string text) {
+    std::string out = to.binary ? wire::ack(kind, id) : std::move(text);
+    publish(*links[to.reactor],
+            EngineEvent{.kind = EngineEvent::Kind::Reply, .replyTo = to, .text = std::move(out)});
+}
+
+void Engine::reject(const ReplyTo &to, wire::RejectReason reason, std::string text) {
+    std::string out = to.binary ? wire::reject(reason) : std::move(text);
+    publish(*links[to.reactor],
+            EngineEvent{.kind = EngineEvent::Kind::Reply, .replyTo = to, .text = std::move(out)});
+}
+
+// Text replies name the limit; batches also name the instrument, since a text
+// batch is split per symbol and one part may go through while another does not.
+void Engine::rejectRisk(const ReplyTo &to, risk::Verdict verdict, const std::string &symbol) {
+    wire::RejectReason reason;
+    std::string        text;
+    switch (verdict) {
+        case risk::Verdict::PriceBand:
+            reason = wire::RejectReason::PriceBand;
+            text   = "ERR RISK_PRICE_BAND";
+            break;
+        case risk::Verdict::OrderSize:
+            reason = wire::RejectReason::OrderSize;
+            text   = "ERR RISK_ORDER_SIZE";
+            break;
+        case risk::Verdict::OpenQuantity:
+            reason = wire::RejectReason::OpenQuantity;
+            text   = "ERR RISK_OPEN_QTY";
+            break;
+        default:
+            reason = wire::RejectReason::OpenNotional;
+            text   = "ERR RISK_NOTIONAL";
+            break;
+    }
+    if (!symbol.empty())
+        text += " " + symbol;
+    reject(to, reason, text + "\n");
+}
+
+void Engine::broadcast(EngineEvent &&ev) {
+    for (size_t i = 0; i + 1 < links.size(); ++i) publish(*links[i], EngineEvent(ev));
+    publish(*links.back(), std::move(ev));
+}
+
+// Without a journal events go straight out. With one they are held until
+// the end of the burst: the reactor drains the ring whenever its eventfd
+// fires, and any engine can fire it, so nothing may be in the ring before
+// the records behind it are on disk.
+void Engine::publish(Link &link, EngineEvent &&ev) {
+    if (wal && !journal_down)
+        link.staged.push_back(std::move(ev));
+    else
+        push(link, std::move(ev));
+}
+
+// A burst whose records did not all reach the disk is not answered: its acks
+// would promise orders a restart does not bring back. From then on events go
+// out unstaged, since only refusals, queries and market data are left.
+void Engine::releaseStaged() {
+    if (wal->failed() && !journal_down) {
+        size_t withheld = 0;
+        for (auto &link : links) withheld += link->staged.size();
+        LOG_ERROR("engine: journal failed, {} events withheld and book changes refused",
+                  withheld);
+        journal_down = true;
+    }
+    for (auto &link : links) {
+        if (!journal_down)
+            for (auto &ev : link->staged) push(*link, std::move(ev));
+        link->staged.clear();
+    }
+}
+
+void Engine::push(Link &link, EngineEvent &&ev) {
+    ev.published = utils::tsc();
+    while (!link.outbound.tryPush(std::move(ev))) {
+        // the reactor is behind; make sure it is awake and wait for room
+        if (!running.load(std::memory_order_relaxed))
+            return;
+        wake(link);
+        std::this_thread::yield();
+    }
+    link.pending_wake = true;
+}
+
+void Engine::wake(Link &link) {
+    link.pending_wake = false;
+    if (link.wake_fd < 0)
+        return;
+    uint64_t one = 1;
+    ssize_t  n   = ::write(link.wake_fd, &one, sizeof(one));
+    (void)n;
+}
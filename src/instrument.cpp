@@ -1,69 +1,276 @@
 #include "instrument.hpp"
-#include "notifier.hpp"
 
-void Instrument::placeOrder(Order &order) {
-    if (order.side == Side::Buy) {
-        buy_side.insert(order);
+#include <algorithm>
+#include <array>
+#include <span>
+#include <sstream>
+
+std::shared_ptr<Instrument> makeInstrument(const InstrumentSpec &spec) {
+    if (spec.book.type == BookType::Ladder)
+        return std::make_shared<BookInstrument<LadderBook>>(spec);
+    return std::make_shared<BookInstrument<AVLBook>>(spec);
+}
+
+Order *Instrument::createOrder(const OrderRequest &req) {
+    Order *order = order_pool.create(
+            order_ids.next(), req.clientId, req.price, req.quantity, req.side, req.type);
+    order->tif = req.tif;
+    return order;
+}
+
+void Instrument::releaseOrder(Order *order) {
+    order_pool.destroy(order);
+}
+
+Order *Instrument::restoreOrder(OrderId             id,
+                                const OrderRequest &req,
+                                uint64_t            filled,
+                                uint64_t            arrivalNs) {
+    Order *order = order_pool.create(id, req.clientId, req.price, req.quantity, req.side, req.type);
+    order->tif            = req.tif;
+    order->filledQuantity = filled;
+    order->setArrivalFromNs(arrivalNs);
+    return order;
+}
+
+TradeState Instrument::tradeState() const {
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         last_trade_ts.time_since_epoch())
+                         .count();
+    return TradeState{last_trade_price,
+                      last_trade_size,
+                      ns,
+                      volume_today,
+                      vwap_numerator,
+                      open,
+                      high,
+                      low,
+                      close};
+}
+
+void Instrument::restoreTradeState(const TradeState &state) {
+    last_trade_price = state.lastTradePrice;
+    last_trade_size  = state.lastTradeSize;
+    last_trade_ts    = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                    std::chrono::nanoseconds(state.lastTradeNs)));
+    volume_today   = state.volumeToday;
+    vwap_numerator = state.vwapNumerator;
+    open           = state.open;
+    high           = state.high;
+    low            = state.low;
+    close          = state.close;
+}
+
+template <typename BookPolicy>
+BookInstrument<BookPolicy>::~BookInstrument() {
+    buy_side.clear([&](Order *o) { order_pool.destroy(o); });
+    sell_side.clear([&](Order *o) { order_pool.destroy(o); });
+}
+
+template <typename BookPolicy>
+void BookInstrument<BookPolicy>::forEachLevel(Side                                 side,
+                                              std::function<void(PriceLevelNode *)> func,
+                                              size_t                                limit) const {
+    (side == Side::Buy ? buy_side : sell_side).inorder(func, limit);
+}
+
+template <typename BookPolicy>
+size_t BookInstrument<BookPolicy>::copyDepth(Side side, DepthLevel *out, size_t limit) const {
+    // walks out from the best price over the neighbour links, never the whole side
+    size_t n = 0;
+    if (side == Side::Buy) {
+        for (auto &level : buy_side.descending(limit))
+            out[n++] = DepthLevel{level.price, level.quantity()};
     } else {
-        sell_side.insert(order);
+        for (auto &level : sell_side.ascending(limit))
+            out[n++] = DepthLevel{level.price, level.quantity()};
+    }
+    return n;
+}
+
+template <typename BookPolicy>
+bool BookInstrument<BookPolicy>::loadBook(std::span<Order *const> bids,
+                                          std::span<Order *const> asks) {
+    bool fits = std::all_of(bids.begin(), bids.end(), [&](Order *o) {
+        return buy_side.accepts(o->price);
+    }) && std::all_of(asks.begin(), asks.end(), [&](Order *o) {
+        return sell_side.accepts(o->price);
+    });
+    if (!fits) {
+        for (Order *o : bids) releaseOrder(o);
+        for (Order *o : asks) releaseOrder(o);
+        return false;
     }
 
-    execute_limit_if_match();
+    buy_side.bulkLoad(bids);
+    sell_side.bulkLoad(asks);
+    // the orders learn their level from the built sides, one pass over each
+    for (auto &level : buy_side.ascending())
+        for (Order *o : level.level) o->level = &level;
+    for (auto &level : sell_side.ascending())
+        for (Order *o : level.level) o->level = &level;
+
+    order_map.reserve(bids.size() + asks.size());
+    for (Order *o : bids) order_map.emplace(o->id, o);
+    for (Order *o : asks) order_map.emplace(o->id, o);
+    l2_pending = !bids.empty() || !asks.empty();
+    return true;
 }
 
-void Instrument::execute_limit_if_match() {
-    while (true) {
-        auto buyLevel  = buy_side.high;
-        auto sellLevel = sell_side.low;
+template <typename BookPolicy>
+bool BookInstrument<BookPolicy>::accepts(Side side, Price price) const {
+    return price > 0 && (side == Side::Buy ? buy_side : sell_side).accepts(price);
+}
 
-        if (!buyLevel || !sellLevel)
-            break;
-        if (buyLevel->price < sellLevel->price)
-            break;
+template <typename BookPolicy>
+Placement BookInstrument<BookPolicy>::placeOrder(Order &order) {
+    bool  market = order.type == OrderType::Market;
+    auto &side   = order.side == Side::Buy ? buy_side : sell_side;
 
-        auto bestBuyPtr  = buyLevel->level.front();
-        auto bestSellPtr = sellLevel->level.front();
+    Placement result;
+    if (!market && !side.accepts(order.price)) {
+        result = Placement::Refused;
+    } else if (order.tif == TimeInForce::FOK && !canFill(order)) {
+        result = Placement::Killed;
+    } else {
+        match(order);
+        if (order.remainingQuantity == 0)
+            result = Placement::Filled;
+        else if (market && order.filledQuantity == 0)
+            result = Placement::Killed;
+        else if (market || order.tif != TimeInForce::GTC)
+            result = Placement::Cancelled;
+        else
+            result = Placement::Rested;
+    }
 
-        if (!bestBuyPtr || !bestSellPtr)
-            break;
+    if (result != Placement::Rested) {
+        releaseOrder(&order);
+        return result;
+    }
 
-        int fillQty =
-                std::min(bestBuyPtr->getRemainingQuantity(), bestSellPtr->getRemainingQuantity());
-        double fillPrice = static_cast<double>(sellLevel->price);
+    order.level = side.insert(order);
+    order_map.emplace(order.id, &order);
+    l2_pending = true;
+    return result;
+}
 
-        std::string buyerId  = bestBuyPtr->clientId;
-        std::string sellerId = bestSellPtr->clientId;
+template <typename BookPolicy>
+bool BookInstrument<BookPolicy>::cancelOrder(OrderId id, const std::string &clientId) {
+    auto it = order_map.find(id);
+    if (it == order_map.end() || it->second->clientId != clientId)
+        return false;
 
-        bestBuyPtr->setFilledQuantity(bestBuyPtr->getFilledQuantity() + fillQty);
-        bestBuyPtr->setRemainingQuantity(bestBuyPtr->getRemainingQuantity() - fillQty);
+    Order *order = it->second;
+    auto  &side  = order->side == Side::Buy ? buy_side : sell_side;
 
-        bestSellPtr->setFilledQuantity(bestSellPtr->getFilledQuantity() + fillQty);
-        bestSellPtr->setRemainingQuantity(bestSellPtr->getRemainingQuantity() - fillQty);
+    // the order knows its level, so cancelling never searches the book
+    side.remove(*order, order->level);
+    order_map.erase(it);
+    releaseOrder(order);
+    l2_pending = true;
+    return true;
+}
 
-        if (bestBuyPtr->getRemainingQuantity() == 0) {
-            buy_side.remove(*bestBuyPtr);
-        }
-        if (bestSellPtr->getRemainingQuantity() == 0) {
-            sell_side.remove(*bestSellPtr);
-        }
+template <typename BookPolicy>
+Amendment BookInstrument<BookPolicy>::amendOrder(OrderId            id,
+                                                 const std::string &clientId,
+                                                 uint64_t           quantity,
+                                                 Price              price) {
+    auto it = order_map.find(id);
+    if (it == order_map.end() || it->second->clientId != clientId)
+        return Amendment::Unknown;
+
+    Order *order = it->second;
+    auto  &side  = order->side == Side::Buy ? buy_side : sell_side;
+    if (!accepts(order->side, price))
+        return Amendment::Refused;
+
+    if (price == order->price && quantity <= order->remainingQuantity) {
+        order->level->level.reduce(order, order->remainingQuantity - quantity);
+        l2_pending = true;
+        return Amendment::Reduced;
+    }
+
+    // cancel-replace in one step: the order loses its place but not its id
+    side.remove(*order, order->level);
+    order->price             = price;
+    order->remainingQuantity = quantity;
+    order->setArrivalNow();
+    l2_pending = true;
+
+    match(*order);
+    if (order->remainingQuantity == 0) {
+        order_map.erase(id);  // `it` went stale if the match released makers
+        releaseOrder(order);
+        return Amendment::Filled;
+    }
+    order->level = side.insert(*order);
+    return Amendment::Requeued;
+}
+
+template <typename BookPolicy>
+void BookInstrument<BookPolicy>::match(Order &taker) {
+    bool  buy  = taker.side == Side::Buy;
+    auto &book = buy ? sell_side : buy_side;
+
+    while (taker.remainingQuantity > 0) {
+        auto *level = buy ? book.low : book.high;
+        if (!level || !crosses(taker, level->price))
+            break;
+
+        Order   *maker     = level->level.front();
+        uint64_t fillQty   = std::min(taker.remainingQuantity, maker->remainingQuantity);
+        Price    fillPrice = level->price;
+
+        level->level.fill(maker, fillQty);
+        taker.filledQuantity += fillQty;
+        taker.remainingQuantity -= fillQty;
 
         updateState(fillPrice, fillQty);
         last_trade_size = fillQty;
 
-        std::ostringstream oss;
-        oss << "EXEC " << symbol << " " << fillQty << "@" << fillPrice << "\n";
-        std::string message = oss.str();
+        // reported before the maker can be released, buyer first
+        Order &buyer  = buy ? taker : *maker;
+        Order &seller = buy ? *maker : taker;
+        notifyExecution(Execution{buyer.clientId, buyer.id, fillPrice, fillQty});
+        notifyExecution(Execution{seller.clientId, seller.id, fillPrice, fillQty});
 
-        Notifier::instance().notifyUser(buyerId, message);
-        Notifier::instance().notifyUser(sellerId, message);
+        if (maker->remainingQuantity == 0) {
+            book.remove(*maker, level);
+            order_map.erase(maker->id);
+            releaseOrder(maker);
+        }
+        l2_pending = true;
     }
 }
 
-void Instrument::updateState(double fillPrice, int qty) {
+template <typename BookPolicy>
+bool BookInstrument<BookPolicy>::canFill(const Order &taker) const {
+    // only the levels the order would actually trade through are visited
+    uint64_t need = taker.remainingQuantity;
+    auto     sum  = [&](auto levels) {
+        for (auto &level : levels) {
+            if (!crosses(taker, level.price))
+                return false;
+            if (level.quantity() >= need)
+                return true;
+            need -= level.quantity();
+        }
+        return false;
+    };
+    return taker.side == Side::Buy ? sum(sell_side.ascending()) : sum(buy_side.descending());
+}
+
+void Instrument::updateState(Price fillPrice, uint64_t qty) {
     last_trade_price = fillPrice;
+    last_trade_ts    = sim_now == std::chrono::system_clock::time_point{}
+                               ? std::chrono::system_clock::now()
+                               : sim_now;
 
     high = std::max(high, last_trade_price);
-    low  = std::min(low, last_trade_price);
+    low  = (low == 0) ? last_trade_price : std::min(low, last_trade_price);
 
     if (open == 0) {
         open = last_trade_price;
@@ -71,26 +278,124 @@ void Instrument::updateState(double fillPrice, int qty) {
     close = last_trade_price;
 
     volume_today += qty;
+    vwap_numerator += fillPrice * static_cast<int64_t>(qty);
+    l1_pending = true;
+}
 
-    std::ostringstream oss;
-    oss << "F1_UPDATE\n"
-        << "LTP: " << last_trade_price << "\n"
-        << "HIGH: " << high << "\n"
-        << "LOW: " << low << "\n"
-        << "OPEN: " << open << "\n"
-        << "CLOSE: " << close << "\n";
+void Instrument::publishMarketData() {
+    publishL1();
+    publishL2();
+}
+
+void Instrument::publishL1() {
+    if (!l1_pending)
+        return;
+    l1_pending = false;
 
-    Notifier::instance().notifyGroup("L1", oss.str());
+    // built once per burst; every subscriber shares this one buffer
+    std::string msg;
+    msg.reserve(96);
+    msg += "F1_UPDATE\nLTP: ";
+    msg += formatPrice(last_trade_price);
+    msg += "\nHIGH: ";
+    msg += formatPrice(high);
+    msg += "\nLOW: ";
+    msg += formatPrice(low);
+    msg += "\nOPEN: ";
+    msg += formatPrice(open);
+    msg += "\nCLOSE: ";
+    msg += formatPrice(close);
+    msg += "\n";
+
+    notifyConflated("L1", std::move(msg));
+}
+
+// Appends the changes from `before` to `after` (both best first) as delta lines.
+static void diffDepth(std::string                &out,
+                      size_t                     &count,
+                      const Instrument           &instrument,
+                      const char                 *side,
+                      std::span<const DepthLevel> before,
+                      std::span<const DepthLevel> after,
+                      bool                        descending) {
+    auto better = [&](Price a, Price b) { return descending ? a > b : a < b; };
+    auto line   = [&](const char *op, const DepthLevel &l, bool withQty) {
+        out += op;
+        out += ' ';
+        out += side;
+        out += ' ';
+        out += instrument.formatPrice(l.price);
+        if (withQty) {
+            out += ' ';
+            out += std::to_string(l.quantity);
+        }
+        out += '\n';
+        ++count;
+    };
+
+    size_t i = 0, j = 0;
+    while (i < before.size() || j < after.size()) {
+        if (j == after.size() || (i < before.size() && better(before[i].price, after[j].price))) {
+            line("DEL", before[i++], false);
+        } else if (i == before.size() || better(after[j].price, before[i].price)) {
+            line("ADD", after[j++], true);
+        } else {
+            if (before[i].quantity != after[j].quantity)
+                line("MOD", after[j], true);
+            ++i;
+            ++j;
+        }
+    }
+}
+
+void Instrument::publishL2() {
+    if (!l2_pending)
+        return;
+    l2_pending = false;
+
+    std::string deltas;
+    size_t      count = 0;
+
+    std::array<DepthLevel, L2_DEPTH> now;
+    size_t                           n = copyDepth(Side::Buy, now.data(), L2_DEPTH);
+    diffDepth(deltas, count, *this, "BID", l2_bids, {now.data(), n}, true);
+    l2_bids.assign(now.begin(), now.begin() + n);
+
+    n = copyDepth(Side::Sell, now.data(), L2_DEPTH);
+    diffDepth(deltas, count, *this, "ASK", l2_asks, {now.data(), n}, false);
+    l2_asks.assign(now.begin(), now.begin() + n);
+
+    // changes below the published depth are not sent
+    if (count == 0)
+        return;
+
+    std::string msg = "L2_DELTA " + symbol + " " + std::to_string(++l2_seq) + " " +
+                      std::to_string(count) + "\n";
+    msg += deltas;
+    notifyGroup("L2", std::move(msg));
+}
+
+std::string Instrument::depthSnapshot() const {
+    std::string msg = "L2_SNAPSHOT " + symbol + " " + std::to_string(l2_seq) + " " +
+                      std::to_string(l2_bids.size() + l2_asks.size()) + "\n";
+    for (auto &l : l2_bids)
+        msg += "BID " + formatPrice(l.price) + " " + std::to_string(l.quantity) + "\n";
+    for (auto &l : l2_asks)
+        msg += "ASK " + formatPrice(l.price) + " " + std::to_string(l.quantity) + "\n";
+    return msg;
 }
 
 void Instrument::fetchState(std::string clientId) {
     std::ostringstream oss;
     oss << "F1_SNAPSHOT\n"
-        << "LTP: " << last_trade_price << "\n"
-        << "HIGH: " << high << "\n"
-        << "LOW: " << low << "\n"
-        << "OPEN: " << open << "\n"
-        << "CLOSE: " << close << "\n";
-
-    Notifier::instance().notifyUser(clientId, oss.str());
-}
\ No newline at end of file
+        << "LTP: " << formatPrice(last_trade_price) << "\n"
+        << "HIGH: " << formatPrice(high) << "\n"
+        << "LOW: " << formatPrice(low) << "\n"
+        << "OPEN: " << formatPrice(open) << "\n"
+        << "CLOSE: " << formatPrice(close) << "\n";
+
+    notifyUser(clientId, oss.str());
+}
+
+template class BookInstrument<AVLBook>;
+template class BookInstrument<LadderBook>;
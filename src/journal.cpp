@@ -0,0 +1,324 @@
+#include "journal.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "instrument.hpp"
+#include "logger.hpp"
+#include "utils/checksum.hpp"
+
+namespace journal {
+
+namespace fs = std::filesystem;
+
+static constexpr std::string_view SUFFIX = ".journal";
+
+uint32_t checksum(const Record &record) {
+    Record copy   = record;
+    copy.checksum = 0;
+    return utils::fnv1a(&copy, sizeof(copy));
+}
+
+static void setField(char *dst, size_t len, std::string_view text) {
+    std::memset(dst, 0, len);
+    std::memcpy(dst, text.data(), std::min(text.size(), len));
+}
+
+Journal::Journal(std::string dir, uint64_t epoch, uint32_t engine, size_t segmentBytes)
+    : dir(std::move(dir)),
+      epoch(epoch),
+      engine(engine),
+      segment_bytes(std::max(segmentBytes / sizeof(Record), size_t(1)) * sizeof(Record)) {}
+
+Journal::~Journal() {
+    close();
+}
+
+bool Journal::open() {
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) {
+        LOG_ERROR("journal: cannot create {}: {}", dir, ec.message());
+        return false;
+    }
+    return openSegment();
+}
+
+void Journal::close() {
+    commit();
+    closeSegment();
+}
+
+std::string Journal::segmentPath(uint32_t index) const {
+    char file[64];
+    std::snprintf(file,
+                  sizeof(file),
+                  "%06llu-%03u-%06u%s",
+                  static_cast<unsigned long long>(epoch),
+                  engine,
+                  index,
+                  SUFFIX.data());
+    return (fs::path(dir) / file).string();
+}
+
+bool Journal::openSegment() {
+    std::string path = segmentPath(segment);
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("journal open: {}", logging::sysError());
+        return false;
+    }
+    // allocated up front, so appends never extend the file or fault on a full disk
+    if (int err = posix_fallocate(fd, 0, static_cast<off_t>(segment_bytes)); err != 0) {
+        LOG_ERROR("journal fallocate: {}", logging::SysError{err});
+        closeSegment();
+        return false;
+    }
+    void *p = mmap(nullptr, segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        LOG_ERROR("journal mmap: {}", logging::sysError());
+        closeSegment();
+        return false;
+    }
+    base    = static_cast<char *>(p);
+    written = 0;
+    synced  = 0;
+    return true;
+}
+
+void Journal::closeSegment() {
+    if (base) {
+        munmap(base, segment_bytes);
+        base = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void Journal::commit() {
+    if (!base || synced == written)
+        return;
+
+    // msync wants a page aligned start
+    static const size_t page  = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t              start = synced & ~(page - 1);
+    if (msync(base + start, written - start, MS_SYNC) < 0) {
+        LOG_ERROR("journal msync: {}", logging::sysError());
+        broken = true;
+        return;
+    }
+    synced = written;
+}
+
+void Journal::prune(uint64_t upTo) {
+    while (!finished.empty() && finished.front() <= upTo) {
+        std::string path = segmentPath(oldest);
+        if (::unlink(path.c_str()) < 0 && errno != ENOENT) {
+            LOG_ERROR("journal unlink {}: {}", path, logging::sysError());
+            return;
+        }
+        finished.pop_front();
+        ++oldest;
+    }
+}
+
+void Journal::append(Record &record, const Instrument &instrument, std::string_view clientId) {
+    if (broken)
+        return;
+    if (clientId.size() > CLIENT_ID_LEN) {
+        LOG_WARN("journal: client id too long, record dropped");
+        return;
+    }
+    if (written + sizeof(Record) > segment_bytes) {
+        commit();
+        closeSegment();
+        finished.push_back(sequence);
+        ++segment;
+        if (!openSegment()) {
+            broken = true;
+            return;
+        }
+    }
+
+    setField(record.symbol, SYMBOL_LEN, instrument.getSymbol());
+    setField(record.clientId, CLIENT_ID_LEN, clientId);
+    record.sequence = ++sequence;
+    record.checksum = checksum(record);
+
+    std::memcpy(base + written, &record, sizeof(record));
+    written += sizeof(record);
+}
+
+void Journal::newOrder(const Instrument &instrument, const Order &order) {
+    Record r{};
+    r.kind        = RecordKind::New;
+    r.side        = order.side == Side::Buy ? 0 : 1;
+    r.type        = order.type == OrderType::Market ? 1 : 0;
+    r.timeInForce = static_cast<uint8_t>(order.tif);
+    r.timestamp   = order.arrivalNs;
+    r.orderId     = order.id;
+    r.price       = order.price;
+    r.quantity    = order.remainingQuantity;
+    append(r, instrument, order.clientId);
+}
+
+void Journal::cancel(const Instrument &instrument, const std::string &clientId, OrderId id) {
+    Record r{};
+    r.kind    = RecordKind::Cancel;
+    r.orderId = id;
+    append(r, instrument, clientId);
+}
+
+void Journal::amend(const Instrument  &instrument,
+                    const std::string &clientId,
+                    OrderId            id,
+                    uint64_t           quantity,
+                    Price              price) {
+    Record r{};
+    r.kind     = RecordKind::Amend;
+    r.orderId  = id;
+    r.quantity = quantity;
+    r.price    = price;
+    append(r, instrument, clientId);
+}
+
+void Journal::fill(const Instrument &instrument, const Execution &execution) {
+    Record r{};
+    r.kind     = RecordKind::Fill;
+    r.orderId  = execution.orderId;
+    r.quantity = execution.quantity;
+    r.price    = execution.price;
+    append(r, instrument, execution.clientId);
+}
+
+bool covers(const Position &snapshot, const Position &record) {
+    if (record.epoch != snapshot.epoch)
+        return record.epoch < snapshot.epoch;
+    // within an epoch an instrument is journaled by one engine only
+    return record.engine == snapshot.engine && record.sequence <= snapshot.sequence;
+}
+
+// "<epoch>-<engine>-<segment>.journal"
+static bool parseName(const std::string &file, Position &at) {
+    unsigned long long epoch   = 0;
+    unsigned           engine  = 0, segment = 0;
+    int                matched = 0;
+    if (!file.ends_with(SUFFIX) ||
+        std::sscanf(file.c_str(), "%llu-%u-%u%n", &epoch, &engine, &segment, &matched) != 3 ||
+        file.size() != matched + SUFFIX.size())
+        return false;
+    at.epoch  = epoch;
+    at.engine = engine;
+    return true;
+}
+
+static std::vector<fs::path> journalFiles(const std::string &dir) {
+    std::vector<fs::path> files;
+    std::error_code       ec;
+    for (auto &entry : fs::directory_iterator(dir, ec)) {
+        Position at;
+        if (entry.is_regular_file() && parseName(entry.path().filename().string(), at))
+            files.push_back(entry.path());
+    }
+    // zero padded, so name order is write order
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+uint64_t nextEpoch(const std::string &dir) {
+    uint64_t last = 0;
+    for (auto &path : journalFiles(dir)) {
+        Position at;
+        if (parseName(path.filename().string(), at))
+            last = std::max(last, at.epoch);
+    }
+    return last + 1;
+}
+
+size_t removeBefore(const std::string &dir, uint64_t epoch) {
+    size_t removed = 0;
+    for (auto &path : journalFiles(dir)) {
+        Position at;
+        parseName(path.filename().string(), at);
+        if (at.epoch >= epoch)
+            continue;
+        std::error_code ec;
+        if (fs::remove(path, ec))
+            ++removed;
+        else if (ec)
+            LOG_ERROR("journal remove {}: {}", path.string(), ec.message());
+    }
+    return removed;
+}
+
+size_t read(const std::string                                          &dir,
+            const std::function<void(const Position &, const Record &)> &visit,
+            uint64_t                                                    fromEpoch) {
+    size_t count = 0;
+    for (auto &path : journalFiles(dir)) {
+        Position at;
+        parseName(path.filename().string(), at);
+        if (at.epoch < fromEpoch)
+            continue;
+
+        std::ifstream in(path, std::ios::binary);
+        Record        r;
+        while (in.read(reinterpret_cast<char *>(&r), sizeof(r))) {
+            if (static_cast<uint8_t>(r.kind) == 0)
+                break;
+            if (r.checksum != checksum(r)) {
+                LOG_WARN("journal: damaged record in {}", path.string());
+                break;
+            }
+            at.sequence = r.sequence;
+            visit(at, r);
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool apply(const Record &record, Instrument &instrument) {
+    std::string clientId(field(record.clientId, CLIENT_ID_LEN));
+
+    switch (record.kind) {
+        case RecordKind::New: {
+            OrderRequest req{std::move(clientId),
+                             instrument.getSymbol(),
+                             record.side == 0 ? Side::Buy : Side::Sell,
+                             record.type == 1 ? OrderType::Market : OrderType::Limit,
+                             record.price,
+                             static_cast<int>(record.quantity),
+                             static_cast<TimeInForce>(record.timeInForce)};
+            Order *order = instrument.createOrder(req);
+            order->setArrivalFromNs(record.timestamp);
+            bool same = order->getId() == record.orderId;
+            instrument.placeOrder(*order);
+            return same;
+        }
+        case RecordKind::Cancel:
+            instrument.cancelOrder(record.orderId, clientId);
+            return true;
+        case RecordKind::Amend:
+            instrument.amendOrder(record.orderId, clientId, record.quantity, record.price);
+            return true;
+        case RecordKind::Fill:
+            // re-derived by the matching of the orders above
+            return true;
+    }
+    return false;
+}
+
+}  // namespace journal
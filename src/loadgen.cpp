@@ -0,0 +1,406 @@
+#include "loadgen.hpp"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <thread>
+
+#include "protocol.hpp"
+#include "utils/tsc.hpp"
+
+namespace loadgen {
+
+namespace {
+
+// resting ids kept per session; older ones are likely filled by now anyway
+constexpr size_t MAX_RESTING = 1024;
+
+std::vector<std::string> splitList(std::string_view list) {
+    std::vector<std::string> out;
+    for (size_t start = 0; start < list.size();) {
+        size_t comma = std::min(list.find(',', start), list.size());
+        if (comma > start)
+            out.emplace_back(list.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return out;
+}
+
+template <typename T>
+bool parseNumber(std::string_view tok, T &out) {
+    auto [p, ec] = std::from_chars(tok.data(), tok.data() + tok.size(), out);
+    return ec == std::errc() && p == tok.data() + tok.size();
+}
+
+bool parseShare(std::string_view tok, double &out) {
+    return parseNumber(tok, out) && out >= 0 && out <= 1;
+}
+
+// One connected session of a worker thread.
+struct Connection {
+    int         fd = -1;
+    Flow        flow;
+    std::string in;
+    std::string out;
+    bool        open = true;
+
+    Connection(const Config &config, size_t index) : flow(config, index) {}
+};
+
+int connectTo(const Config &config, std::string &error) {
+    addrinfo hints{};
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo   *addrs = nullptr;
+    std::string port  = std::to_string(config.port);
+    if (int rc = getaddrinfo(config.host.c_str(), port.c_str(), &hints, &addrs); rc != 0) {
+        error = config.host + ": " + gai_strerror(rc);
+        return -1;
+    }
+    int fd = ::socket(addrs->ai_family, addrs->ai_socktype | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && ::connect(fd, addrs->ai_addr, addrs->ai_addrlen) < 0) {
+        error = std::string("connect: ") + std::strerror(errno);
+        ::close(fd);
+        fd = -1;
+    } else if (fd < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+    }
+    freeaddrinfo(addrs);
+    if (fd < 0)
+        return -1;
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    return fd;
+}
+
+// Writes what the socket takes; the rest is retried on the next pass.
+bool flush(Connection &c) {
+    while (!c.out.empty()) {
+        ssize_t n = ::send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            c.out.erase(0, static_cast<size_t>(n));
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+    return true;
+}
+
+// Reads everything available and hands over the complete lines.
+bool drain(Connection &c, Stats &stats) {
+    char buf[65536];
+    while (true) {
+        ssize_t n = ::recv(c.fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            uint64_t now = utils::tsc();
+            c.in.append(buf, static_cast<size_t>(n));
+            size_t pos = 0;
+            for (size_t nl; (nl = c.in.find('\n', pos)) != std::string::npos; pos = nl + 1)
+                c.flow.onLine(std::string_view(c.in).substr(pos, nl - pos), now, stats);
+            c.in.erase(0, pos);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+}
+
+// Sessions first, first + step, ... of config.sessions, on one epoll set.
+void worker(const Config &config,
+            size_t        first,
+            size_t        step,
+            Stats        &stats,
+            size_t       &connected,
+            std::string  &error) {
+    std::vector<std::unique_ptr<Connection>> conns;
+    int                                      ep = epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0) {
+        error = std::string("epoll_create1: ") + std::strerror(errno);
+        return;
+    }
+    for (size_t i = first; i < config.sessions; i += step) {
+        auto c = std::make_unique<Connection>(config, i);
+        c->fd  = connectTo(config, error);
+        if (c->fd < 0)
+            break;
+        epoll_event ev{};
+        ev.events   = EPOLLIN;
+        ev.data.u64 = conns.size();
+        epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev);
+        c->out = c->flow.hello();
+        flush(*c);
+        conns.push_back(std::move(c));
+    }
+    connected = conns.size();
+
+    using clock = std::chrono::steady_clock;
+
+    // a token bucket shared by this thread's sessions, handed out round robin
+    double   perSecond = config.rate / static_cast<double>(step);
+    double   tokens    = 0;
+    size_t   cursor    = 0;
+    auto     last      = clock::now();
+    auto     deadline  = last + config.duration;
+    size_t   open      = conns.size();
+    uint64_t now       = 0;
+
+    std::vector<epoll_event> events(256);
+    while (open > 0) {
+        auto t = clock::now();
+        if (t >= deadline)
+            break;
+        tokens += std::chrono::duration<double>(t - last).count() * perSecond;
+        tokens  = std::min(tokens, static_cast<double>(conns.size() * config.pipeline));
+        last    = t;
+
+        now          = utils::tsc();
+        size_t tried = 0;
+        while ((config.rate <= 0 || tokens >= 1) && tried < conns.size()) {
+            Connection &c = *conns[cursor];
+            cursor        = (cursor + 1) % conns.size();
+            // one request per session per turn spreads the sends over the sessions
+            if (c.open && c.flow.next(c.out, now, stats)) {
+                tokens -= 1;
+                tried = 0;
+                continue;
+            }
+            ++tried;
+        }
+
+        for (auto &c : conns)
+            if (c->open && !c->out.empty() && !flush(*c)) {
+                c->open = false;
+                --open;
+            }
+
+        int n = epoll_wait(ep, events.data(), static_cast<int>(events.size()), 1);
+        for (int k = 0; k < n; ++k) {
+            Connection &c = *conns[events[k].data.u64];
+            if (c.open && !drain(c, stats)) {
+                c.open = false;
+                --open;
+            }
+        }
+    }
+
+    for (auto &c : conns) ::close(c->fd);
+    ::close(ep);
+}
+
+}  // namespace
+
+bool parseOption(std::string_view arg, Config &config, std::string &error) {
+    size_t eq = arg.find('=');
+    if (eq == std::string_view::npos) {
+        error = "expected key=value: " + std::string(arg);
+        return false;
+    }
+    std::string_view key = arg.substr(0, eq), value = arg.substr(eq + 1);
+    int64_t          seconds = 0;
+    bool             ok      = true;
+    if (key == "host")
+        config.host = std::string(value);
+    else if (key == "port")
+        ok = parseNumber(value, config.port);
+    else if (key == "sessions")
+        ok = parseNumber(value, config.sessions) && config.sessions > 0;
+    else if (key == "threads")
+        ok = parseNumber(value, config.threads) && config.threads > 0;
+    else if (key == "symbols")
+        ok = !(config.symbols = splitList(value)).empty();
+    else if (key == "groups")
+        config.groups = splitList(value);
+    else if (key == "passkey")
+        config.passkey = std::string(value);
+    else if (key == "prefix")
+        ok = !(config.prefix = std::string(value)).empty();
+    else if (key == "rate")
+        ok = parseNumber(value, config.rate) && config.rate >= 0;
+    else if (key == "pipeline")
+        ok = parseNumber(value, config.pipeline) && config.pipeline > 0;
+    else if (key == "cancels")
+        ok = parseShare(value, config.cancels);
+    else if (key == "cross")
+        ok = parseShare(value, config.cross);
+    else if (key == "mid")
+        ok = parsePrice(value, config.tick, config.mid) && config.mid > 0;
+    else if (key == "depth")
+        ok = parseNumber(value, config.depth) && config.depth > 0;
+    else if (key == "qty")
+        ok = parseNumber(value, config.maxQty) && config.maxQty > 0;
+    else if (key == "seconds")
+        ok = parseNumber(value, seconds) && seconds > 0 &&
+             (config.duration = std::chrono::seconds(seconds), true);
+    else {
+        error = "unknown option: " + std::string(key);
+        return false;
+    }
+    if (!ok)
+        error = "bad value for " + std::string(key) + ": " + std::string(value);
+    return ok;
+}
+
+void Stats::add(const Stats &other) {
+    ack.add(other.ack);
+    cancel.add(other.cancel);
+    exec.add(other.exec);
+    orders += other.orders;
+    cancels += other.cancels;
+    acks += other.acks;
+    errors += other.errors;
+    executions += other.executions;
+    marketData += other.marketData;
+}
+
+Flow::Flow(const Config &config, size_t index)
+    : config(config),
+      client_id(config.prefix + std::to_string(index)),
+      sym(&config.symbols[index % config.symbols.size()]),
+      rng(index + 1),
+      setup_left(1 + config.groups.size()) {}
+
+std::string Flow::hello() const {
+    std::string out = protocol::auth(config.passkey, client_id);
+    for (auto &g : config.groups) out += protocol::subscribe(g);
+    return out;
+}
+
+bool Flow::next(std::string &out, uint64_t now, Stats &stats) {
+    if (!ready() || pending.size() >= config.pipeline)
+        return false;
+
+    std::uniform_real_distribution<double> unit(0, 1);
+    if (!resting_ids.empty() && unit(rng) < config.cancels) {
+        size_t k = rng() % resting_ids.size();
+        std::swap(resting_ids[k], resting_ids.back());
+        OrderId id = resting_ids.back();
+        resting_ids.pop_back();
+        out += protocol::cancel(*sym, id);
+        pending.push_back(Pending{true, false, id, now});
+        ++stats.cancels;
+        return true;
+    }
+
+    // passive orders rest within `depth` ticks of mid and never meet each other;
+    // crossing ones are priced `depth` through it and sweep whatever rests there
+    Side  side     = rng() % 2 ? Side::Buy : Side::Sell;
+    bool  crossing = unit(rng) < config.cross;
+    int   offset   = crossing ? -config.depth : 1 + static_cast<int>(rng() % config.depth);
+    Price price    = side == Side::Buy ? config.mid - offset : config.mid + offset;
+    int   qty      = 1 + static_cast<int>(rng() % config.maxQty);
+    out += protocol::newLimit(side,
+                              *sym,
+                              qty,
+                              formatPrice(std::max<Price>(price, 1), config.tick),
+                              crossing ? TimeInForce::IOC : TimeInForce::GTC);
+    pending.push_back(Pending{false, crossing, 0, now});
+    ++stats.orders;
+    return true;
+}
+
+void Flow::onLine(std::string_view line, uint64_t now, Stats &stats) {
+    protocol::Reply r = protocol::parseReply(line);
+    switch (r.kind) {
+        case protocol::ReplyKind::Auth:
+        case protocol::ReplyKind::Subscribed:
+            if (setup_left > 0)
+                --setup_left;
+            return;
+        case protocol::ReplyKind::RequestMade: {
+            if (pending.empty() || pending.front().cancel)
+                return;
+            const Pending &head = pending.front();
+            stats.ack.record(now - head.sent);
+            ++stats.acks;
+            if (head.crossing) {
+                last_ioc = r.id;
+            } else {
+                if (resting_ids.size() >= MAX_RESTING)
+                    resting_ids.erase(resting_ids.begin());
+                resting_ids.push_back(r.id);
+            }
+            pending.pop_front();
+            return;
+        }
+        case protocol::ReplyKind::Cancelled:
+            if (r.id == last_ioc) {
+                last_ioc = 0;
+                return;
+            }
+            if (pending.empty() || !pending.front().cancel)
+                return;
+            stats.cancel.record(now - pending.front().sent);
+            ++stats.acks;
+            pending.pop_front();
+            return;
+        case protocol::ReplyKind::Error:
+            ++stats.errors;
+            if (ready() && !pending.empty())
+                pending.pop_front();
+            return;
+        case protocol::ReplyKind::Exec:
+            ++stats.executions;
+            // the engine sends a crossing order's executions before its ack
+            if (!pending.empty() && pending.front().crossing && !pending.front().filled) {
+                stats.exec.record(now - pending.front().sent);
+                pending.front().filled = true;
+            }
+            return;
+        default:
+            ++stats.marketData;
+            return;
+    }
+}
+
+bool run(const Config &config, Stats &stats, double &elapsed, std::string &error) {
+    size_t                   threads = std::clamp<size_t>(config.threads, 1, config.sessions);
+    std::vector<Stats>       perThread(threads);
+    std::vector<size_t>      connected(threads, 0);
+    std::vector<std::string> errors(threads);
+
+    auto                     start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t)
+        pool.emplace_back(worker,
+                          std::cref(config),
+                          t,
+                          threads,
+                          std::ref(perThread[t]),
+                          std::ref(connected[t]),
+                          std::ref(errors[t]));
+    for (auto &t : pool) t.join();
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t total = 0;
+    for (size_t t = 0; t < threads; ++t) {
+        stats.add(perThread[t]);
+        total += connected[t];
+        if (error.empty())
+            error = errors[t];
+    }
+    if (total == 0)
+        return false;
+    if (total < config.sessions)
+        error = std::to_string(total) + " of " + std::to_string(config.sessions) +
+                " sessions connected (" + error + ")";
+    else
+        error.clear();
+    return true;
+}
+
+}  // namespace loadgen
@@ -0,0 +1,87 @@
+#include <sys/resource.h>
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "loadgen.hpp"
+#include "utils/tsc.hpp"
+
+static void printLatency(const char* name, const utils::Histogram& h) {
+    auto us = [](uint64_t ticks) { return utils::ticksToNs(ticks) / 1000.0; };
+    std::printf("%-8s%10llu%10.1f%10.1f%10.1f%10.1f%10.1f\n",
+                name,
+                static_cast<unsigned long long>(h.count()),
+                us(h.percentile(50)),
+                us(h.percentile(90)),
+                us(h.percentile(99)),
+                us(h.percentile(99.9)),
+                us(h.max()));
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <port> [key=value ...]\n"
+                  << "  host=127.0.0.1 sessions=100 threads=1 symbols=TSLA groups=L1,L2\n"
+                  << "  passkey=pawy prefix=LG rate=1000 pipeline=8 cancels=0.3 cross=0.1\n"
+                  << "  mid=100.00 depth=20 qty=10 seconds=10\n";
+        return 1;
+    }
+
+    loadgen::Config config;
+    std::string     error;
+    if (!loadgen::parseOption(std::string("port=") + argv[1], config, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    for (int i = 2; i < argc; ++i) {
+        if (!loadgen::parseOption(argv[i], config, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+    }
+
+    // a socket per session; thousands of them need more than the usual soft limit
+    rlimit files{};
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max) {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+    utils::nsPerTick();
+
+    loadgen::Stats stats;
+    double         elapsed = 0;
+    if (!loadgen::run(config, stats, elapsed, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    if (!error.empty())
+        std::cerr << error << "\n";
+
+    double span = elapsed > 0 ? elapsed : 1;
+    std::printf("%zu sessions, %.1fs: %llu orders, %llu cancels, %llu acks (%.0f/s), "
+                "%llu errors, %llu executions (%.0f/s), %llu market data lines (%.0f/s)\n",
+                config.sessions,
+                elapsed,
+                static_cast<unsigned long long>(stats.orders),
+                static_cast<unsigned long long>(stats.cancels),
+                static_cast<unsigned long long>(stats.acks),
+                stats.acks / span,
+                static_cast<unsigned long long>(stats.errors),
+                static_cast<unsigned long long>(stats.executions),
+                stats.executions / span,
+                static_cast<unsigned long long>(stats.marketData),
+                stats.marketData / span);
+    std::printf("%-8s%10s%10s%10s%10s%10s%10s\n",
+                "(us)",
+                "count",
+                "p50",
+                "p90",
+                "p99",
+                "p99.9",
+                "max");
+    printLatency("ack", stats.ack);
+    printLatency("cancel", stats.cancel);
+    printLatency("exec", stats.exec);
+    return 0;
+}
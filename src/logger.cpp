@@ -0,0 +1,251 @@
+#include "logger.hpp"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "utils/spsc_ring.hpp"
+
+namespace logging {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr size_t RING_RECORDS = 1024;  // per thread
+constexpr auto   IDLE_SLEEP   = 1ms;
+
+constexpr const char *LEVEL_NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+// One logging thread's ring. Owned by the logger, so records left in it when
+// the thread exits are still written and the memory is freed afterwards.
+struct Producer {
+    utils::SpscRing<Record> ring{RING_RECORDS};
+    std::atomic<uint64_t>   dropped{0};
+    std::atomic<bool>       retired{false};
+};
+
+// "YYYY-mm-dd HH:MM:SS.mmm", the calendar part converted once per second.
+class Clock {
+   public:
+    void append(std::string &out, uint64_t ns) {
+        time_t secs = static_cast<time_t>(ns / 1000000000);
+        if (secs != cached || length == 0) {
+            tm local{};
+            localtime_r(&secs, &local);
+            length = strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+            cached = secs;
+        }
+        char millis[8];
+        std::snprintf(millis, sizeof(millis), ".%03u", static_cast<unsigned>(ns / 1000000 % 1000));
+        out.append(text, length);
+        out.append(millis);
+    }
+
+   private:
+    time_t cached = 0;
+    char   text[32];
+    size_t length = 0;
+};
+
+void appendArg(std::string &out, const Record &r, const Arg &a) {
+    char buf[32];
+    switch (a.type) {
+        case Arg::Type::Int:
+            out.append(buf, std::to_chars(buf, buf + sizeof(buf), a.i).ptr);
+            break;
+        case Arg::Type::Uint:
+            out.append(buf, std::to_chars(buf, buf + sizeof(buf), a.u).ptr);
+            break;
+        case Arg::Type::Double:
+            out.append(buf, std::to_chars(buf, buf + sizeof(buf), a.d).ptr);
+            break;
+        case Arg::Type::Bool:
+            out.append(a.u ? "true" : "false");
+            break;
+        case Arg::Type::Text:
+            out.append(r.text + a.text.offset, a.text.length);
+            break;
+        case Arg::Type::Errno:
+            out.append(std::strerror(static_cast<int>(a.i)));
+            break;
+    }
+}
+
+void render(std::string &out, const Record &r, Clock &clock) {
+    clock.append(out, r.ns);
+    out += " [";
+    out += LEVEL_NAMES[static_cast<size_t>(r.level)];
+    out += "] ";
+
+    // `{}` takes the next argument; without one it is printed as is
+    size_t next = 0;
+    for (const char *p = r.format; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}' && next < r.count) {
+            appendArg(out, r, r.args[next++]);
+            ++p;
+        } else {
+            out += *p;
+        }
+    }
+}
+
+uint64_t now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count());
+}
+
+void writeAll(int fd, const std::string &data) {
+    for (size_t done = 0; done < data.size();) {
+        ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return;  // nowhere left to report it
+        }
+        done += static_cast<size_t>(n);
+    }
+}
+
+class Logger {
+   public:
+    static Logger &instance() {
+        static Logger logger;
+        return logger;
+    }
+
+    ~Logger() {
+        stopping.store(true, std::memory_order_release);
+        if (thread.joinable())
+            thread.join();
+        pass();  // whatever came in after the thread's last pass
+    }
+
+    Producer *attach() {
+        std::lock_guard lock(mutex);
+        producers.push_back(std::make_unique<Producer>());
+        if (!thread.joinable())
+            thread = std::thread([this] { run(); });
+        return producers.back().get();
+    }
+
+    void flush() {
+        {
+            std::lock_guard lock(mutex);
+            if (!thread.joinable())
+                return;
+        }
+        // the pass running now may have started before the call
+        uint64_t target = passes.load(std::memory_order_acquire) + 2;
+        while (passes.load(std::memory_order_acquire) < target)
+            std::this_thread::sleep_for(IDLE_SLEEP / 4);
+    }
+
+    void setOutput(int infoFd, int errorFd) {
+        flush();
+        fds[0].store(infoFd, std::memory_order_relaxed);
+        fds[1].store(errorFd, std::memory_order_relaxed);
+    }
+
+   private:
+    Logger() = default;
+
+    void run() {
+        while (!stopping.load(std::memory_order_acquire)) {
+            if (!pass())
+                std::this_thread::sleep_for(IDLE_SLEEP);
+        }
+    }
+
+    // Drains every ring once and writes what it found. False if there was nothing.
+    bool pass() {
+        out[0].clear();
+        out[1].clear();
+        {
+            std::lock_guard lock(mutex);
+            for (auto it = producers.begin(); it != producers.end();) {
+                Producer &p = **it;
+                // read before draining: records pushed before retiring are then seen
+                bool retired = p.retired.load(std::memory_order_acquire);
+                while (p.ring.tryPop(record)) {
+                    std::string &to = out[record.level >= Level::Warn];
+                    render(to, record, clock);
+                    to += '\n';
+                }
+                if (uint64_t lost = p.dropped.exchange(0, std::memory_order_relaxed)) {
+                    Record note{};
+                    note.ns     = now();
+                    note.format = "logger: {} messages dropped, ring full";
+                    note.level  = Level::Warn;
+                    detail::encode(note, lost);
+                    render(out[1], note, clock);
+                    out[1] += '\n';
+                }
+                if (retired)
+                    it = producers.erase(it);
+                else
+                    ++it;
+            }
+        }
+        for (int i = 0; i < 2; ++i) {
+            if (!out[i].empty())
+                writeAll(fds[i].load(std::memory_order_relaxed), out[i]);
+        }
+        passes.fetch_add(1, std::memory_order_release);
+        return !out[0].empty() || !out[1].empty();
+    }
+
+    std::mutex                             mutex;  // guards producers and the thread
+    std::vector<std::unique_ptr<Producer>> producers;
+    std::thread                            thread;
+    std::atomic<bool>                      stopping{false};
+    std::atomic<uint64_t>                  passes{0};
+    std::atomic<int>                       fds[2]{STDOUT_FILENO, STDERR_FILENO};
+
+    // background thread only
+    Record      record{};
+    Clock       clock;
+    std::string out[2];
+};
+
+// The calling thread's producer, registered on its first message.
+struct Handle {
+    Producer *producer = Logger::instance().attach();
+
+    ~Handle() { producer->retired.store(true, std::memory_order_release); }
+};
+
+}  // namespace
+
+void submit(const Record &record) noexcept {
+    thread_local Handle handle;
+    Record              copy = record;
+    if (!handle.producer->ring.tryPush(std::move(copy)))
+        handle.producer->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void flush() {
+    Logger::instance().flush();
+}
+
+void setOutput(int infoFd, int errorFd) {
+    Logger::instance().setOutput(infoFd, errorFd);
+}
+
+std::string format(const Record &record) {
+    Clock       clock;
+    std::string out;
+    render(out, record, clock);
+    return out;
+}
+
+}  // namespace logging
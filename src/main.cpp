@@ -1,30 +1,88 @@
 #include <iostream>
+#include <thread>
+#include <vector>
 
+#include "config.hpp"
+#include "logger.hpp"
 #include "network.hpp"
 #include "notifier.hpp"
 
 int main(int argc, char** argv) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <port>\n";
+        std::cerr << "Usage: " << argv[0]
+                  << " <port> [avl|ladder|instruments_file] [engines] [reactors] [md_interval_us]"
+                     " [journal_dir] [snapshot_s]\n";
         return 1;
     }
     uint16_t port = static_cast<uint16_t>(std::stoi(argv[1]));
 
-    Server            srv(port);
-    const std::string TSLA = "TSLA";
-
-    srv.manager.new_instrument(TSLA);
+    // instruments come from a file (see config.hpp); without one there is
+    // just TSLA, quoted in cents, on the book type asked for
+    std::vector<InstrumentSpec> specs;
+    std::string                 book = argc >= 3 ? argv[2] : "avl";
+    if (book == "avl" || book == "ladder") {
+        InstrumentSpec tsla{.symbol = "TSLA", .tick = TickSize{2, 1}, .book = BookSpec{}};
+        if (book == "ladder") {
+            tsla.book.type      = BookType::Ladder;
+            tsla.book.basePrice = 1;
+            tsla.book.levels    = 1 << 16;
+        }
+        specs.push_back(tsla);
+    } else if (std::string error; !config::loadInstruments(book, specs, error)) {
+        LOG_ERROR("{}", error);
+        logging::flush();
+        return 1;
+    }
 
-    Notifier::instance().registerGroup("L1");
-    Notifier::instance().registerGroup("L2");
-    Notifier::instance().registerGroup("L3");
+    // matching threads; instruments are spread across them
+    size_t engines = argc >= 4 ? std::stoul(argv[3]) : 1;
+    // network threads; each accepts on its own SO_REUSEPORT socket
+    size_t reactors = std::max<size_t>(argc >= 5 ? std::stoul(argv[4]) : 1, 1);
+    // minimum gap between two market data updates of an engine; 0 sends one per matching burst
+    std::chrono::microseconds mdInterval{argc >= 6 ? std::stoul(argv[5]) : 0};
 
-    if (!srv.start()) {
-        std::cerr << "Failed to start server\n";
+    Manager manager;
+    for (auto& spec : specs) manager.new_instrument(spec);
+    // resting orders survive a restart: the books are restored from their
+    // snapshots and the journal after them is replayed, then appended to
+    if (argc >= 7)
+        manager.recover(argv[6],
+                        argc >= 8 ? std::chrono::seconds(std::stoul(argv[7]))
+                                  : Manager::DEFAULT_SNAPSHOT);
+    // calibrates the latency clock up front rather than in the first DEBUG STATS
+    utils::nsPerTick();
+    if (!manager.start(engines, reactors, mdInterval)) {
+        LOG_ERROR("Failed to start engines");
+        logging::flush();
         return 1;
     }
 
-    srv.run();
-    srv.stop();
+    std::vector<std::unique_ptr<Server>> servers;
+    for (size_t r = 0; r < reactors; ++r) {
+        auto srv = std::make_unique<Server>(port, manager, r);
+
+        srv->notifier().registerGroup("L1");
+        srv->notifier().registerGroup("L2");
+        srv->notifier().registerGroup("L3");
+
+        if (!srv->start()) {
+            LOG_ERROR("Failed to start server");
+            logging::flush();
+            return 1;
+        }
+        servers.push_back(std::move(srv));
+    }
+
+    // reactor 0 runs on the main thread
+    std::vector<std::thread> threads;
+    for (size_t r = 1; r < reactors; ++r) threads.emplace_back([&, r] { servers[r]->run(); });
+
+    servers[0]->run();
+    for (auto& srv : servers) srv->request_stop();
+    for (auto& t : threads) t.join();
+
+    for (auto& srv : servers) srv->stop();
+    manager.stop();
+    logging::flush();
     return 0;
-}
\ No newline at end of file
+}
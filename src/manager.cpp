@@ -1,10 +1,154 @@
 #include "manager.hpp"
 
-bool Manager::new_instrument(std::string symbol) {
-    if (instruments_.find(symbol) != instruments_.end())
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <filesystem>
+#include <unordered_map>
+
+#include "logger.hpp"
+#include "snapshot.hpp"
+
+Manager::~Manager() {
+    stop();
+}
+
+bool Manager::new_instrument(const InstrumentSpec &spec) {
+    // adopting would touch a running engine's state from this thread, and
+    // growing the tables could move them under a reactor inside route()
+    if (!engines_.empty() || symbols_.find(spec.symbol) != NO_SYMBOL)
         return false;
 
-    instruments_[symbol] = std::make_shared<Instrument>(symbol);
+    SymbolId id = symbols_.intern(spec.symbol);
+    instruments_.push_back(makeInstrument(spec));
+    routes_.push_back(Route{instruments_.back().get(), nullptr, id});
+    pinned_.push_back(spec.engine);
+    return true;
+}
+
+bool Manager::start(size_t engineCount, size_t reactorCount, std::chrono::microseconds mdInterval) {
+    if (!engines_.empty())
+        return true;
 
+    for (size_t i = 0; i < std::max<size_t>(reactorCount, 1); ++i) {
+        int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd < 0) {
+            LOG_ERROR("eventfd: {}", logging::sysError());
+            stop();
+            return false;
+        }
+        wake_fds_.push_back(fd);
+        reactor_stats_.push_back(std::make_unique<LatencyStats>());
+    }
+
+    uint64_t epoch = journal_dir_.empty() ? 0 : journal::nextEpoch(journal_dir_);
+    for (size_t i = 0; i < std::max<size_t>(engineCount, 1); ++i) {
+        engines_.push_back(std::make_unique<Engine>(wake_fds_, mdInterval));
+        if (journal_dir_.empty())
+            continue;
+
+        auto wal = std::make_unique<journal::Journal>(journal_dir_, epoch, i);
+        if (!wal->open()) {
+            stop();
+            return false;
+        }
+        engines_.back()->setJournal(std::move(wal), snapshot_every_);
+    }
+
+    for (SymbolId id = 0; id < instruments_.size(); ++id) assign(id);
+
+    for (auto &e : engines_) e->start();
     return true;
-}
\ No newline at end of file
+}
+
+void Manager::recover(const std::string &dir, std::chrono::seconds snapshotEvery) {
+    // where each book stands after its snapshot; the journal is replayed from there
+    struct Restored {
+        Instrument       *instrument;
+        journal::Position at;
+    };
+    std::unordered_map<std::string, Restored> books;
+    uint64_t                                  fromEpoch = instruments_.empty() ? 0 : UINT64_MAX;
+    size_t                                    loaded    = 0;
+    for (auto &instrument : instruments_) {
+        const std::string &symbol = instrument->getSymbol();
+        journal::Position  at;
+        std::string        path = snapshot::pathFor(dir, symbol);
+        if (std::filesystem::exists(path) && snapshot::load(*instrument, path, at))
+            ++loaded;
+        books[symbol.substr(0, journal::SYMBOL_LEN)] = {instrument.get(), at};
+        fromEpoch = std::min(fromEpoch, at.epoch);
+    }
+
+    size_t applied = 0, covered = 0, diverged = 0, orphans = 0;
+    journal::read(
+            dir,
+            [&](const journal::Position &at, const journal::Record &r) {
+                auto it = books.find(std::string(journal::field(r.symbol, journal::SYMBOL_LEN)));
+                if (it == books.end()) {
+                    ++orphans;
+                    return;
+                }
+                if (journal::covers(it->second.at, at)) {
+                    ++covered;
+                    return;
+                }
+                if (!journal::apply(r, *it->second.instrument))
+                    ++diverged;
+                ++applied;
+            },
+            fromEpoch);
+
+    LOG_INFO("Journal: {} snapshots loaded, replayed {} records from {}, {} already in "
+             "snapshots, {} for unknown symbols skipped",
+             loaded,
+             applied,
+             dir,
+             covered,
+             orphans);
+    if (diverged)
+        LOG_WARN("Journal: {} records did not reproduce", diverged);
+
+    // with every book restored from a snapshot, the epochs before the oldest
+    // of them hold nothing a later recovery would replay
+    if (loaded == instruments_.size()) {
+        if (size_t removed = journal::removeBefore(dir, fromEpoch))
+            LOG_INFO("Journal: removed {} segments before epoch {}", removed, fromEpoch);
+    }
+
+    journal_dir_    = dir;
+    snapshot_every_ = snapshotEvery;
+}
+
+void Manager::stop() {
+    for (auto &e : engines_) e->stop();
+    for (auto &instrument : instruments_) instrument->setListener(nullptr);
+    for (auto &route : routes_) route.engine = nullptr;
+    engines_.clear();
+    next_engine_ = 0;
+
+    for (int fd : wake_fds_) close(fd);
+    wake_fds_.clear();
+    reactor_stats_.clear();
+}
+
+bool Manager::publish(size_t reactor, std::string group, std::string text) {
+    // any engine can do the fan-out; it already has a ring to every reactor
+    if (engines_.empty())
+        return false;
+
+    EngineCommand cmd;
+    cmd.kind  = EngineCommand::Kind::Publish;
+    cmd.group = std::move(group);
+    cmd.text  = std::move(text);
+    return engines_.front()->submit(reactor, std::move(cmd));
+}
+
+void Manager::assign(SymbolId id) {
+    size_t  shard  = pinned_[id] != InstrumentSpec::ANY_ENGINE ? pinned_[id] : next_engine_++;
+    Engine *engine = engines_[shard % engines_.size()].get();
+    engine->adopt(*instruments_[id]);
+    routes_[id].engine = engine;
+}
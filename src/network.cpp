@@ -6,21 +6,30 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstring>
-#include <iostream>
-#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include <utils/string.hpp>
+#include "logger.hpp"
 #include "network.hpp"
-#include "utils/time.hpp"
 
 using namespace std::chrono_literals;
 
 const std::chrono::seconds SESSION_TIMEOUT = 60s;
+// order entry messages a session may send per second, and back to back; a
+// batch counts once per order and must fit in the burst
+constexpr uint32_t ORDER_RATE  = 5000;
+constexpr uint32_t ORDER_BURST = 1000;
+// resolution of the idle timers
+constexpr std::chrono::milliseconds IDLE_TICK = 100ms;
+
+static uint64_t idle_tick(std::chrono::steady_clock::time_point t) {
+    return static_cast<uint64_t>(t.time_since_epoch() / IDLE_TICK);
+}
 
 int set_nonblocking(int fd) {
     int flags = fcntl(fd, F_GETFL, 0);
@@ -35,24 +44,21 @@ static bool verify_token(const std::string &token, const std::string &clientId)
     return true;
 }
 
-int Server::epoll_fd_  = -1;
-int Server::listen_fd_ = -1;
-
-Manager                                         Server::manager;
-std::map<int, std::shared_ptr<Session>>         Server::temp_sessions_;
-std::map<std::string, std::shared_ptr<Session>> Server::sessions_;
-std::unordered_map<std::string, Processor>      Server::processors_;
-
 bool Server::start() {
     listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
     if (listen_fd_ < 0) {
-        perror("socket");
+        LOG_ERROR("socket: {}", logging::sysError());
         return false;
     }
 
     int opt = 1;
     if (setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        perror("setsockopt SO_REUSEADDR");
+        LOG_ERROR("setsockopt SO_REUSEADDR: {}", logging::sysError());
+        return false;
+    }
+    // lets every reactor bind its own listening socket to the port
+    if (setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        LOG_ERROR("setsockopt SO_REUSEPORT: {}", logging::sysError());
         return false;
     }
 
@@ -62,23 +68,23 @@ bool Server::start() {
     addr.sin_port        = htons(port_);
 
     if (bind(listen_fd_, (sockaddr *)&addr, sizeof(addr)) < 0) {
-        perror("bind");
+        LOG_ERROR("bind: {}", logging::sysError());
         return false;
     }
 
     if (listen(listen_fd_, SOMAXCONN) < 0) {
-        perror("listen");
+        LOG_ERROR("listen: {}", logging::sysError());
         return false;
     }
 
     if (set_nonblocking(listen_fd_) < 0) {
-        perror("set_nonblocking");
+        LOG_ERROR("set_nonblocking: {}", logging::sysError());
         return false;
     }
 
     epoll_fd_ = epoll_create1(0);
     if (epoll_fd_ < 0) {
-        perror("epoll_create1");
+        LOG_ERROR("epoll_create1: {}", logging::sysError());
         return false;
     }
 
@@ -86,21 +92,31 @@ bool Server::start() {
     ev.events  = EPOLLIN;
     ev.data.fd = listen_fd_;
     if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev) < 0) {
-        perror("epoll_ctl add listen_fd");
+        LOG_ERROR("epoll_ctl add listen_fd: {}", logging::sysError());
         return false;
     }
 
+    // engines signal this eventfd whenever they have replies or notifications for us
+    ev.events  = EPOLLIN;
+    ev.data.fd = manager.wake_fd(reactor_);
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0) {
+        LOG_ERROR("epoll_ctl add wake_fd: {}", logging::sysError());
+        return false;
+    }
+
+    timers_   = utils::TimerWheel<int>(idle_tick(std::chrono::steady_clock::now()));
+    latency_  = &manager.latency(reactor_);
+    stats_at_ = std::chrono::steady_clock::now();
     load_processors();
 
-    std::cout << now_str() << " Server listening on port " << port_ << "\n";
+    LOG_INFO("Reactor {} listening on port {}", reactor_, port_);
     return true;
 }
 
 void Server::stop() {
-    for (auto &p : temp_sessions_) {
-        p.second->close_fd();
-    }
+    temp_sessions_.forEach([](int, std::shared_ptr<Session> &s) { s->close_fd(); });
     temp_sessions_.clear();
+    timers_ = utils::TimerWheel<int>();
 
     for (auto &p : sessions_) {
         p.second->close_fd();
@@ -120,12 +136,12 @@ void Server::stop() {
 void Server::run() {
     std::vector<epoll_event> events(max_events_);
 
-    while (true) {
+    while (running_.load(std::memory_order_relaxed)) {
         int n = epoll_wait(epoll_fd_, events.data(), (int)events.size(), 1000);
         if (n < 0) {
             if (errno == EINTR)
                 continue;
-            perror("epoll_wait");
+            LOG_ERROR("epoll_wait: {}", logging::sysError());
             break;
         }
 
@@ -133,21 +149,24 @@ void Server::run() {
             auto &ev = events[i];
             if (ev.data.fd == listen_fd_) {
                 accept_new();
+            } else if (ev.data.fd == manager.wake_fd(reactor_)) {
+                drain_engines();
             } else {
                 int fd = ev.data.fd;
 
                 if (ev.events & (EPOLLERR | EPOLLHUP)) {
-                    std::cerr << now_str() << " [INFO] Closing session on fd " << fd
-                              << " due to EPOLLERR/HUP (peer closed or socket error)\n";
+                    LOG_INFO("Closing session on fd {} due to EPOLLERR/HUP "
+                             "(peer closed or socket error)",
+                             fd);
                     remove_session(fd);
                     continue;
                 }
 
                 if (ev.events & EPOLLIN) {
                     if (!handle_read(fd)) {
-                        std::cerr << now_str() << " [INFO] Closing session on fd " << fd
-                                  << " due to read failure or orderly shutdown (handle_read "
-                                     "returned false)\n";
+                        LOG_INFO("Closing session on fd {} due to read failure or orderly "
+                                 "shutdown (handle_read returned false)",
+                                 fd);
                         remove_session(fd);
                         continue;
                     }
@@ -155,8 +174,9 @@ void Server::run() {
 
                 if (ev.events & EPOLLOUT) {
                     if (!handle_write(fd)) {
-                        std::cerr << now_str() << " [INFO] Closing session on fd " << fd
-                                  << " due to write failure (handle_write returned false)\n";
+                        LOG_INFO("Closing session on fd {} due to write failure "
+                                 "(handle_write returned false)",
+                                 fd);
                         remove_session(fd);
                         continue;
                     }
@@ -164,6 +184,8 @@ void Server::run() {
             }
         }
 
+        // everything queued during this iteration goes out in one write per session
+        flush_dirty();
         cleanup_stale();
     }
 }
@@ -176,53 +198,53 @@ void Server::accept_new() {
         if (client_fd < 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK)
                 break;
-            perror("accept4");
+            LOG_ERROR("accept4: {}", logging::sysError());
             break;
         }
 
         char ipbuf[INET_ADDRSTRLEN];
         inet_ntop(AF_INET, &client.sin_addr, ipbuf, sizeof(ipbuf));
         uint16_t rport = ntohs(client.sin_port);
-        std::cout << now_str() << " Accepted " << ipbuf << ":" << rport << " fd=" << client_fd
-                  << "\n";
+        LOG_INFO("Accepted {}:{} fd={}", ipbuf, rport, client_fd);
 
-        auto s = std::make_shared<Session>(client_fd, SESSION_TIMEOUT);
+        auto s      = std::make_shared<Session>(client_fd, next_serial_++, SESSION_TIMEOUT);
+        s->throttle = risk::Throttle(ORDER_RATE, ORDER_BURST);
 
-        temp_sessions_[client_fd] = s;
+        temp_sessions_.insert(client_fd, s);
 
         epoll_event ev{};
         ev.events  = EPOLLIN;
         ev.data.fd = client_fd;
         if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
-            perror("epoll_ctl add client_fd");
+            LOG_ERROR("epoll_ctl add client_fd: {}", logging::sysError());
             s->close_fd();
             temp_sessions_.erase(client_fd);
             continue;
         }
+        schedule_idle(s);
     }
 }
 
 bool Server::handle_read(int fd) {
-    auto it = temp_sessions_.find(fd);
-    if (it == temp_sessions_.end())
+    auto *slot = temp_sessions_.find(fd);
+    if (!slot)
         return false;
 
-    auto s = it->second;
+    auto s = *slot;
     char buf[4096];
     while (true) {
-        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        uint64_t start = utils::tsc();
+        ssize_t  n     = recv(fd, buf, sizeof(buf), 0);
         if (n > 0) {
+            read_tsc_ = utils::tsc();
+            latency_->record(Stage::Read, start, read_tsc_);
             s->inbuf.append(buf, buf + n);
             s->touch();
 
-            std::string clientId = "";
-            if (s->is_authenticated) {
-                clientId = s->client_id;
-            }
-
-            process_session_messages(fd, clientId);
+            if (!process_session_messages(fd))
+                return false;
         } else if (n == 0) {
-            std::cout << now_str() << " fd=" << fd << " closed by peer\n";
+            LOG_INFO("fd={} closed by peer", fd);
             return false;
         } else {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
@@ -230,45 +252,68 @@ bool Server::handle_read(int fd) {
             } else if (errno == EINTR) {
                 continue;
             } else {
-                perror("recv");
+                LOG_ERROR("recv: {}", logging::sysError());
                 return false;
             }
         }
     }
-
-    if (!s->outbuf.empty()) {
-        modify_epoll_out(fd, true);
-    }
     return true;
 }
 
 bool Server::handle_write(int fd) {
-    auto it = temp_sessions_.find(fd);
-    if (it == temp_sessions_.end())
+    auto *slot = temp_sessions_.find(fd);
+    if (!slot)
         return false;
-    auto s = it->second;
+    return flush_session(*slot);
+}
 
-    while (!s->outbuf.empty()) {
-        ssize_t n = send(fd, s->outbuf.data(), s->outbuf.size(), 0);
-        if (n > 0) {
-            s->outbuf.erase(0, n);
-            s->touch();
-        } else {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                break;
-            } else if (errno == EINTR) {
-                continue;
-            } else {
-                perror("send");
-                return false;
+// Writes what the socket takes. EPOLLOUT stays armed only while output is
+// stuck behind a full socket, so the common case costs no epoll_ctl at all.
+bool Server::flush_session(std::shared_ptr<Session> &s) {
+    for (auto &[key, message] : s->conflated) s->out.append(message);
+    s->conflated.clear();
+
+    size_t   before = s->out.size();
+    uint64_t start  = utils::tsc();
+    auto     status = s->out.flush(s->fd);
+    if (before > 0)
+        latency_->record(Stage::Write, start, utils::tsc());
+    if (s->out.size() < before)
+        s->touch();
+
+    switch (status) {
+        case OutputChain::Status::Error:
+            LOG_ERROR("sendmsg: {}", logging::sysError());
+            return false;
+        case OutputChain::Status::Blocked:
+            if (!s->want_write) {
+                s->want_write = true;
+                modify_epoll_out(s->fd, true);
             }
-        }
+            return true;
+        case OutputChain::Status::Done:
+            if (s->want_write) {
+                s->want_write = false;
+                modify_epoll_out(s->fd, false);
+            }
+            return true;
     }
+    return true;
+}
 
-    if (s->outbuf.empty()) {
-        modify_epoll_out(fd, false);
+void Server::flush_dirty() {
+    for (auto &s : dirty_) {
+        s->dirty = false;
+        // closed meanwhile, or waiting for EPOLLOUT, which will flush it
+        if (s->fd < 0 || s->want_write)
+            continue;
+        int fd = s->fd;
+        if (!flush_session(s)) {
+            LOG_INFO("Closing session on fd {} due to write failure", fd);
+            remove_session(fd);
+        }
     }
-    return true;
+    dirty_.clear();
 }
 
 void Server::modify_epoll_out(int fd, bool enable) {
@@ -277,20 +322,21 @@ void Server::modify_epoll_out(int fd, bool enable) {
     ev.events  = EPOLLIN | (enable ? EPOLLOUT : 0);
     if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) < 0) {
         if (errno != ENOENT)
-            perror("epoll_ctl mod");
+            LOG_ERROR("epoll_ctl mod: {}", logging::sysError());
     }
 }
 
 void Server::remove_session(int fd) {
-    auto it = temp_sessions_.find(fd);
-    if (it == temp_sessions_.end())
+    auto *slot = temp_sessions_.find(fd);
+    if (!slot)
         return;
-    auto s = it->second;
-    // std::cout << now_str() << " Removing session fd=" << fd << "\n";
+    auto s = *slot;
+    LOG_DEBUG("Removing session fd={}", fd);
+    timers_.cancel(s->idle_timer);
 
     if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr) < 0) {
         if (errno != ENOENT)
-            perror("epoll_ctl del");
+            LOG_ERROR("epoll_ctl del: {}", logging::sysError());
     }
 
     if (s->is_authenticated && !s->client_id.empty()) {
@@ -304,70 +350,193 @@ void Server::remove_session(int fd) {
     }
 
     s->close_fd();
-    temp_sessions_.erase(it);
+    temp_sessions_.erase(fd);
 }
 
+// Only sessions whose timer fired are looked at. One that was active since
+// its timer was set goes back on the wheel at its new deadline, so a busy
+// session costs one timer per timeout period however often it is touched.
 void Server::cleanup_stale() {
-    std::vector<int> to_close;
-    for (auto &p : temp_sessions_) {
-        if (p.second->is_stale())
-            to_close.push_back(p.first);
-    }
-    for (int fd : to_close) remove_session(fd);
+    auto now = std::chrono::steady_clock::now();
+    timers_.advance(idle_tick(now), [&](int fd) {
+        auto *slot = temp_sessions_.find(fd);
+        if (!slot)
+            return;
+        auto s = *slot;
+        if (s->deadline() < now) {
+            LOG_INFO("Closing session on fd {} after {}s without traffic", fd, s->timeout.count());
+            remove_session(fd);
+        } else {
+            schedule_idle(s);
+        }
+    });
 }
 
-void Server::process_session_messages(int fd, std::string clientId = "") {
-    auto it = temp_sessions_.find(fd);
-    if (it == temp_sessions_.end())
-        return;
-    auto s = it->second;
+void Server::schedule_idle(std::shared_ptr<Session> &s) {
+    // the tick after the deadline's, so the timer never fires early
+    s->idle_timer = timers_.schedule(idle_tick(s->deadline()) + 1, s->fd);
+}
 
-    while (true) {
-        auto pos = s->inbuf.find('\n');
-        if (pos == std::string::npos)
-            break;
-        std::string line = s->inbuf.substr(0, pos);
-        s->inbuf.erase(0, pos + 1);
+bool Server::process_session_messages(int fd) {
+    auto *slot = temp_sessions_.find(fd);
+    if (!slot)
+        return false;
+    auto         s   = *slot;
+    std::string &buf = s->inbuf;
+
+    // messages are decoded in place; the consumed prefix is dropped once at the end.
+    // The mode is re-checked per message since BINARY switches it mid-buffer.
+    size_t pos = 0;
+    bool   ok  = true;
+    while (pos < buf.size()) {
+        if (s->binary) {
+            if (buf.size() - pos < sizeof(wire::Header))
+                break;
+            wire::Header hdr;
+            std::memcpy(&hdr, buf.data() + pos, sizeof(hdr));
+            if (hdr.length < sizeof(wire::Header) || hdr.length > wire::MAX_INBOUND) {
+                // framing is lost, there is no way to resynchronise; tell the peer and hang up
+                enqueue_reply(fd, s, wire::reject(wire::RejectReason::BadMessage));
+                flush_session(s);
+                ok = false;
+                break;
+            }
+            if (buf.size() - pos < hdr.length)
+                break;
 
-        line = trim(line);
-        if (line.empty())
+            uint64_t start = utils::tsc();
+            dispatch_frame(hdr, buf.data() + pos, fd, s);
+            latency_->record(Stage::Parse, start, utils::tsc());
+            pos += hdr.length;
             continue;
+        }
 
-        auto parts = split_ws(line);
-        if (parts.empty())
-            continue;
+        size_t from = std::max(pos, s->scanned);
+        auto  *nl   = static_cast<char *>(std::memchr(buf.data() + from, '\n', buf.size() - from));
+        if (!nl)
+            break;
 
-        to_upper(parts[0]);
+        size_t      end = nl - buf.data();
+        CommandLine line(buf.data() + pos, end - pos);
+        pos = end + 1;
 
-        for (int i = 0; i < parts.size(); i++) {
-            if (i != 0 && iequals(parts[i - 1], "AUTH"))
-                continue;
-            to_upper(parts[i]);
+        if (!line.empty()) {
+            uint64_t start = utils::tsc();
+            dispatch(line, fd, s);
+            latency_->record(Stage::Parse, start, utils::tsc());
         }
-        dispatch(parts[0], fd, s, parts, clientId);
     }
+
+    buf.erase(0, pos);
+    s->scanned = s->binary ? 0 : buf.size();
+    return ok;
 }
 
-void Server::register_processor(std::string cmd, Processor p) {
-    processors_[cmd] = std::move(p);
+void Server::register_processor(Command cmd, Processor p) {
+    processors_[size_t(cmd)] = std::move(p);
 }
 
-void Server::dispatch(std::string              &cmd,
-                      int                       fd,
-                      std::shared_ptr<Session> &s,
-                      std::vector<std::string> &parts,
-                      std::string               clientId = "") {
-    if (parts.empty())
+void Server::dispatch(const CommandLine &line, int fd, std::shared_ptr<Session> &s) {
+    if (s->batch_left > 0) {
+        batch_line(line, fd, s);
         return;
-    to_upper(cmd);
-    auto it = processors_.find(cmd);
-    if (it != processors_.end())
-        it->second(fd, s, parts, clientId);
+    }
+    const Processor &p = processors_[size_t(line.verb())];
+    if (p)
+        p(fd, s, line, s->client_id);
     else
         enqueue_reply(fd, s, "ERR UNKNOWN_CMD\n");
 }
 
+void Server::drain_engines() {
+    uint64_t signals;
+    if (read(manager.wake_fd(reactor_), &signals, sizeof(signals)) < 0 && errno != EAGAIN)
+        LOG_ERROR("read wake_fd: {}", logging::sysError());
+    manager.drain(reactor_, [this](EngineEvent &ev) {
+        deliver(ev);
+        uint64_t done = utils::tsc();
+        latency_->record(Stage::Enqueue, ev.published, done);
+        if (ev.kind == EngineEvent::Kind::Reply)
+            latency_->record(Stage::Total, ev.replyTo.received, done);
+    });
+}
+
+void Server::deliver(EngineEvent &ev) {
+    switch (ev.kind) {
+        case EngineEvent::Kind::Reply: {
+            auto *slot = temp_sessions_.find(ev.replyTo.fd);
+            if (!slot || (*slot)->serial != ev.replyTo.session)
+                return;  // the requesting connection is gone
+            enqueue_reply(ev.replyTo.fd, *slot, ev.text);
+            return;
+        }
+        case EngineEvent::Kind::User:
+            notifier_.notifyUser(ev.target, ev.text, ev.binary);
+            return;
+        case EngineEvent::Kind::Group:
+            notifier_.notifyGroup(ev.target, ev.payload, ev.key);
+            return;
+    }
+}
+
+bool Server::submit(const Route &route, EngineCommand &&cmd) {
+    cmd.instrument       = route.instrument;
+    cmd.replyTo.received = read_tsc_;
+    return route.engine->submit(reactor_, std::move(cmd));
+}
+
+void Server::enqueue_message(std::shared_ptr<Session> &s,
+                             const std::string        &text,
+                             const std::string        &binary) {
+    if (!s->binary) {
+        enqueue_reply(s->fd, s, text);
+    } else if (!binary.empty()) {
+        enqueue_reply(s->fd, s, binary);
+    } else {
+        std::string framed;
+        wire::appendText(framed, text);
+        enqueue_reply(s->fd, s, framed);
+    }
+}
+
+bool Server::admit(int fd, std::shared_ptr<Session> &s, uint32_t messages) {
+    // last_active is when the request was read, so no clock is read here
+    if (s->throttle.admit(s->last_active, messages))
+        return true;
+    reject(fd, s, wire::RejectReason::Throttled, "ERR THROTTLED\n");
+    return false;
+}
+
+void Server::reject(int                       fd,
+                    std::shared_ptr<Session> &s,
+                    wire::RejectReason        reason,
+                    const std::string        &text) {
+    enqueue_reply(fd, s, s->binary ? wire::reject(reason) : text);
+}
+
+// Only queues; the write happens in flush_dirty() once the current batch of
+// events has been handled.
 void Server::enqueue_reply(int fd, std::shared_ptr<Session> &s, const std::string &reply) {
-    s->outbuf += reply;
-    modify_epoll_out(fd, true);
+    (void)fd;
+    s->out.append(reply);
+    mark_dirty(s);
+}
+
+void Server::enqueue_shared(std::shared_ptr<Session> &s,
+                            const utils::Payload     &message,
+                            const std::string        &key) {
+    if (!key.empty() && s->want_write) {
+        // slow consumer: hold only the newest update, it goes out once the socket drains
+        s->conflated[key] = message;
+        return;
+    }
+    s->out.append(message);
+    mark_dirty(s);
+}
+
+void Server::mark_dirty(std::shared_ptr<Session> &s) {
+    if (!s->dirty) {
+        s->dirty = true;
+        dirty_.push_back(s);
+    }
 }
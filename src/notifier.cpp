@@ -1,40 +1,68 @@
 #include "notifier.hpp"
 
-void Notifier::subscribe(std::string group, std::string clientId) {
-    groups[group].push_back(clientId);
+#include <algorithm>
+
+#include "network.hpp"
+
+void Notifier::subscribe(const std::string &group, const std::shared_ptr<Session> &session) {
+    auto &members = groups[group];
+    if (std::find(members.begin(), members.end(), session) == members.end())
+        members.push_back(session);
 }
 
-void Notifier::unsubscribe(std::string group, std::string clientId) {
-    auto g  = groups[group];
-    auto it = find(g.begin(), g.end(), clientId);
+void Notifier::unsubscribe(const std::string &group, const std::shared_ptr<Session> &session) {
+    auto g = groups.find(group);
+    if (g == groups.end())
+        return;
 
-    if (it == g.end())
+    auto &members = g->second;
+    auto  it      = std::find(members.begin(), members.end(), session);
+    if (it == members.end())
         return;
 
-    g.erase(it);
+    *it = std::move(members.back());
+    members.pop_back();
 }
 
-void Notifier::notifyUser(std::string clientId, std::string message) {
-    auto &sessions = Server::sessions_;
-    if (sessions.find(clientId) == sessions.end()) {
+void Notifier::notifyUser(const std::string &clientId,
+                          const std::string &message,
+                          const std::string &binary) {
+    auto it = server.sessions_.find(clientId);
+    if (it == server.sessions_.end())
         return;
-    }
-
-    auto s = sessions[clientId];
-    Server::enqueue_reply(s->fd, s, message);
+    server.enqueue_message(it->second, message, binary);
 }
 
-void Notifier::notifyGroup(std::string group, std::string message) {
-    auto &sessions = Server::sessions_;
-    if (groups.find(group) == groups.end())
+void Notifier::notifyGroup(const std::string    &group,
+                           const utils::Payload &message,
+                           const std::string    &key) {
+    auto g = groups.find(group);
+    if (g == groups.end() || !message)
         return;
 
-    for (auto &cid : groups[group]) {
-        if (sessions.find(cid) == sessions.end()) {
+    // framed at most once, and only if a binary session is listening
+    utils::Payload framed;
+
+    auto &members = g->second;
+    for (size_t i = 0; i < members.size();) {
+        auto &s = members[i];
+        if (s->fd < 0) {
+            // the connection is gone; order within a group does not matter
+            s = std::move(members.back());
+            members.pop_back();
             continue;
         }
-        auto s = sessions[cid];
-        Server::enqueue_reply(s->fd, s, message);
+        if (s->binary) {
+            if (!framed) {
+                std::string out;
+                wire::appendText(out, *message);
+                framed = utils::makePayload(std::move(out));
+            }
+            server.enqueue_shared(s, framed, key);
+        } else {
+            server.enqueue_shared(s, message, key);
+        }
+        ++i;
     }
 }
 
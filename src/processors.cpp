@@ -1,33 +1,186 @@
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+#include "command.hpp"
 #include "network.hpp"
 #include "notifier.hpp"
+#include "protocol.hpp"
 #include "utils/string.hpp"
 #include "utils/time.hpp"
 
 const std::string DEBUG_SECRET = "123456";
 const std::string EASTER_EGG   = "pawy";
 
+// DEBUG dumps read the book, so they are run as queries on the owning engine.
+static std::string describe_book(Instrument &i) {
+    std::array<DepthLevel, 10> levels;
+    std::ostringstream         oss;
+    oss << "SYM: " << i.getSymbol() << "\n";
+
+    // ascending prices on both sides, as the dump always showed them
+    oss << "    BUY: \n";
+    size_t n = i.copyDepth(Side::Buy, levels.data(), levels.size());
+    while (n > 0) oss << "    " << i.formatPrice(levels[--n].price) << " ";
+    oss << "\n";
+
+    oss << "    SELL: \n";
+    n = i.copyDepth(Side::Sell, levels.data(), levels.size());
+    for (size_t k = 0; k < n; ++k) oss << "    " << i.formatPrice(levels[k].price) << " ";
+    oss << "\n";
+    return oss.str();
+}
+
+static std::string describe_stats(Instrument &i) {
+    std::ostringstream oss;
+    oss << "--------------------------------------\n";
+    oss << i.getSymbol() << ":\n";
+    oss << "    "
+        << "LTP: " << i.formatPrice(i.getLastTradePrice()) << "\n";
+    oss << "    "
+        << "LTS: " << i.getLastTradeSize() << "\n";
+    oss << "    "
+        << "LTT: " << i.getLastTradeTimestamp() << "\n";
+    oss << "    "
+        << "High: " << i.formatPrice(i.getHigh()) << "\n";
+    oss << "    "
+        << "Low: " << i.formatPrice(i.getLow()) << "\n";
+    oss << "    "
+        << "Open: " << i.formatPrice(i.getOpen()) << "\n";
+    oss << "    "
+        << "Close: " << i.formatPrice(i.getClose()) << "\n";
+    oss << "--------------------------------------\n";
+    return oss.str();
+}
+
+// Parses "<BUY|SELL> <SYMBOL> <QTY> <PRICE> [GTC|IOC|FOK]", the line format of
+// a text batch. Returns the reason it is not a valid order, or nullptr.
+static const char *parse_batch_order(const Manager     &manager,
+                                     const CommandLine &parts,
+                                     OrderRequest      &out) {
+    if (parts.size() < 4)
+        return "BAD_COMMAND";
+    if (!parseSide(parts[0], out.side))
+        return "BAD_SIDE";
+
+    const Route *route = manager.route(parts[1]);
+    if (!route)
+        return "BAD_SYMBOL";
+    if (!parseQuantity(parts[2], out.quantity))
+        return "BAD_QTY";
+    if (!route->instrument->parsePrice(parts[3], out.price) || out.price <= 0)
+        return "BAD_PRICE";
+    if (parts.size() > 4 && !parseTimeInForce(parts[4], out.tif))
+        return "BAD_TIF";
+
+    out.symbol = route->instrument->getSymbol();
+    out.type   = OrderType::Limit;
+    return nullptr;
+}
+
+// DEBUG STATS: stage latencies of every reactor and engine together, order and
+// fill rates since the previous STATS on this reactor, and the output still
+// queued for this reactor's sessions.
+std::string Server::describe_latency() {
+    std::array<utils::Histogram, size_t(Stage::Count)> merged;
+    uint64_t                                           orders = 0, executions = 0;
+    manager.forEachLatency([&](const LatencyStats &l) {
+        for (size_t i = 0; i < merged.size(); ++i) merged[i].add(l.stages[i]);
+        orders += l.orders.load(std::memory_order_relaxed);
+        executions += l.executions.load(std::memory_order_relaxed);
+    });
+
+    std::ostringstream oss;
+    char               row[128];
+    oss << "At: " << now_str() << "\n";
+    std::snprintf(row,
+                  sizeof(row),
+                  "%-9s%10s%9s%9s%9s%9s%9s%10s\n",
+                  "Stage(ns)",
+                  "count",
+                  "mean",
+                  "p50",
+                  "p90",
+                  "p99",
+                  "p99.9",
+                  "max");
+    oss << row;
+    auto ns = [](double ticks) { return static_cast<unsigned long long>(utils::ticksToNs(ticks)); };
+    for (size_t i = 0; i < merged.size(); ++i) {
+        const utils::Histogram &h = merged[i];
+        std::snprintf(row,
+                      sizeof(row),
+                      "%-9s%10llu%9llu%9llu%9llu%9llu%9llu%10llu\n",
+                      std::string(STAGE_NAMES[i]).c_str(),
+                      static_cast<unsigned long long>(h.count()),
+                      ns(h.mean()),
+                      ns(h.percentile(50)),
+                      ns(h.percentile(90)),
+                      ns(h.percentile(99)),
+                      ns(h.percentile(99.9)),
+                      ns(h.max()));
+        oss << row;
+    }
+
+    auto   now     = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - stats_at_).count();
+    double span    = seconds > 0 ? seconds : 1;
+    std::snprintf(row,
+                  sizeof(row),
+                  "Orders: %llu (%.1f/s) Fills: %llu (%.1f/s) over %.1fs\n",
+                  static_cast<unsigned long long>(orders),
+                  (orders - stats_orders_) / span,
+                  static_cast<unsigned long long>(executions / 2),
+                  (executions - stats_executions_) / 2 / span,
+                  seconds);
+    oss << row;
+    stats_at_         = now;
+    stats_orders_     = orders;
+    stats_executions_ = executions;
+
+    // largest backlogs first; the conflated updates wait on top of the queued bytes
+    std::vector<std::pair<size_t, std::shared_ptr<Session>>> backlog;
+    size_t                                                   queued = 0;
+    temp_sessions_.forEach([&](int, std::shared_ptr<Session> &each) {
+        size_t bytes = each->out.size();
+        queued += bytes;
+        if (bytes > 0 || !each->conflated.empty())
+            backlog.emplace_back(bytes, each);
+    });
+    std::sort(backlog.begin(), backlog.end(), [](auto &a, auto &b) { return a.first > b.first; });
+    oss << "Backlog on reactor " << reactor_ << ": " << queued << " bytes in " << backlog.size()
+        << " of " << temp_sessions_.size() << " sessions\n";
+    constexpr size_t SHOWN = 10;
+    for (size_t k = 0; k < backlog.size() && k < SHOWN; ++k) {
+        auto &[bytes, each] = backlog[k];
+        std::string who     = each->client_id.empty() ? "fd=" + std::to_string(each->fd)
+                                                      : each->client_id;
+        oss << "    " << who << " " << bytes << " bytes"
+            << (each->want_write ? ", socket full" : "") << ", " << each->conflated.size()
+            << " conflated\n";
+    }
+    if (backlog.size() > SHOWN)
+        oss << "    ... " << backlog.size() - SHOWN << " more\n";
+    return oss.str();
+}
+
 void Server::load_processors() {
-    const std::string PING  = "PING";
-    const std::string DEBUG = "DEBUG";
-    const std::string NEWL  = "NEWL";
-    const std::string AUTH  = "AUTH";
-    const std::string SEND  = "SEND";
-    const std::string SUB   = "SUB";
-
-    register_processor(PING,
-                       [](int                       fd,
-                          std::shared_ptr<Session> &s,
-                          std::vector<std::string> &parts,
-                          std::string               clientId) {
+    register_processor(Command::Ping,
+                       [&](int                       fd,
+                           std::shared_ptr<Session> &s,
+                           const CommandLine        &parts,
+                           const std::string        &clientId) {
                            (void)parts;
                            enqueue_reply(fd, s, "PONG\n");
                        });
 
-    register_processor(DEBUG,
+    register_processor(Command::Debug,
                        [&](int                       fd,
                            std::shared_ptr<Session> &s,
-                           std::vector<std::string> &parts,
-                           std::string               clientId) {
+                           const CommandLine        &parts,
+                           const std::string        &clientId) {
                            if (parts.size() >= 3 && parts[1] == "AUTH") {
                                if (parts[2] == DEBUG_SECRET) {
                                    s->is_authenticated = true;
@@ -52,59 +205,38 @@ void Server::load_processors() {
                                }
 
                                if (parts.size() >= 2 && parts[1] == "ORDERS") {
-                                   std::ostringstream oss;
-                                   oss << "At: " << now_str() << "\n";
-                                   for (auto &[sym, i] : manager.instruments_) {
-                                       oss << "SYM: " << sym << "\n";
-                                       oss << "    BUY: \n";
-                                       auto bs = i->getBuySide();
-                                       bs.avl.inorder(
-                                               bs.root,
-                                               [&](PriceLevelNode *node) {
-                                                   oss << "    " << node->price << " ";
-                                               },
-                                               10);
-                                       oss << "\n";
-
-                                       oss << "    SELL: \n";
-                                       auto ss = i->getSellSide();
-                                       ss.avl.inorder(
-                                               ss.root,
-                                               [&](PriceLevelNode *node) {
-                                                   oss << "    " << node->price << " ";
-                                               },
-                                               10);
-                                       oss << "\n";
+                                   enqueue_reply(fd, s, "At: " + now_str() + "\n");
+                                   for (auto &route : manager.routes()) {
+                                       const std::string &sym = route.instrument->getSymbol();
+
+                                       EngineCommand cmd;
+                                       cmd.kind    = EngineCommand::Kind::Query;
+                                       cmd.replyTo = {reactor_, fd, s->serial};
+                                       cmd.query   = describe_book;
+                                       if (!submit(route, std::move(cmd)))
+                                           enqueue_reply(fd, s, "ERR BUSY " + sym + "\n");
                                    }
-
-                                   enqueue_reply(fd, s, oss.str());
                                }
 
+                               if (parts.size() >= 2 && parts[1] == "STATS")
+                                   enqueue_reply(fd, s, describe_latency());
+
                                if (parts.size() >= 2 && parts[1] == "INSTRUMENTS") {
                                    std::ostringstream oss;
                                    oss << "At: " << now_str() << "\n";
                                    oss << "Instruments(" << manager.instruments_.size() << ")\n";
-                                   for (auto &i : manager.instruments_) {
-                                       oss << "--------------------------------------\n";
-                                       oss << i.first << ":\n";
-                                       oss << "    "
-                                           << "LTP: " << i.second->getLastTradePrice() << "\n";
-                                       oss << "    "
-                                           << "LTS: " << i.second->getLastTradeSize() << "\n";
-                                       oss << "    "
-                                           << "LTT: " << i.second->getLastTradeTimestamp() << "\n";
-                                       oss << "    "
-                                           << "High: " << i.second->getHigh() << "\n";
-                                       oss << "    "
-                                           << "Low: " << i.second->getLow() << "\n";
-                                       oss << "    "
-                                           << "Open: " << i.second->getOpen() << "\n";
-                                       oss << "    "
-                                           << "Close: " << i.second->getClose() << "\n";
-                                       oss << "--------------------------------------\n";
-                                   }
-
                                    enqueue_reply(fd, s, oss.str());
+
+                                   for (auto &route : manager.routes()) {
+                                       const std::string &sym = route.instrument->getSymbol();
+
+                                       EngineCommand cmd;
+                                       cmd.kind    = EngineCommand::Kind::Query;
+                                       cmd.replyTo = {reactor_, fd, s->serial};
+                                       cmd.query   = describe_stats;
+                                       if (!submit(route, std::move(cmd)))
+                                           enqueue_reply(fd, s, "ERR BUSY " + sym + "\n");
+                                   }
                                }
 
                            } else {
@@ -113,102 +245,262 @@ void Server::load_processors() {
                        });
 
     register_processor(
-            NEWL,
+            Command::NewL,
             [&](int                       fd,
                 std::shared_ptr<Session> &s,
-                std::vector<std::string> &parts,
-                std::string               clientId) {
+                const CommandLine        &parts,
+                const std::string        &clientId) {
                 if (!s->is_authenticated) {
                     enqueue_reply(fd, s, "UNAUTHORIZED\n");
                     return;
                 }
 
                 if (parts.size() < 5) {
-                    enqueue_reply(
-                            fd,
-                            s,
-                            "ERR BAD_COMMAND\n USAGE: NEWL <BUY|SELL> <SYMBOL> <QTY> <PRICE>\n");
-                    return;
-                }
-
-                std::string side_tok = parts[1];
-                Side        side;
-                bool        is_buy = false;
-                if (side_tok == "BUY") {
-                    is_buy = true;
-                    side   = Side::Buy;
-                } else if (side_tok == "SELL") {
-                    is_buy = false;
-                    side   = Side::Sell;
-                } else {
+                    enqueue_reply(fd,
+                                  s,
+                                  "ERR BAD_COMMAND\n USAGE: NEWL <BUY|SELL> <SYMBOL> <QTY> <PRICE> "
+                                  "[GTC|IOC|FOK]\n");
+                    return;
+                }
+
+                Side side;
+                if (!parseSide(parts[1], side)) {
                     enqueue_reply(fd, s, "ERR BAD_SIDE (expected BUY or SELL)\n");
                     return;
                 }
 
-                std::string symbol = parts[2];
-                if (symbol.empty() ||
-                    (manager.instruments_.find(symbol) == manager.instruments_.end())) {
+                const Route *route = manager.route(parts[2]);
+                if (!route) {
                     enqueue_reply(fd, s, "ERR BAD_SYMBOL\n");
                     return;
                 }
 
                 int qty = 0;
-                try {
-                    long long tmp = std::stoll(parts[3]);
-                    if (tmp <= 0) {
-                        enqueue_reply(fd, s, "ERR BAD_QTY\n");
-                        return;
-                    }
-                    qty = static_cast<int>(tmp);
-                } catch (...) {
+                if (!parseQuantity(parts[3], qty)) {
                     enqueue_reply(fd, s, "ERR BAD_QTY\n");
                     return;
                 }
 
-                double price = 0.0;
-                try {
-                    price = std::stod(parts[4]);
-                    if (!(price > 0.0)) {
-                        enqueue_reply(fd, s, "ERR BAD_PRICE\n");
-                        return;
-                    }
-                } catch (...) {
+                Price price = 0;
+                if (!route->instrument->parsePrice(parts[4], price) || price <= 0) {
                     enqueue_reply(fd, s, "ERR BAD_PRICE\n");
                     return;
                 }
 
+                TimeInForce tif = TimeInForce::GTC;
+                if (parts.size() > 5 && !parseTimeInForce(parts[5], tif)) {
+                    enqueue_reply(fd, s, "ERR BAD_TIF (expected GTC, IOC or FOK)\n");
+                    return;
+                }
+
                 if (clientId.empty()) {
-                    enqueue_reply(fd, s, "NOT AUTHENTICATED (NO CID)");
+                    enqueue_reply(fd, s, "NOT AUTHENTICATED (NO CID)\n");
+                    return;
+                }
+
+                submit_order(fd, s, *route, side, qty, price, OrderType::Limit, tif);
+            });
+
+    register_processor(
+            Command::NewM,
+            [&](int                       fd,
+                std::shared_ptr<Session> &s,
+                const CommandLine        &parts,
+                const std::string        &clientId) {
+                (void)clientId;
+                if (!s->is_authenticated) {
+                    enqueue_reply(fd, s, "UNAUTHORIZED\n");
+                    return;
+                }
+
+                if (parts.size() < 4) {
+                    enqueue_reply(fd,
+                                  s,
+                                  "ERR BAD_COMMAND\n USAGE: NEWM <BUY|SELL> <SYMBOL> <QTY> "
+                                  "[IOC|FOK]\n");
+                    return;
+                }
+
+                Side side;
+                if (!parseSide(parts[1], side)) {
+                    enqueue_reply(fd, s, "ERR BAD_SIDE (expected BUY or SELL)\n");
+                    return;
+                }
+
+                const Route *route = manager.route(parts[2]);
+                if (!route) {
+                    enqueue_reply(fd, s, "ERR BAD_SYMBOL\n");
+                    return;
+                }
+
+                int qty = 0;
+                if (!parseQuantity(parts[3], qty)) {
+                    enqueue_reply(fd, s, "ERR BAD_QTY\n");
+                    return;
+                }
+
+                // a market order never rests, so GTC would mean IOC anyway
+                TimeInForce tif = TimeInForce::IOC;
+                if (parts.size() > 4 &&
+                    (!parseTimeInForce(parts[4], tif) || tif == TimeInForce::GTC)) {
+                    enqueue_reply(fd, s, "ERR BAD_TIF (expected IOC or FOK)\n");
+                    return;
+                }
+
+                submit_order(fd, s, *route, side, qty, 0, OrderType::Market, tif);
+            });
+
+    register_processor(
+            Command::Cancel,
+            [&](int                       fd,
+                std::shared_ptr<Session> &s,
+                const CommandLine        &parts,
+                const std::string        &clientId) {
+                if (!s->is_authenticated) {
+                    enqueue_reply(fd, s, "UNAUTHORIZED\n");
+                    return;
+                }
+
+                if (parts.size() < 3) {
+                    enqueue_reply(fd, s, "ERR BAD_COMMAND\n USAGE: CANCEL <SYMBOL> <ORDERID>\n");
+                    return;
+                }
+
+                const Route *route = manager.route(parts[1]);
+                if (!route) {
+                    enqueue_reply(fd, s, "ERR BAD_SYMBOL\n");
+                    return;
+                }
+
+                OrderId id = 0;
+                if (!parseOrderId(parts[2], id)) {
+                    enqueue_reply(fd, s, "ERR BAD_ORDERID\n");
+                    return;
+                }
+
+                submit_cancel(fd, s, *route, id);
+            });
+
+    register_processor(
+            Command::Amend,
+            [&](int                       fd,
+                std::shared_ptr<Session> &s,
+                const CommandLine        &parts,
+                const std::string        &clientId) {
+                (void)clientId;
+                if (!s->is_authenticated) {
+                    enqueue_reply(fd, s, "UNAUTHORIZED\n");
+                    return;
+                }
+
+                if (parts.size() < 4) {
+                    enqueue_reply(fd,
+                                  s,
+                                  "ERR BAD_COMMAND\n USAGE: AMEND <SYMBOL> <ORDERID> <QTY> "
+                                  "[PRICE]\n");
+                    return;
+                }
+
+                const Route *route = manager.route(parts[1]);
+                if (!route) {
+                    enqueue_reply(fd, s, "ERR BAD_SYMBOL\n");
+                    return;
+                }
+
+                OrderId id = 0;
+                if (!parseOrderId(parts[2], id)) {
+                    enqueue_reply(fd, s, "ERR BAD_ORDERID\n");
+                    return;
+                }
+
+                int qty = 0;
+                if (!parseQuantity(parts[3], qty)) {
+                    enqueue_reply(fd, s, "ERR BAD_QTY\n");
+                    return;
                 }
 
-                Order *newOrder = new Order(clientId, price, qty, side, OrderType::Limit);
+                // without a price the order keeps its own
+                Price price = 0;
+                if (parts.size() > 4 &&
+                    (!route->instrument->parsePrice(parts[4], price) || price <= 0)) {
+                    enqueue_reply(fd, s, "ERR BAD_PRICE\n");
+                    return;
+                }
 
-                manager.instruments_[symbol]->placeOrder(*newOrder);
-                enqueue_reply(fd, s, "REQUEST_MADE\n");
+                submit_amend(fd, s, *route, id, qty, price);
             });
 
+    register_processor(Command::Binary,
+                       [&](int                       fd,
+                           std::shared_ptr<Session> &s,
+                           const CommandLine        &parts,
+                           const std::string        &clientId) {
+                           // frames carry no credentials, so log in over text first
+                           if (!s->is_authenticated || clientId.empty()) {
+                               enqueue_reply(fd, s, "UNAUTHORIZED\n");
+                               return;
+                           }
+
+                           enqueue_reply(fd, s, "OK BINARY\n");
+                           s->binary = true;
+                       });
+
     register_processor(
-            AUTH,
+            Command::Batch,
             [&](int                       fd,
                 std::shared_ptr<Session> &s,
-                std::vector<std::string> &parts,
-                std::string               clientId) {
+                const CommandLine        &parts,
+                const std::string        &clientId) {
+                if (!s->is_authenticated || clientId.empty()) {
+                    enqueue_reply(fd, s, "UNAUTHORIZED\n");
+                    return;
+                }
+
+                int n = 0;
+                if (parts.size() < 2 || !parseQuantity(parts[1], n) ||
+                    static_cast<size_t>(n) > wire::BATCH_MAX) {
+                    enqueue_reply(fd,
+                                  s,
+                                  "ERR BAD_COMMAND\n USAGE: BATCH <N>, then N lines of "
+                                  "<BUY|SELL> <SYMBOL> <QTY> <PRICE> [GTC|IOC|FOK]\n");
+                    return;
+                }
+
+                // the next n lines are orders; see batch_line()
+                s->batch_left = static_cast<size_t>(n);
+                s->batch.clear();
+                s->batch.reserve(s->batch_left);
+                s->batch_error.clear();
+            });
+
+    register_processor(
+            Command::Auth,
+            [&](int                       fd,
+                std::shared_ptr<Session> &s,
+                const CommandLine        &parts,
+                const std::string        &clientId) {
                 if (parts.size() < 3) {
                     enqueue_reply(fd, s, "ERR BAD_COMMAND\nUSAGE: AUTH <PASSKEY> <CLIENTID>\n");
                     return;
                 }
 
-                std::string passkey = parts[1];
-                std::string cid     = parts[2];
+                std::string passkey(parts[1]);
+                std::string cid(parts[2]);
 
                 if (!iequals(passkey, EASTER_EGG)) {
                     enqueue_reply(fd, s, "ERR BAD_PASSKEY\n");
                     return;
                 }
 
+                // journal records hold the id in a fixed-size field
+                if (cid.size() > journal::CLIENT_ID_LEN) {
+                    enqueue_reply(fd, s, "ERR BAD_CLIENT_ID\n");
+                    return;
+                }
+
                 if (s->is_authenticated) {
                     if (s->client_id == cid) {
-                        enqueue_reply(fd, s, "OK AUTH\n");
+                        enqueue_reply(fd, s, std::string(protocol::OK_AUTH));
                         return;
                     }
                     if (!s->client_id.empty()) {
@@ -227,15 +519,15 @@ void Server::load_processors() {
                 s->client_id        = cid;
                 sessions_[cid]      = s;
 
-                enqueue_reply(fd, s, "OK AUTH\n");
+                enqueue_reply(fd, s, std::string(protocol::OK_AUTH));
             });
 
     register_processor(
-            SEND,
+            Command::Send,
             [&](int                       fd,
                 std::shared_ptr<Session> &s,
-                std::vector<std::string> &parts,
-                std::string               clientId) {
+                const CommandLine        &parts,
+                const std::string        &clientId) {
                 if (!s->is_authenticated) {
                     enqueue_reply(fd, s, "UNAUTHORIZED\n");
                     return;
@@ -246,28 +538,23 @@ void Server::load_processors() {
                     return;
                 }
 
-                std::string group = parts[1];
-                if (group.empty()) {
-                    enqueue_reply(fd, s, "ERR BAD_COMMAND\nUSAGE: SEND <GROUP_NAME> <MESSAGE>\n");
-                    return;
-                }
+                std::string group(parts[1]);
+                std::string message(parts[2]);
 
-                std::string message = parts[2];
-                if (message.empty()) {
-                    enqueue_reply(fd, s, "ERR BAD_COMMAND\nUSAGE: SEND <GROUP_NAME> <MESSAGE>\n");
+                // members may sit on any reactor, so the fan-out goes through an engine
+                if (!manager.publish(reactor_, std::move(group), std::move(message))) {
+                    enqueue_reply(fd, s, "ERR BUSY\n");
                     return;
                 }
 
-                Notifier::instance().notifyGroup(group, message);
-
                 enqueue_reply(fd, s, "MESSAGE SENT");
             });
 
-    register_processor(SUB,
+    register_processor(Command::Sub,
                        [&](int                       fd,
                            std::shared_ptr<Session> &s,
-                           std::vector<std::string> &parts,
-                           std::string               clientId) {
+                           const CommandLine        &parts,
+                           const std::string        &clientId) {
                            if (!s->is_authenticated) {
                                enqueue_reply(fd, s, "UNAUTHORIZED\n");
                                return;
@@ -278,14 +565,273 @@ void Server::load_processors() {
                                return;
                            }
 
-                           std::string group = parts[1];
-                           if (group.empty()) {
-                               enqueue_reply(fd, s, "ERR BAD_COMMAND\nUSAGE: SUB <GROUP_NAME>\n");
-                               return;
-                           }
+                           std::string group(parts[1]);
+                           notifier_.subscribe(group, s);
 
-                           Notifier::instance().subscribe(group, clientId);
+                           enqueue_reply(fd, s, std::string(protocol::SUBSCRIBED));
 
-                           enqueue_reply(fd, s, "SUBSCRIEBED\n");
+                           // depth subscribers start from a snapshot; deltas already
+                           // queued ahead of it carry older sequence numbers
+                           if (group == "L2") {
+                               for (auto &route : manager.routes()) {
+                                   const std::string &sym = route.instrument->getSymbol();
+
+                                   EngineCommand cmd;
+                                   cmd.kind    = EngineCommand::Kind::Query;
+                                   cmd.replyTo = {reactor_, fd, s->serial, s->binary};
+                                   cmd.query   = [](Instrument &i) { return i.depthSnapshot(); };
+                                   if (!submit(route, std::move(cmd)))
+                                       enqueue_reply(fd, s, "ERR BUSY " + sym + "\n");
+                               }
+                           }
                        });
-}
\ No newline at end of file
+}
+
+void Server::submit_order(int                       fd,
+                          std::shared_ptr<Session> &s,
+                          const Route              &route,
+                          Side                      side,
+                          int                       qty,
+                          Price                     price,
+                          OrderType                 type,
+                          TimeInForce               tif) {
+    if (!admit(fd, s))
+        return;
+    // matching and the acknowledgement happen on the instrument's engine
+    EngineCommand cmd;
+    cmd.kind    = EngineCommand::Kind::NewOrder;
+    cmd.replyTo = {reactor_, fd, s->serial, s->binary};
+    cmd.order   = OrderRequest{
+            s->client_id, route.instrument->getSymbol(), side, type, price, qty, tif};
+    if (!submit(route, std::move(cmd)))
+        reject(fd, s, wire::RejectReason::Busy, "ERR BUSY\n");
+}
+
+// Cancels are not rate limited: they only ever take risk off.
+void Server::submit_cancel(int fd, std::shared_ptr<Session> &s, const Route &route, OrderId id) {
+    EngineCommand cmd;
+    cmd.kind           = EngineCommand::Kind::Cancel;
+    cmd.replyTo        = {reactor_, fd, s->serial, s->binary};
+    cmd.order.clientId = s->client_id;
+    cmd.orderId        = id;
+    if (!submit(route, std::move(cmd)))
+        reject(fd, s, wire::RejectReason::Busy, "ERR BUSY\n");
+}
+
+void Server::submit_amend(int                       fd,
+                          std::shared_ptr<Session> &s,
+                          const Route              &route,
+                          OrderId                   id,
+                          int                       qty,
+                          Price                     price) {
+    if (!admit(fd, s))
+        return;
+    EngineCommand cmd;
+    cmd.kind           = EngineCommand::Kind::Amend;
+    cmd.replyTo        = {reactor_, fd, s->serial, s->binary};
+    cmd.order.clientId = s->client_id;
+    cmd.order.quantity = qty;
+    cmd.order.price    = price;
+    cmd.orderId        = id;
+    if (!submit(route, std::move(cmd)))
+        reject(fd, s, wire::RejectReason::Busy, "ERR BUSY\n");
+}
+
+void Server::submit_batch(int                        fd,
+                          std::shared_ptr<Session>  &s,
+                          const Route               &route,
+                          std::vector<OrderRequest> &&orders) {
+    EngineCommand cmd;
+    cmd.kind    = EngineCommand::Kind::Batch;
+    cmd.replyTo = {reactor_, fd, s->serial, s->binary};
+    cmd.batch   = std::move(orders);
+    if (!submit(route, std::move(cmd)))
+        reject(fd, s, wire::RejectReason::Busy, "ERR BUSY " + route.instrument->getSymbol() + "\n");
+}
+
+// One order line of a text batch. Nothing is submitted until the last line is
+// in, and nothing at all if any line was bad, so a batch never half-applies on
+// the server's side of the wire.
+void Server::batch_line(const CommandLine &line, int fd, std::shared_ptr<Session> &s) {
+    size_t index = s->batch.size();
+
+    OrderRequest order{s->client_id, {}, Side::Buy, OrderType::Limit, 0, 0};
+    if (const char *error = parse_batch_order(manager, line, order);
+        error && s->batch_error.empty())
+        s->batch_error = "ERR BAD_BATCH " + std::to_string(index) + " " + error + "\n";
+    s->batch.push_back(std::move(order));
+
+    if (--s->batch_left > 0)
+        return;
+
+    std::vector<OrderRequest> orders = std::move(s->batch);
+    s->batch.clear();
+    if (!s->batch_error.empty()) {
+        enqueue_reply(fd, s, s->batch_error);
+        s->batch_error.clear();
+        return;
+    }
+    if (!admit(fd, s, static_cast<uint32_t>(orders.size())))
+        return;
+
+    // each instrument lives on its own engine, so the batch is split per
+    // symbol, keeping the order of the lines within each part
+    while (!orders.empty()) {
+        std::string               symbol = orders.front().symbol;
+        auto                      rest   = std::stable_partition(
+                orders.begin(), orders.end(), [&](const OrderRequest &o) {
+                    return o.symbol == symbol;
+                });
+        std::vector<OrderRequest> part;
+        part.assign(std::make_move_iterator(orders.begin()), std::make_move_iterator(rest));
+        orders.erase(orders.begin(), rest);
+        submit_batch(fd, s, *manager.route(symbol), std::move(part));
+    }
+}
+
+void Server::dispatch_frame(const wire::Header       &hdr,
+                            const char               *data,
+                            int                       fd,
+                            std::shared_ptr<Session> &s) {
+    using wire::RejectReason;
+
+    switch (hdr.type) {
+        case wire::MsgType::NewOrder: {
+            if (hdr.length != sizeof(wire::NewOrder))
+                break;
+            wire::NewOrder msg;
+            std::memcpy(&msg, data, sizeof(msg));
+
+            const Route *route = manager.route(wire::symbolOf(msg.symbol));
+            if (!route) {
+                reject(fd, s, RejectReason::BadSymbol, {});
+                return;
+            }
+            if (msg.side > 1) {
+                reject(fd, s, RejectReason::BadSide, {});
+                return;
+            }
+            if (msg.quantity == 0 || msg.quantity > INT_MAX) {
+                reject(fd, s, RejectReason::BadQty, {});
+                return;
+            }
+            if (msg.type > 1 || msg.timeInForce > 2) {
+                reject(fd, s, RejectReason::BadMessage, {});
+                return;
+            }
+            bool market = msg.type == 1;
+            if (!market && msg.price <= 0) {
+                reject(fd, s, RejectReason::BadPrice, {});
+                return;
+            }
+
+            Side        side = msg.side == 0 ? Side::Buy : Side::Sell;
+            TimeInForce tif  = static_cast<TimeInForce>(msg.timeInForce);
+            if (market && tif == TimeInForce::GTC)
+                tif = TimeInForce::IOC;
+            submit_order(fd,
+                         s,
+                         *route,
+                         side,
+                         static_cast<int>(msg.quantity),
+                         market ? 0 : msg.price,
+                         market ? OrderType::Market : OrderType::Limit,
+                         tif);
+            return;
+        }
+        case wire::MsgType::Cancel: {
+            if (hdr.length != sizeof(wire::Cancel))
+                break;
+            wire::Cancel msg;
+            std::memcpy(&msg, data, sizeof(msg));
+
+            const Route *route = manager.route(wire::symbolOf(msg.symbol));
+            if (!route) {
+                reject(fd, s, RejectReason::BadSymbol, {});
+                return;
+            }
+            submit_cancel(fd, s, *route, msg.orderId);
+            return;
+        }
+        case wire::MsgType::Amend: {
+            if (hdr.length != sizeof(wire::Amend))
+                break;
+            wire::Amend msg;
+            std::memcpy(&msg, data, sizeof(msg));
+
+            const Route *route = manager.route(wire::symbolOf(msg.symbol));
+            if (!route) {
+                reject(fd, s, RejectReason::BadSymbol, {});
+                return;
+            }
+            if (msg.quantity == 0 || msg.quantity > INT_MAX) {
+                reject(fd, s, RejectReason::BadQty, {});
+                return;
+            }
+            if (msg.price < 0) {
+                reject(fd, s, RejectReason::BadPrice, {});
+                return;
+            }
+            submit_amend(fd, s, *route, msg.orderId, static_cast<int>(msg.quantity), msg.price);
+            return;
+        }
+        case wire::MsgType::Batch: {
+            if (hdr.length < sizeof(wire::BatchHeader))
+                break;
+            wire::BatchHeader head;
+            std::memcpy(&head, data, sizeof(head));
+            if (head.count == 0 || head.count > wire::BATCH_MAX ||
+                hdr.length != sizeof(head) + head.count * sizeof(wire::BatchEntry))
+                break;
+
+            const Route *route = manager.route(wire::symbolOf(head.symbol));
+            if (!route) {
+                reject(fd, s, RejectReason::BadSymbol, {});
+                return;
+            }
+
+            // the frame is checked as a whole: one bad entry refuses every order in it
+            std::vector<OrderRequest> orders;
+            orders.reserve(head.count);
+            const char *at = data + sizeof(head);
+            for (size_t i = 0; i < head.count; ++i, at += sizeof(wire::BatchEntry)) {
+                wire::BatchEntry e;
+                std::memcpy(&e, at, sizeof(e));
+                if (e.side > 1) {
+                    reject(fd, s, RejectReason::BadSide, {});
+                    return;
+                }
+                if (e.quantity == 0 || e.quantity > INT_MAX) {
+                    reject(fd, s, RejectReason::BadQty, {});
+                    return;
+                }
+                if (e.type > 1 || e.timeInForce > 2) {
+                    reject(fd, s, RejectReason::BadMessage, {});
+                    return;
+                }
+                bool market = e.type == 1;
+                if (!market && e.price <= 0) {
+                    reject(fd, s, RejectReason::BadPrice, {});
+                    return;
+                }
+
+                TimeInForce tif = static_cast<TimeInForce>(e.timeInForce);
+                if (market && tif == TimeInForce::GTC)
+                    tif = TimeInForce::IOC;
+                orders.push_back(OrderRequest{s->client_id,
+                                              route->instrument->getSymbol(),
+                                              e.side == 0 ? Side::Buy : Side::Sell,
+                                              market ? OrderType::Market : OrderType::Limit,
+                                              market ? 0 : e.price,
+                                              static_cast<int>(e.quantity),
+                                              tif});
+            }
+            if (admit(fd, s, head.count))
+                submit_batch(fd, s, *route, std::move(orders));
+            return;
+        }
+        default:
+            break;
+    }
+    reject(fd, s, RejectReason::BadMessage, {});
+}
@@ -0,0 +1,284 @@
+#include "snapshot.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "instrument.hpp"
+#include "logger.hpp"
+#include "utils/checksum.hpp"
+#include "utils/flat_map.hpp"
+
+namespace snapshot {
+
+namespace fs = std::filesystem;
+
+static constexpr char MAGIC[8] = {'T', 'S', 'S', 'N', 'A', 'P', '0', '1'};
+
+#pragma pack(push, 1)
+struct Header {
+    char       magic[8];
+    char       symbol[journal::SYMBOL_LEN];
+    uint64_t   epoch;
+    uint32_t   engine;
+    uint32_t   checksum;  // FNV-1a of the payload
+    uint64_t   sequence;
+    uint64_t   nextOrderId;
+    TradeState trade;
+    uint64_t   levels[2];  // bids, asks
+    uint64_t   orders[2];
+    uint64_t   clients;
+    uint64_t   payloadBytes;
+};
+#pragma pack(pop)
+
+static_assert(std::is_trivially_copyable_v<Header>);
+
+// One side of the book, column by column.
+struct Columns {
+    std::vector<int64_t>  prices;
+    std::vector<uint64_t> counts;  // orders per level
+    std::vector<uint64_t> ids, remaining, filled, arrival;
+    std::vector<uint8_t>  tif;
+    std::vector<uint32_t> client;  // index into the client table
+};
+
+template <typename T>
+static void put(std::string &out, const std::vector<T> &column) {
+    out.append(reinterpret_cast<const char *>(column.data()), column.size() * sizeof(T));
+}
+
+// Bounds-checked reads off the payload.
+class Cursor {
+   public:
+    Cursor(const char *p, size_t n) : pos(p), end(p + n) {}
+
+    template <typename T>
+    bool column(std::vector<T> &out, uint64_t n) {
+        if (n > static_cast<uint64_t>(end - pos) / sizeof(T))
+            return false;
+        out.resize(n);
+        std::memcpy(out.data(), pos, n * sizeof(T));
+        pos += n * sizeof(T);
+        return true;
+    }
+
+    bool text(std::string &out) {
+        uint16_t len;
+        if (static_cast<size_t>(end - pos) < sizeof(len))
+            return false;
+        std::memcpy(&len, pos, sizeof(len));
+        pos += sizeof(len);
+        if (static_cast<size_t>(end - pos) < len)
+            return false;
+        out.assign(pos, len);
+        pos += len;
+        return true;
+    }
+
+    bool done() const { return pos == end; }
+
+   private:
+    const char *pos;
+    const char *end;
+};
+
+std::string pathFor(const std::string &dir, const std::string &symbol) {
+    return (fs::path(dir) / (symbol + ".snapshot")).string();
+}
+
+bool write(const Instrument &instrument, const journal::Position &at, const std::string &path) {
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    std::strncpy(header.symbol, instrument.getSymbol().c_str(), journal::SYMBOL_LEN);
+    header.epoch       = at.epoch;
+    header.engine      = at.engine;
+    header.sequence    = at.sequence;
+    header.nextOrderId = instrument.nextOrderId();
+    header.trade       = instrument.tradeState();
+
+    // views into the orders, which hold still while the snapshot is built
+    utils::FlatMap<std::string_view, uint32_t> clientIndex;
+    std::vector<std::string_view>              clients;
+    Columns                               sides[2];
+    for (int s = 0; s < 2; ++s) {
+        Columns &c = sides[s];
+        instrument.forEachLevel(
+                s == 0 ? Side::Buy : Side::Sell,
+                [&](PriceLevelNode *level) {
+                    c.prices.push_back(level->price);
+                    c.counts.push_back(level->orderCount());
+                    for (Order *o : level->level) {
+                        auto it = clientIndex.find(o->clientId);
+                        if (it == clientIndex.end()) {
+                            it = clientIndex.emplace(o->clientId.view(), clients.size()).first;
+                            clients.push_back(o->clientId.view());
+                        }
+                        c.ids.push_back(o->id);
+                        c.remaining.push_back(o->remainingQuantity);
+                        c.filled.push_back(o->filledQuantity);
+                        c.arrival.push_back(o->arrivalNs);
+                        c.tif.push_back(static_cast<uint8_t>(o->tif));
+                        c.client.push_back(it->second);
+                    }
+                },
+                SIZE_MAX);
+        header.levels[s] = c.prices.size();
+        header.orders[s] = c.ids.size();
+    }
+    header.clients = clients.size();
+
+    std::string payload;
+    for (auto &c : sides) {
+        put(payload, c.prices);
+        put(payload, c.counts);
+        put(payload, c.ids);
+        put(payload, c.remaining);
+        put(payload, c.filled);
+        put(payload, c.arrival);
+        put(payload, c.tif);
+        put(payload, c.client);
+    }
+    for (std::string_view cid : clients) {
+        uint16_t len = static_cast<uint16_t>(cid.size());  // AUTH keeps them short
+        payload.append(reinterpret_cast<const char *>(&len), sizeof(len));
+        payload.append(cid.data(), len);
+    }
+    header.payloadBytes = payload.size();
+    header.checksum     = utils::fnv1a(payload.data(), payload.size());
+
+    // written aside and renamed over the old one, so a crash never leaves half a snapshot
+    std::string tmp = path + ".tmp";
+    int         fd  = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("snapshot open: {}", logging::sysError());
+        return false;
+    }
+    bool ok = ::write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header)) &&
+              ::write(fd, payload.data(), payload.size()) ==
+                      static_cast<ssize_t>(payload.size()) &&
+              ::fsync(fd) == 0;
+    if (!ok)
+        LOG_ERROR("snapshot write: {}", logging::sysError());
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), path.c_str()) < 0) {
+        if (ok)
+            LOG_ERROR("snapshot rename: {}", logging::sysError());
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    // the rename itself is only durable once the directory is synced
+    std::string parent = fs::path(path).parent_path().string();
+    if (parent.empty())
+        parent = ".";
+    int dirfd = ::open(parent.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    ok        = dirfd >= 0 && ::fsync(dirfd) == 0;
+    if (!ok)
+        LOG_ERROR("snapshot sync {}: {}", parent, logging::sysError());
+    if (dirfd >= 0)
+        ::close(dirfd);
+    return ok;
+}
+
+static bool fail(const std::string &path, const char *why) {
+    LOG_ERROR("snapshot: {}: {}", path, why);
+    return false;
+}
+
+// Prices strictly ascending, every level non-empty and the counts adding up.
+static bool checkSide(const Columns &c, uint64_t clients) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < c.prices.size(); ++i) {
+        if (c.counts[i] == 0 || (i > 0 && c.prices[i] <= c.prices[i - 1]))
+            return false;
+        total += c.counts[i];
+    }
+    if (total != c.ids.size())
+        return false;
+    for (size_t k = 0; k < c.ids.size(); ++k) {
+        if (c.remaining[k] == 0 || c.remaining[k] > INT_MAX ||
+            c.tif[k] > static_cast<uint8_t>(TimeInForce::FOK) || c.client[k] >= clients)
+            return false;
+    }
+    return true;
+}
+
+bool load(Instrument &instrument, const std::string &path, journal::Position &at) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return fail(path, "cannot open");
+    std::string file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    Header header;
+    if (file.size() < sizeof(header))
+        return fail(path, "truncated");
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        return fail(path, "not a snapshot");
+    if (journal::field(header.symbol, journal::SYMBOL_LEN) !=
+        std::string_view(instrument.getSymbol()).substr(0, journal::SYMBOL_LEN))
+        return fail(path, "snapshot of another symbol");
+
+    const char *payload = file.data() + sizeof(header);
+    if (header.payloadBytes != file.size() - sizeof(header) ||
+        header.checksum != utils::fnv1a(payload, header.payloadBytes))
+        return fail(path, "damaged");
+
+    Cursor  cur(payload, header.payloadBytes);
+    Columns sides[2];
+    for (int s = 0; s < 2; ++s) {
+        Columns &c = sides[s];
+        uint64_t n = header.orders[s];
+        if (!cur.column(c.prices, header.levels[s]) || !cur.column(c.counts, header.levels[s]) ||
+            !cur.column(c.ids, n) || !cur.column(c.remaining, n) || !cur.column(c.filled, n) ||
+            !cur.column(c.arrival, n) || !cur.column(c.tif, n) || !cur.column(c.client, n))
+            return fail(path, "truncated");
+    }
+    std::vector<std::string> clients(header.clients);
+    for (auto &cid : clients)
+        if (!cur.text(cid))
+            return fail(path, "truncated");
+    if (!cur.done() || !checkSide(sides[0], header.clients) ||
+        !checkSide(sides[1], header.clients))
+        return fail(path, "inconsistent");
+    if (!instrument.getOrderMap().empty())
+        return fail(path, "instrument is not empty");
+
+    std::vector<Order *> orders[2];
+    for (int s = 0; s < 2; ++s) {
+        const Columns &c    = sides[s];
+        Side           side = s == 0 ? Side::Buy : Side::Sell;
+        size_t         k    = 0;
+        orders[s].reserve(c.ids.size());
+        for (size_t i = 0; i < c.prices.size(); ++i) {
+            for (uint64_t j = 0; j < c.counts[i]; ++j, ++k) {
+                OrderRequest req{clients[c.client[k]],
+                                 instrument.getSymbol(),
+                                 side,
+                                 OrderType::Limit,
+                                 c.prices[i],
+                                 static_cast<int>(c.remaining[k]),
+                                 static_cast<TimeInForce>(c.tif[k])};
+                orders[s].push_back(
+                        instrument.restoreOrder(c.ids[k], req, c.filled[k], c.arrival[k]));
+            }
+        }
+    }
+    if (!instrument.loadBook(orders[0], orders[1]))
+        return fail(path, "prices do not fit the book");
+
+    instrument.restoreTradeState(header.trade);
+    instrument.restoreOrderIds(header.nextOrderId);
+    at = journal::Position{header.epoch, header.engine, header.sequence};
+    return true;
+}
+
+}  // namespace snapshot
@@ -8,6 +8,9 @@ class AVLTreeTest : public ::testing::Test {
         int       height;
         MockNode* left;
         MockNode* right;
+        MockNode* parent = nullptr;
+        MockNode* prev   = nullptr;
+        MockNode* next   = nullptr;
 
         MockNode(int k, MockNode* l = nullptr, MockNode* r = nullptr)
             : price(k), height(1), left(l), right(r) {}
@@ -252,3 +255,111 @@ TEST_F(AVLTreeTest, InsertWorks) {
     };
     deleteTree(root);
 }
+
+TEST_F(AVLTreeTest, InsertThreadsNeighbours) {
+    MockNode* root = nullptr;
+    MockNode* out  = nullptr;
+
+    for (int p : {50, 30, 10, 20, 25, 60}) root = avl.insert(root, p, out);
+
+    MockNode* node = avl.findMin(root);
+    EXPECT_EQ(node->prev, nullptr) << "Lowest level must have no predecessor";
+
+    std::vector<int> prices;
+    for (; node; node = node->next) {
+        if (node->next) {
+            EXPECT_EQ(node->next->prev, node) << "prev/next links must be symmetric";
+        }
+        prices.push_back(node->price);
+    }
+    EXPECT_EQ(prices, (std::vector<int>{10, 20, 25, 30, 50, 60}));
+
+    avl.freeTree(root);
+}
+
+TEST_F(AVLTreeTest, RemoveNodeKeepsTreeConsistent) {
+    MockNode* root = nullptr;
+    MockNode* out  = nullptr;
+
+    std::vector<MockNode*> nodes;
+    for (int p = 1; p <= 64; ++p) {
+        root = avl.insert(root, (p * 37) % 101, out);
+        nodes.push_back(out);
+    }
+
+    std::function<int(MockNode*, MockNode*)> check = [&](MockNode* n, MockNode* parent) {
+        if (!n)
+            return 0;
+        EXPECT_EQ(n->parent, parent) << "Parent pointer of node(price = " << n->price << ")";
+        int lh = check(n->left, n);
+        int rh = check(n->right, n);
+        EXPECT_LE(std::abs(lh - rh), 1) << "Node(price = " << n->price << ") is unbalanced";
+        EXPECT_EQ(n->height, 1 + std::max(lh, rh));
+        return 1 + std::max(lh, rh);
+    };
+
+    // remove every other node by pointer, including inner nodes with two children
+    for (size_t i = 0; i < nodes.size(); i += 2) {
+        int price = nodes[i]->price;
+        root      = avl.removeNode(root, nodes[i]);
+        check(root, nullptr);
+
+        MockNode* probe = root;
+        while (probe && probe->price != price)
+            probe = price < probe->price ? probe->left : probe->right;
+        EXPECT_EQ(probe, nullptr) << "Removed price " << price << " still reachable";
+    }
+
+    int    last  = -1;
+    size_t count = 0;
+    for (MockNode* n = avl.findMin(root); n; n = n->next, ++count) {
+        EXPECT_GT(n->price, last) << "Thread must stay in ascending price order";
+        last = n->price;
+    }
+    EXPECT_EQ(count, nodes.size() / 2);
+
+    avl.freeTree(root);
+}
+
+TEST_F(AVLTreeTest, BuildMakesABalancedThreadedTree) {
+    std::vector<MockNode*> sorted;
+    for (int p = 1; p <= 50; ++p) sorted.push_back(makeNode(p * 2));
+
+    MockNode* root = avl.build(sorted.data(), sorted.size());
+
+    std::function<int(MockNode*, MockNode*)> check = [&](MockNode* n, MockNode* parent) {
+        if (!n)
+            return 0;
+        EXPECT_EQ(n->parent, parent) << "Parent pointer of node(price = " << n->price << ")";
+        if (n->left) {
+            EXPECT_LT(n->left->price, n->price);
+        }
+        if (n->right) {
+            EXPECT_GT(n->right->price, n->price);
+        }
+        int lh = check(n->left, n);
+        int rh = check(n->right, n);
+        EXPECT_LE(std::abs(lh - rh), 1) << "Node(price = " << n->price << ") is unbalanced";
+        EXPECT_EQ(n->height, 1 + std::max(lh, rh));
+        return 1 + std::max(lh, rh);
+    };
+    check(root, nullptr);
+
+    std::vector<int> prices;
+    for (MockNode* n = avl.findMin(root); n; n = n->next) prices.push_back(n->price);
+    ASSERT_EQ(prices.size(), sorted.size());
+    EXPECT_TRUE(std::is_sorted(prices.begin(), prices.end()));
+    EXPECT_EQ(sorted.back()->prev, sorted[sorted.size() - 2]);
+
+    // and it keeps working as an AVL tree afterwards
+    MockNode* out = nullptr;
+    root          = avl.insert(root, 51, out);
+    EXPECT_EQ(out->prev->price, 50);
+    check(root, nullptr);
+
+    avl.freeTree(root);
+}
+
+TEST_F(AVLTreeTest, BuildOfNothingIsEmpty) {
+    EXPECT_EQ(avl.build(nullptr, 0), nullptr);
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <backtest.hpp>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+static const TickSize CENTS{2, 1};
+
+static backtest::Event parse(const std::string& line) {
+    std::string     symbol, error;
+    backtest::Event ev;
+    EXPECT_TRUE(backtest::parseCsvLine(line, CENTS, symbol, ev, error)) << line << ": " << error;
+    return ev;
+}
+
+static std::string parseError(const std::string& line) {
+    std::string     symbol, error;
+    backtest::Event ev;
+    EXPECT_FALSE(backtest::parseCsvLine(line, CENTS, symbol, ev, error)) << line;
+    return error;
+}
+
+TEST(BacktestCsv, ParsesEveryAction) {
+    auto limit = parse("1000,TSLA,NEWL,7,C1,SELL,250.50,10,IOC");
+    EXPECT_EQ(limit.timestamp, 1000);
+    EXPECT_EQ(limit.action, backtest::Action::NewLimit);
+    EXPECT_EQ(limit.ref, 7u);
+    EXPECT_EQ(limit.clientId, "C1");
+    EXPECT_EQ(limit.side, Side::Sell);
+    EXPECT_EQ(limit.price, 25050);
+    EXPECT_EQ(limit.quantity, 10);
+    EXPECT_EQ(limit.tif, TimeInForce::IOC);
+
+    auto market = parse("1001,TSLA,NEWM,8,C2,BUY,,5,");
+    EXPECT_EQ(market.action, backtest::Action::NewMarket);
+    EXPECT_EQ(market.tif, TimeInForce::GTC);
+
+    auto cancel = parse("1002,TSLA,CANCEL,7,C1");
+    EXPECT_EQ(cancel.action, backtest::Action::Cancel);
+    EXPECT_EQ(cancel.ref, 7u);
+
+    auto amend = parse("1003,TSLA,AMEND,8,C2,,,3\r");
+    EXPECT_EQ(amend.action, backtest::Action::Amend);
+    EXPECT_EQ(amend.price, 0) << "no price keeps the current one";
+    EXPECT_EQ(amend.quantity, 3);
+}
+
+TEST(BacktestCsv, RejectsMalformedLines) {
+    EXPECT_EQ(parseError("x,TSLA,NEWL,1,C1,BUY,1.00,1"), "bad timestamp");
+    EXPECT_EQ(parseError("1,TSLA,NEWX,1,C1,BUY,1.00,1"), "unknown action");
+    EXPECT_EQ(parseError("1,TSLA,NEWL,1,C1,HOLD,1.00,1"), "bad side");
+    EXPECT_EQ(parseError("1,TSLA,NEWL,1,C1,BUY,1.005,1"), "bad price");
+    EXPECT_EQ(parseError("1,TSLA,NEWL,1,C1,BUY,1.00,0"), "bad quantity");
+    EXPECT_EQ(parseError("1,TSLA,NEWL,1,C1,BUY,1.00,1,DAY"), "bad time in force");
+    EXPECT_EQ(parseError("1,TSLA,NEWL,1,C1,BUY,1.00,1,GTC,extra"), "too many fields");
+    EXPECT_EQ(parseError("1,TSLA,CANCEL,1"), "expected timestamp,symbol,action,ref,client");
+}
+
+TEST(BacktestCsv, LoadsOneStreamPerSymbol) {
+    char path[] = "/tmp/backtest_test_XXXXXX";
+    int  fd     = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    {
+        std::ofstream out(path);
+        out << "timestamp_ns,symbol,action,ref,client,side,price,quantity,tif\n"
+            << "1,AAA,NEWL,1,C1,BUY,1.00,1\n"
+            << "# comment\n"
+            << "2,BBB,NEWL,1,C1,BUY,2.00,1\n"
+            << "\n"
+            << "3,AAA,CANCEL,1,C1\n";
+    }
+
+    std::vector<backtest::Stream> streams;
+    std::string                   error;
+    ASSERT_TRUE(backtest::loadCsv(path, CENTS, streams, error)) << error;
+    ASSERT_EQ(streams.size(), 2u);
+    EXPECT_EQ(streams[0].symbol, "AAA");
+    EXPECT_EQ(streams[0].events.size(), 2u);
+    EXPECT_EQ(streams[1].symbol, "BBB");
+
+    {
+        std::ofstream out(path, std::ios::app);
+        out << "4,AAA,NEWL,2,C1,BUY,,1\n";
+    }
+    streams.clear();
+    EXPECT_FALSE(backtest::loadCsv(path, CENTS, streams, error));
+    EXPECT_NE(error.find(":7: bad price"), std::string::npos) << error;
+    std::remove(path);
+}
+
+TEST(Backtest, MatchesTheStreamAtItsOwnTime) {
+    backtest::Stream stream{"TEST",
+                            {parse("1000,TEST,NEWL,10,S1,SELL,1.00,5"),
+                             parse("2000,TEST,NEWL,11,B1,BUY,1.00,3"),
+                             parse("3000,TEST,NEWL,12,B2,BUY,0.99,4"),
+                             parse("4000,TEST,AMEND,12,B2,,,2"),
+                             parse("5000,TEST,CANCEL,10,S1"),
+                             parse("6000,TEST,CANCEL,10,S1"),
+                             parse("7000,TEST,NEWM,13,B3,BUY,,1")}};
+
+    auto result = backtest::run(stream, CENTS, BookSpec{});
+
+    EXPECT_EQ(result.events, 7u);
+    EXPECT_EQ(result.fills, 1u);
+    EXPECT_EQ(result.fillLog, "2000,TEST,11,10,1.00,3\n");
+    EXPECT_EQ(result.refused, 2u) << "the second cancel and the market order with no asks";
+    EXPECT_EQ(result.volume, 3u);
+    EXPECT_EQ(result.open, 100);
+    EXPECT_EQ(result.bidLevels, 1u);
+    EXPECT_EQ(result.askLevels, 0u);
+    EXPECT_EQ(result.restingOrders, 1u);
+}
+
+TEST(Backtest, GivesTheSameResultOnAnyNumberOfThreads) {
+    std::mt19937                  rng(7);
+    std::vector<backtest::Stream> streams;
+    for (int s = 0; s < 8; ++s) {
+        backtest::Stream stream{"S" + std::to_string(s), {}};
+        for (uint64_t ref = 1; ref <= 2000; ++ref) {
+            backtest::Event ev;
+            ev.timestamp = static_cast<int64_t>(ref) * 1000;
+            ev.ref       = ref;
+            ev.clientId  = "C" + std::to_string(rng() % 5);
+            if (ref > 10 && rng() % 4 == 0) {
+                ev.action = backtest::Action::Cancel;
+                ev.ref    = ref - 1 - rng() % 10;
+            } else {
+                ev.side     = rng() % 2 ? Side::Buy : Side::Sell;
+                ev.price    = 950 + rng() % 100;
+                ev.quantity = 1 + rng() % 20;
+            }
+            stream.events.push_back(ev);
+        }
+        streams.push_back(std::move(stream));
+    }
+
+    auto one  = backtest::runAll(streams, CENTS, BookSpec{}, 1);
+    auto many = backtest::runAll(streams, CENTS, BookSpec{}, 4);
+
+    ASSERT_EQ(one.size(), many.size());
+    for (size_t i = 0; i < one.size(); ++i) {
+        EXPECT_EQ(one[i].symbol, streams[i].symbol);
+        EXPECT_EQ(many[i].symbol, streams[i].symbol);
+        EXPECT_GT(one[i].fills, 0u);
+        EXPECT_EQ(one[i].fillLog, many[i].fillLog);
+        EXPECT_EQ(one[i].refused, many[i].refused);
+        EXPECT_EQ(one[i].restingOrders, many[i].restingOrders);
+    }
+}
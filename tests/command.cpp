@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <command.hpp>
+#include <protocol.hpp>
+
+#include <string>
+
+TEST(CommandLineTest, SplitsAndUpperCasesInPlace) {
+    std::string buf = "  newl buy\ttsla 10 250.5\r";
+    CommandLine line(buf.data(), buf.size());
+
+    ASSERT_EQ(line.size(), 5u);
+    EXPECT_EQ(line.verb(), Command::NewL);
+    EXPECT_EQ(line[1], "BUY");
+    EXPECT_EQ(line[2], "TSLA");
+    EXPECT_EQ(line[4], "250.5");
+    // tokens point into the buffer rather than into copies
+    EXPECT_EQ(line[2].data(), buf.data() + 11);
+}
+
+TEST(CommandLineTest, KeepsPasskeyCase) {
+    std::string buf = "auth PaWy alice";
+    CommandLine line(buf.data(), buf.size());
+
+    EXPECT_EQ(line.verb(), Command::Auth);
+    EXPECT_EQ(line[1], "PaWy");
+    EXPECT_EQ(line[2], "ALICE");
+}
+
+TEST(CommandLineTest, HandlesBlankAndUnknownLines) {
+    std::string blank = " \t\r";
+    EXPECT_TRUE(CommandLine(blank.data(), blank.size()).empty());
+
+    std::string other = "HELLO world";
+    EXPECT_EQ(CommandLine(other.data(), other.size()).verb(), Command::Unknown);
+}
+
+TEST(CommandLineTest, LooksUpOrderVerbs) {
+    std::string buf = "batch 3";
+    CommandLine line(buf.data(), buf.size());
+
+    EXPECT_EQ(line.verb(), Command::Batch);
+    EXPECT_EQ(line[1], "3");
+
+    std::string amend = "amend tsla 4 10";
+    EXPECT_EQ(CommandLine(amend.data(), amend.size()).verb(), Command::Amend);
+}
+
+TEST(CommandLineTest, DropsTokensPastTheLimit) {
+    std::string buf;
+    for (size_t i = 0; i < CommandLine::MAX_TOKENS + 4; ++i) buf += "X ";
+    EXPECT_EQ(CommandLine(buf.data(), buf.size()).size(), CommandLine::MAX_TOKENS);
+}
+
+TEST(FieldParserTest, ParsesQuantity) {
+    int q = 0;
+    EXPECT_TRUE(parseQuantity("25", q));
+    EXPECT_EQ(q, 25);
+    EXPECT_FALSE(parseQuantity("0", q));
+    EXPECT_FALSE(parseQuantity("-3", q));
+    EXPECT_FALSE(parseQuantity("12X", q));
+    EXPECT_FALSE(parseQuantity("99999999999", q));
+    EXPECT_FALSE(parseQuantity("", q));
+}
+
+TEST(FieldParserTest, ParsesSideAndOrderId) {
+    Side side;
+    EXPECT_TRUE(parseSide("SELL", side));
+    EXPECT_EQ(side, Side::Sell);
+    EXPECT_FALSE(parseSide("HOLD", side));
+
+    OrderId id = 0;
+    EXPECT_TRUE(parseOrderId("18446744073709551615", id));
+    EXPECT_EQ(id, UINT64_MAX);
+    EXPECT_FALSE(parseOrderId("-1", id));
+    EXPECT_FALSE(parseOrderId("7a", id));
+}
+
+TEST(FieldParserTest, ParsesTimeInForce) {
+    TimeInForce tif = TimeInForce::GTC;
+    EXPECT_TRUE(parseTimeInForce("FOK", tif));
+    EXPECT_EQ(tif, TimeInForce::FOK);
+    EXPECT_TRUE(parseTimeInForce("IOC", tif));
+    EXPECT_EQ(tif, TimeInForce::IOC);
+    EXPECT_FALSE(parseTimeInForce("DAY", tif));
+
+    std::string buf = "newm sell tsla 5";
+    EXPECT_EQ(CommandLine(buf.data(), buf.size()).verb(), Command::NewM);
+}
+
+TEST(CommandNameTest, RoundTripsEveryVerb) {
+    for (size_t c = size_t(Command::Unknown) + 1; c < size_t(Command::Count); ++c) {
+        auto name = commandName(Command(c));
+        ASSERT_FALSE(name.empty()) << c;
+        EXPECT_EQ(lookupCommand(name), Command(c)) << name;
+    }
+    EXPECT_TRUE(commandName(Command::Unknown).empty());
+}
+
+TEST(ProtocolTest, BuildsRequestsTheServerParses) {
+    std::string line = protocol::newLimit(Side::Sell, "TSLA", 7, "250.50", TimeInForce::IOC);
+    ASSERT_EQ(line.back(), '\n');
+    CommandLine parts(line.data(), line.size() - 1);
+    EXPECT_EQ(parts.verb(), Command::NewL);
+    ASSERT_EQ(parts.size(), 6u);
+    EXPECT_EQ(parts[1], "SELL");
+    EXPECT_EQ(parts[4], "250.50");
+    EXPECT_EQ(parts[5], "IOC");
+    EXPECT_EQ(protocol::newLimit(Side::Buy, "TSLA", 1, "1.00"), "NEWL BUY TSLA 1 1.00\n");
+
+    EXPECT_EQ(protocol::cancel("TSLA", 42), "CANCEL TSLA 42\n");
+    EXPECT_EQ(protocol::auth("pawy", "alice"), "AUTH pawy alice\n");
+    EXPECT_EQ(protocol::subscribe("L2"), "SUB L2\n");
+}
+
+TEST(ProtocolTest, ParsesWhatTheServerReplies) {
+    auto strip = [](std::string s) { return s.substr(0, s.size() - 1); };
+
+    auto made = protocol::parseReply(strip(protocol::requestMade(12)));
+    EXPECT_EQ(made.kind, protocol::ReplyKind::RequestMade);
+    EXPECT_EQ(made.id, 12u);
+    EXPECT_EQ(protocol::parseReply(strip(protocol::cancelled(3))).kind,
+              protocol::ReplyKind::Cancelled);
+    EXPECT_EQ(protocol::parseReply(strip(protocol::amended(3))).kind, protocol::ReplyKind::Amended);
+
+    std::string exec = strip(protocol::exec("TSLA", 5, "100.25"));
+    auto        fill = protocol::parseReply(exec);
+    EXPECT_EQ(fill.kind, protocol::ReplyKind::Exec);
+    EXPECT_EQ(fill.symbol, "TSLA");
+    EXPECT_EQ(fill.quantity, 5u);
+    EXPECT_EQ(fill.price, "100.25");
+
+    auto err = protocol::parseReply("ERR BAD_SIDE (expected BUY or SELL)");
+    EXPECT_EQ(err.kind, protocol::ReplyKind::Error);
+    EXPECT_EQ(err.error, "BAD_SIDE");
+
+    EXPECT_EQ(protocol::parseReply(strip(std::string(protocol::OK_AUTH))).kind,
+              protocol::ReplyKind::Auth);
+    EXPECT_EQ(protocol::parseReply("SUBSCRIEBED\r").kind, protocol::ReplyKind::Subscribed);
+    EXPECT_EQ(protocol::parseReply("L1 TSLA 100.00 5 100.25 3").kind, protocol::ReplyKind::Other);
+    EXPECT_EQ(protocol::parseReply("REQUEST_MADE x").kind, protocol::ReplyKind::Other);
+    EXPECT_EQ(protocol::parseReply("EXEC TSLA 5").kind, protocol::ReplyKind::Other);
+}
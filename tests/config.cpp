@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <config.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+TEST(InstrumentConfig, ParsesEveryKey) {
+    InstrumentSpec spec;
+    std::string    error;
+    ASSERT_TRUE(config::parseInstrument(
+            "ES base=4000.00 tick=0.25 book=ladder levels=8000 band_bps=500 engine=3 # futures",
+            spec,
+            error))
+            << error;
+    EXPECT_EQ(spec.symbol, "ES");
+    EXPECT_EQ(spec.tick.decimals, 2u);
+    EXPECT_EQ(spec.tick.units, 25);
+    EXPECT_EQ(spec.book.type, BookType::Ladder);
+    EXPECT_EQ(spec.book.basePrice, 16000) << "in ticks, whatever the key order";
+    EXPECT_EQ(spec.book.levels, 8000u);
+    EXPECT_EQ(spec.limits.bandBps, 500u);
+    EXPECT_EQ(spec.engine, 3u);
+}
+
+TEST(InstrumentConfig, ParsesRiskLimits) {
+    InstrumentSpec spec;
+    std::string    error;
+    ASSERT_TRUE(config::parseInstrument(
+            "TSLA max_notional=1000000.50 tick=0.05 max_qty=500 max_open_qty=2000", spec, error))
+            << error;
+    EXPECT_EQ(spec.limits.maxOrderQty, 500u);
+    EXPECT_EQ(spec.limits.maxOpenQty, 2000u);
+    EXPECT_EQ(spec.limits.maxNotional, 20000010u) << "in ticks, whatever the key order";
+
+    EXPECT_FALSE(config::parseInstrument("TSLA tick=0.05 max_notional=10.01", spec, error));
+    EXPECT_EQ(error, "bad value for max_notional: 10.01");
+    EXPECT_FALSE(config::parseInstrument("TSLA tick=0.05 max_qty=-1", spec, error));
+    EXPECT_EQ(error, "bad value for max_qty: -1");
+}
+
+TEST(InstrumentConfig, DefaultsToAnAvlBookOnAnyEngine) {
+    InstrumentSpec spec;
+    std::string    error;
+    ASSERT_TRUE(config::parseInstrument("TSLA\ttick=0.01", spec, error)) << error;
+    EXPECT_EQ(spec.book.type, BookType::AVL);
+    EXPECT_EQ(spec.limits.bandBps, 0u);
+    EXPECT_FALSE(spec.limits.tracksExposure());
+    EXPECT_EQ(spec.engine, InstrumentSpec::ANY_ENGINE);
+
+    ASSERT_TRUE(config::parseInstrument("BTC tick=1 book=ladder", spec, error)) << error;
+    EXPECT_EQ(spec.tick.decimals, 0u);
+    EXPECT_EQ(spec.book.basePrice, 1);
+    EXPECT_EQ(spec.book.levels, 65536u);
+}
+
+TEST(InstrumentConfig, UpperCasesSymbols) {
+    InstrumentSpec spec;
+    std::string    error;
+    ASSERT_TRUE(config::parseInstrument("brk.b tick=0.01", spec, error)) << error;
+    EXPECT_EQ(spec.symbol, "BRK.B");
+}
+
+TEST(InstrumentConfig, RejectsBadLines) {
+    InstrumentSpec spec;
+    std::string    error;
+    EXPECT_FALSE(config::parseInstrument("TSLA book=avl", spec, error));
+    EXPECT_EQ(error, "missing tick");
+    EXPECT_FALSE(config::parseInstrument("TSLA tick=0", spec, error));
+    EXPECT_EQ(error, "bad value for tick: 0");
+    EXPECT_FALSE(config::parseInstrument("TSLA tick=0.01 book=heap", spec, error));
+    EXPECT_EQ(error, "bad value for book: heap");
+    EXPECT_FALSE(config::parseInstrument("TSLA tick=0.05 book=ladder base=1.01", spec, error));
+    EXPECT_EQ(error, "bad value for base: 1.01") << "off tick";
+    EXPECT_FALSE(config::parseInstrument("TSLA tick=0.01 colour=red", spec, error));
+    EXPECT_EQ(error, "unknown key: colour");
+    EXPECT_FALSE(config::parseInstrument("TSLA tick=0.01 ladder", spec, error));
+    EXPECT_FALSE(config::parseInstrument("VERYLONGSYM tick=0.01", spec, error));
+    EXPECT_EQ(error, "bad symbol: VERYLONGSYM");
+}
+
+class InstrumentFile : public ::testing::Test {
+   protected:
+    std::string path;
+
+    void SetUp() override {
+        char tmpl[] = "/tmp/instruments_XXXXXX";
+        int  fd     = mkstemp(tmpl);
+        ASSERT_GE(fd, 0);
+        ::close(fd);
+        path = tmpl;
+    }
+
+    void TearDown() override { unlink(path.c_str()); }
+
+    void write(const std::string& text) { std::ofstream(path) << text; }
+};
+
+TEST_F(InstrumentFile, LoadsEveryInstrument) {
+    write("# symbol tick\n\nTSLA tick=0.01\n   \nAAPL tick=0.01 book=ladder  # cents\n");
+    std::vector<InstrumentSpec> specs;
+    std::string                 error;
+    ASSERT_TRUE(config::loadInstruments(path, specs, error)) << error;
+    ASSERT_EQ(specs.size(), 2u);
+    EXPECT_EQ(specs[0].symbol, "TSLA");
+    EXPECT_EQ(specs[1].book.type, BookType::Ladder);
+}
+
+TEST_F(InstrumentFile, NamesTheBadLine) {
+    write("TSLA tick=0.01\nAAPL tick=x\n");
+    std::vector<InstrumentSpec> specs;
+    std::string                 error;
+    EXPECT_FALSE(config::loadInstruments(path, specs, error));
+    EXPECT_EQ(error, path + ":2: bad value for tick: x");
+
+    write("TSLA tick=0.01\nTSLA tick=0.05\n");
+    specs.clear();
+    EXPECT_FALSE(config::loadInstruments(path, specs, error));
+    EXPECT_EQ(error, path + ":2: TSLA defined twice");
+
+    write("TSLA tick=0.01\ntsla tick=0.05\n");
+    specs.clear();
+    EXPECT_FALSE(config::loadInstruments(path, specs, error));
+    EXPECT_EQ(error, path + ":2: TSLA defined twice") << "symbols are compared upper-cased";
+
+    write("TSLA tick=0.01\n\nVERYLONGSYM tick=0.01\n");
+    specs.clear();
+    EXPECT_FALSE(config::loadInstruments(path, specs, error));
+    EXPECT_EQ(error, path + ":3: bad symbol: VERYLONGSYM") << "longer than journal::SYMBOL_LEN";
+
+    EXPECT_FALSE(config::loadInstruments(path + ".missing", specs, error));
+    EXPECT_EQ(error, "cannot open " + path + ".missing");
+}
@@ -0,0 +1,549 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include <engine.hpp>
+
+class EngineTest : public ::testing::Test {
+   protected:
+    std::shared_ptr<Instrument> inst;
+    Engine                      engine{std::vector<int>{-1, -1}};  // two reactors, no eventfds
+
+    virtual InstrumentSpec spec() const {
+        return InstrumentSpec{.symbol = "TEST", .tick = TickSize{2, 1}, .book = BookSpec{}};
+    }
+
+    void SetUp() override {
+        inst = makeInstrument(spec());
+        engine.adopt(*inst);
+        engine.start();
+    }
+
+    void TearDown() override {
+        engine.stop();
+        inst->setListener(nullptr);
+    }
+
+    void submit(EngineCommand cmd, size_t reactor = 0) {
+        cmd.instrument = inst.get();
+        ASSERT_TRUE(engine.submit(reactor, std::move(cmd)));
+    }
+
+    void newOrder(int fd, const std::string& cid, Side side, Price price, int qty,
+                  size_t reactor = 0) {
+        EngineCommand cmd;
+        cmd.kind       = EngineCommand::Kind::NewOrder;
+        cmd.replyTo.fd = fd;
+        cmd.order      = OrderRequest{cid, "TEST", side, OrderType::Limit, price, qty};
+        submit(std::move(cmd), reactor);
+    }
+
+    // Collects a reactor's events until `count` have arrived or a second has passed.
+    // The L2 feed is left out unless `depth` is set; it has tests of its own.
+    std::vector<EngineEvent> collect(size_t count, size_t reactor = 0, bool depth = false) {
+        std::vector<EngineEvent> events;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (events.size() < count && std::chrono::steady_clock::now() < deadline)
+            engine.drain(reactor, [&](EngineEvent& ev) {
+                if (depth || ev.kind != EngineEvent::Kind::Group || ev.target != "L2")
+                    events.push_back(std::move(ev));
+            });
+        return events;
+    }
+};
+
+TEST_F(EngineTest, RepliesWithOrderId) {
+    newOrder(7, "C1", Side::Buy, 100, 5);
+
+    auto events = collect(1);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].kind, EngineEvent::Kind::Reply);
+    EXPECT_EQ(events[0].replyTo.fd, 7);
+    EXPECT_EQ(events[0].text, "REQUEST_MADE 1\n");
+}
+
+TEST_F(EngineTest, PublishesExecutionsBeforeReply) {
+    newOrder(7, "C1", Side::Sell, 100, 5);
+    newOrder(8, "C2", Side::Buy, 100, 5);
+
+    // reply, EXEC to buyer and seller, the second reply, then the burst's L1 update
+    auto events = collect(5);
+    ASSERT_EQ(events.size(), 5u);
+    EXPECT_EQ(events[1].kind, EngineEvent::Kind::User);
+    EXPECT_EQ(events[1].target, "C2");
+    EXPECT_EQ(events[1].text, "EXEC TEST 5@1.00\n");
+    EXPECT_EQ(events[2].target, "C1");
+    EXPECT_EQ(events[3].replyTo.fd, 8);
+    EXPECT_EQ(events[3].text, "REQUEST_MADE 2\n");
+    EXPECT_EQ(events[4].kind, EngineEvent::Kind::Group);
+    EXPECT_EQ(events[4].target, "L1");
+    EXPECT_EQ(events[4].key, "TEST");
+}
+
+TEST_F(EngineTest, CancelsAndAnswersQueries) {
+    newOrder(7, "C1", Side::Buy, 100, 5);
+
+    EngineCommand cancel;
+    cancel.kind           = EngineCommand::Kind::Cancel;
+    cancel.order.clientId = "C1";
+    cancel.orderId        = 1;
+    submit(std::move(cancel));
+
+    EngineCommand query;
+    query.kind  = EngineCommand::Kind::Query;
+    query.query = [](Instrument& i) { return std::to_string(i.getOrderMap().size()); };
+    submit(std::move(query));
+
+    auto events = collect(3);
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[1].text, "CANCELLED 1\n");
+    EXPECT_EQ(events[2].text, "0");
+}
+
+TEST_F(EngineTest, WakesFromParkedState) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    newOrder(7, "C1", Side::Buy, 100, 5);
+    EXPECT_EQ(collect(1).size(), 1u);
+}
+
+TEST_F(EngineTest, RepliesToTheAskingReactorAndNotifiesAll) {
+    newOrder(7, "C1", Side::Sell, 100, 5, 0);
+    newOrder(8, "C2", Side::Buy, 100, 5, 1);
+
+    // reactor 0: its reply plus both EXECs and L1
+    auto first = collect(4, 0);
+    ASSERT_EQ(first.size(), 4u);
+    EXPECT_EQ(first[0].text, "REQUEST_MADE 1\n");
+    EXPECT_EQ(first[3].kind, EngineEvent::Kind::Group);
+
+    // reactor 1: the same notifications, its own reply ahead of L1
+    auto second = collect(4, 1);
+    ASSERT_EQ(second.size(), 4u);
+    EXPECT_EQ(second[2].kind, EngineEvent::Kind::Reply);
+    EXPECT_EQ(second[2].replyTo.reactor, 1u);
+    EXPECT_EQ(second[2].text, "REQUEST_MADE 2\n");
+    EXPECT_EQ(second[3].kind, EngineEvent::Kind::Group);
+    // the L1 update is encoded once and shared by both reactors
+    ASSERT_TRUE(second[3].payload);
+    EXPECT_EQ(second[3].payload, first[3].payload);
+}
+
+TEST_F(EngineTest, AnswersBinarySessionsWithFrames) {
+    EngineCommand cmd;
+    cmd.kind           = EngineCommand::Kind::NewOrder;
+    cmd.replyTo.binary = true;
+    cmd.order          = OrderRequest{"C1", "TEST", Side::Buy, OrderType::Limit, 100, 5};
+    submit(std::move(cmd));
+
+    newOrder(8, "C2", Side::Sell, 100, 5);
+
+    // ack, EXEC x2, text ack, L1
+    auto events = collect(5);
+    ASSERT_EQ(events.size(), 5u);
+
+    wire::Ack ack;
+    ASSERT_EQ(events[0].text.size(), sizeof(ack));
+    std::memcpy(&ack, events[0].text.data(), sizeof(ack));
+    EXPECT_EQ(ack.hdr.type, wire::MsgType::Ack);
+    EXPECT_EQ(ack.kind, wire::AckKind::New);
+    EXPECT_EQ(ack.orderId, 1u);
+
+    // executions carry both forms; the reactor picks per session
+    wire::Exec exec;
+    ASSERT_EQ(events[1].binary.size(), sizeof(exec));
+    std::memcpy(&exec, events[1].binary.data(), sizeof(exec));
+    EXPECT_EQ(wire::symbolOf(exec.symbol), "TEST");
+    EXPECT_EQ(exec.orderId, 1u);
+    EXPECT_EQ(exec.quantity, 5u);
+    EXPECT_EQ(exec.price, 100);
+    EXPECT_EQ(events[2].text, "EXEC TEST 5@1.00\n");
+}
+
+TEST_F(EngineTest, AnswersTakersThatDoNotRest) {
+    newOrder(7, "C1", Side::Sell, 100, 3);
+
+    EngineCommand ioc;
+    ioc.kind       = EngineCommand::Kind::NewOrder;
+    ioc.replyTo.fd = 8;
+    ioc.order = OrderRequest{"C2", "TEST", Side::Buy, OrderType::Limit, 100, 5, TimeInForce::IOC};
+    submit(std::move(ioc));
+
+    EngineCommand fok;
+    fok.kind       = EngineCommand::Kind::NewOrder;
+    fok.replyTo.fd = 9;
+    fok.order      = OrderRequest{"C2", "TEST", Side::Sell, OrderType::Market, 0, 1};
+    fok.order.tif  = TimeInForce::FOK;
+    submit(std::move(fok));
+
+    // besides EXECs and L1: the resting reply, the IOC's ack and cancel, the FOK reject
+    std::vector<std::string> replies;
+    for (auto& ev : collect(7))
+        if (ev.kind == EngineEvent::Kind::Reply)
+            replies.push_back(std::to_string(ev.replyTo.fd) + " " + ev.text);
+    EXPECT_EQ(replies,
+              (std::vector<std::string>{"7 REQUEST_MADE 1\n",
+                                        "8 REQUEST_MADE 2\n",
+                                        "8 CANCELLED 2\n",
+                                        "9 ERR NO_LIQUIDITY\n"}));
+}
+
+TEST_F(EngineTest, ConflatesL1AcrossASweep) {
+    for (int i = 0; i < 5; ++i) newOrder(7, "C1", Side::Sell, 100 + i, 1);
+    auto resting = collect(5);
+    ASSERT_EQ(resting.size(), 5u);
+
+    newOrder(8, "C2", Side::Buy, 104, 5);
+
+    // five fills, two EXECs each, one reply and a single L1 update
+    auto events = collect(12);
+    ASSERT_EQ(events.size(), 12u);
+    size_t l1 = 0;
+    for (auto& ev : events) l1 += ev.kind == EngineEvent::Kind::Group;
+    EXPECT_EQ(l1, 1u);
+    EXPECT_EQ(events.back().kind, EngineEvent::Kind::Group);
+    EXPECT_NE(events.back().payload->find("LTP: 1.04"), std::string::npos);
+}
+
+TEST_F(EngineTest, PublishesSequencedDepthDeltas) {
+    newOrder(7, "C1", Side::Buy, 100, 5);
+    auto first = collect(2, 0, true);
+    ASSERT_EQ(first.size(), 2u);
+    EXPECT_EQ(first[1].target, "L2");
+    EXPECT_EQ(*first[1].payload, "L2_DELTA TEST 1 1\nADD BID 1.00 5\n");
+
+    newOrder(8, "C2", Side::Sell, 100, 2);
+    // reply, EXEC x2, L1, then the modified bid
+    auto second = collect(5, 0, true);
+    ASSERT_EQ(second.size(), 5u);
+    EXPECT_EQ(second[4].target, "L2");
+    EXPECT_EQ(*second[4].payload, "L2_DELTA TEST 2 1\nMOD BID 1.00 3\n");
+
+    EngineCommand cancel;
+    cancel.kind           = EngineCommand::Kind::Cancel;
+    cancel.order.clientId = "C1";
+    cancel.orderId        = 1;
+    submit(std::move(cancel));
+    auto third = collect(2, 0, true);
+    ASSERT_EQ(third.size(), 2u);
+    EXPECT_EQ(*third[1].payload, "L2_DELTA TEST 3 1\nDEL BID 1.00\n");
+}
+
+TEST_F(EngineTest, DepthSnapshotMatchesPublishedSequence) {
+    newOrder(7, "C1", Side::Buy, 99, 5);
+    newOrder(7, "C1", Side::Buy, 100, 1);
+    newOrder(8, "C2", Side::Sell, 102, 4);
+    collect(3);
+
+    EngineCommand query;
+    query.kind  = EngineCommand::Kind::Query;
+    query.query = [](Instrument& i) { return i.depthSnapshot(); };
+    submit(std::move(query));
+
+    auto events = collect(1);
+    ASSERT_EQ(events.size(), 1u);
+    std::string seq = std::to_string(inst->depthSequence());
+    EXPECT_EQ(events[0].text,
+              "L2_SNAPSHOT TEST " + seq + " 3\nBID 1.00 1\nBID 0.99 5\nASK 1.02 4\n");
+}
+
+TEST_F(EngineTest, AnswersBatchWithOneAck) {
+    EngineCommand cmd;
+    cmd.kind       = EngineCommand::Kind::Batch;
+    cmd.replyTo.fd = 7;
+    cmd.batch      = {OrderRequest{"C1", "TEST", Side::Buy, OrderType::Limit, 100, 1},
+                      OrderRequest{"C1", "TEST", Side::Buy, OrderType::Limit, 98, 2},
+                      OrderRequest{"C1", "TEST", Side::Sell, OrderType::Market, 0, 5}};
+    cmd.batch[2].tif = TimeInForce::FOK;  // 3 bid, so it cannot fill
+    submit(std::move(cmd));
+
+    std::vector<std::string> replies;
+    for (auto& ev : collect(2))
+        if (ev.kind == EngineEvent::Kind::Reply)
+            replies.push_back(ev.text);
+    EXPECT_EQ(replies, (std::vector<std::string>{"BATCH_ACK TEST 1 3 REJ 2:NO_LIQUIDITY\n"}));
+}
+
+TEST_F(EngineTest, AnswersBinaryBatchWithFrame) {
+    EngineCommand cmd;
+    cmd.kind           = EngineCommand::Kind::Batch;
+    cmd.replyTo.fd     = 7;
+    cmd.replyTo.binary = true;
+    cmd.batch          = {OrderRequest{"C1", "TEST", Side::Sell, OrderType::Limit, 101, 1},
+                          OrderRequest{"C1", "TEST", Side::Sell, OrderType::Limit, 103, 1}};
+    submit(std::move(cmd));
+
+    auto events = collect(1);
+    ASSERT_FALSE(events.empty());
+    ASSERT_EQ(events[0].text.size(), sizeof(wire::BatchAck));
+
+    wire::BatchAck ack;
+    std::memcpy(&ack, events[0].text.data(), sizeof(ack));
+    EXPECT_EQ(ack.hdr.type, wire::MsgType::BatchAck);
+    EXPECT_EQ(ack.hdr.length, sizeof(wire::BatchAck));
+    EXPECT_EQ(wire::symbolOf(ack.symbol), "TEST");
+    EXPECT_EQ(ack.firstOrderId, 1u);
+    EXPECT_EQ(ack.count, 2u);
+    EXPECT_EQ(ack.rejected, 0u);
+}
+
+TEST_F(EngineTest, AmendsKeepingPriceWhenNoneGiven) {
+    newOrder(7, "C1", Side::Buy, 100, 5);
+
+    EngineCommand amend;
+    amend.kind           = EngineCommand::Kind::Amend;
+    amend.replyTo.fd     = 7;
+    amend.orderId        = 1;
+    amend.order.clientId = "C1";
+    amend.order.quantity = 3;
+    submit(std::move(amend));
+
+    EngineCommand other;
+    other.kind           = EngineCommand::Kind::Amend;
+    other.replyTo.fd     = 8;
+    other.orderId        = 1;
+    other.order.clientId = "C2";
+    other.order.quantity = 3;
+    submit(std::move(other));
+
+    std::vector<std::string> replies;
+    for (auto& ev : collect(3))
+        if (ev.kind == EngineEvent::Kind::Reply)
+            replies.push_back(std::to_string(ev.replyTo.fd) + " " + ev.text);
+    EXPECT_EQ(replies,
+              (std::vector<std::string>{
+                      "7 REQUEST_MADE 1\n", "7 AMENDED 1\n", "8 ERR UNKNOWN_ORDER\n"}));
+}
+
+class EngineRiskTest : public EngineTest {
+   protected:
+    InstrumentSpec spec() const override {
+        InstrumentSpec s = EngineTest::spec();
+        s.limits         = risk::Limits{1000, 10, 10, 0};  // 10% band, 10 per order, 10 resting
+        return s;
+    }
+
+    // Reply texts, until `count` have arrived or a second has passed.
+    std::vector<std::string> replies(size_t count) {
+        std::vector<std::string> out;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (out.size() < count && std::chrono::steady_clock::now() < deadline)
+            engine.drain(0, [&](EngineEvent& ev) {
+                if (ev.kind == EngineEvent::Kind::Reply)
+                    out.push_back(ev.text);
+            });
+        return out;
+    }
+
+    void cancel(const std::string& cid, OrderId id) {
+        EngineCommand cmd;
+        cmd.kind           = EngineCommand::Kind::Cancel;
+        cmd.order.clientId = cid;
+        cmd.orderId        = id;
+        submit(std::move(cmd));
+    }
+};
+
+TEST_F(EngineRiskTest, RefusesOversizedOrdersWithoutDrawingAnId) {
+    newOrder(7, "C1", Side::Buy, 100, 11);
+    newOrder(7, "C1", Side::Buy, 100, 10);
+    EXPECT_EQ(replies(2), (std::vector<std::string>{"ERR RISK_ORDER_SIZE\n", "REQUEST_MADE 1\n"}));
+}
+
+TEST_F(EngineRiskTest, BandsPricesAroundTheLastTrade) {
+    newOrder(7, "C1", Side::Buy, 1000, 1);  // no trade yet: anything goes
+    newOrder(7, "C2", Side::Sell, 1000, 1);
+    newOrder(7, "C1", Side::Buy, 900, 1);
+    newOrder(7, "C1", Side::Buy, 899, 1);
+    newOrder(7, "C2", Side::Sell, 1101, 1);
+    EXPECT_EQ(replies(5),
+              (std::vector<std::string>{"REQUEST_MADE 1\n",
+                                        "REQUEST_MADE 2\n",
+                                        "REQUEST_MADE 3\n",
+                                        "ERR RISK_PRICE_BAND\n",
+                                        "ERR RISK_PRICE_BAND\n"}));
+}
+
+TEST_F(EngineRiskTest, ReleasesOpenQuantityOnFillsAndCancels) {
+    newOrder(7, "C1", Side::Buy, 100, 6);
+    newOrder(7, "C1", Side::Buy, 99, 5);   // 11 resting
+    newOrder(7, "C2", Side::Sell, 100, 4);  // trades 4 of C1's first order
+    newOrder(7, "C1", Side::Buy, 99, 8);   // 2 + 8
+    newOrder(7, "C1", Side::Buy, 99, 1);
+    cancel("C1", 4);
+    newOrder(7, "C1", Side::Buy, 99, 8);
+    EXPECT_EQ(replies(7),
+              (std::vector<std::string>{"REQUEST_MADE 1\n",
+                                        "ERR RISK_OPEN_QTY\n",
+                                        "REQUEST_MADE 2\n",
+                                        "REQUEST_MADE 3\n",
+                                        "ERR RISK_OPEN_QTY\n",
+                                        "ERR UNKNOWN_ORDER\n",
+                                        "ERR RISK_OPEN_QTY\n"}));
+
+    cancel("C1", 3);
+    newOrder(7, "C1", Side::Buy, 99, 8);
+    EXPECT_EQ(replies(2), (std::vector<std::string>{"CANCELLED 3\n", "REQUEST_MADE 4\n"}));
+}
+
+TEST_F(EngineRiskTest, ChecksAmendsAgainstWhatTheyReplace) {
+    newOrder(7, "C1", Side::Buy, 100, 6);
+
+    EngineCommand amend;
+    amend.kind           = EngineCommand::Kind::Amend;
+    amend.orderId        = 1;
+    amend.order.clientId = "C1";
+    amend.order.quantity = 10;  // replaces the 6, so 10 resting in all
+    submit(EngineCommand(amend));
+    newOrder(7, "C1", Side::Buy, 100, 1);
+    amend.order.quantity = 4;
+    submit(EngineCommand(amend));
+    newOrder(7, "C1", Side::Buy, 100, 6);
+    EXPECT_EQ(replies(5),
+              (std::vector<std::string>{"REQUEST_MADE 1\n",
+                                        "AMENDED 1\n",
+                                        "ERR RISK_OPEN_QTY\n",
+                                        "AMENDED 1\n",
+                                        "REQUEST_MADE 2\n"}));
+}
+
+TEST_F(EngineRiskTest, RefusesABatchAsAWhole) {
+    EngineCommand cmd;
+    cmd.kind           = EngineCommand::Kind::Batch;
+    cmd.replyTo.binary = true;
+    cmd.batch          = {OrderRequest{"C1", "TEST", Side::Buy, OrderType::Limit, 100, 6},
+                          OrderRequest{"C1", "TEST", Side::Buy, OrderType::Limit, 99, 6}};
+    submit(EngineCommand(cmd));
+    cmd.replyTo.binary = false;
+    submit(std::move(cmd));
+    newOrder(7, "C1", Side::Buy, 100, 10);
+
+    auto out = replies(3);
+    ASSERT_EQ(out.size(), 3u);
+    EXPECT_EQ(out[0], wire::reject(wire::RejectReason::OpenQuantity));
+    EXPECT_EQ(out[1], "ERR RISK_OPEN_QTY TEST\n");
+    EXPECT_EQ(out[2], "REQUEST_MADE 1\n") << "nothing of the batches rested";
+}
+
+class EngineJournalTest : public EngineTest {
+   protected:
+    std::string dir;
+    size_t      segmentBytes = journal::Journal::DEFAULT_SEGMENT;
+
+    void SetUp() override {
+        char tmpl[] = "/tmp/engine_journal_XXXXXX";
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        dir = tmpl;
+        auto wal = std::make_unique<journal::Journal>(dir, 1, 0, segmentBytes);
+        ASSERT_TRUE(wal->open());
+        engine.setJournal(std::move(wal));
+        EngineTest::SetUp();
+    }
+
+    void TearDown() override {
+        EngineTest::TearDown();
+        std::filesystem::remove_all(dir);
+    }
+
+    std::vector<journal::RecordKind> kinds() {
+        std::vector<journal::RecordKind> out;
+        journal::read(dir, [&](const journal::Position&, const journal::Record& r) {
+            out.push_back(r.kind);
+        });
+        return out;
+    }
+};
+
+TEST_F(EngineJournalTest, AnswersWhatItJournals) {
+    newOrder(7, "C1", Side::Sell, 100, 5);
+    newOrder(8, "C2", Side::Buy, 100, 5);
+
+    // replies are held until the burst is committed, but they still all go out
+    std::vector<journal::RecordKind> seen;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (seen.empty() && std::chrono::steady_clock::now() < deadline)
+        engine.drain(0, [&](EngineEvent& ev) {
+            if (ev.replyTo.fd == 8 && seen.empty())
+                seen = kinds();
+        });
+    EXPECT_EQ(seen,
+              (std::vector<journal::RecordKind>{journal::RecordKind::New,
+                                                journal::RecordKind::New,
+                                                journal::RecordKind::Fill,
+                                                journal::RecordKind::Fill}));
+}
+
+TEST_F(EngineJournalTest, JournalsOnlyCancelsThatApply) {
+    newOrder(7, "C1", Side::Buy, 100, 5);
+    for (std::string cid : {"C2", "C1"}) {
+        EngineCommand cancel;
+        cancel.kind           = EngineCommand::Kind::Cancel;
+        cancel.order.clientId = cid;
+        cancel.orderId        = 1;
+        submit(std::move(cancel));
+    }
+
+    auto events = collect(3);
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[1].text, "ERR UNKNOWN_ORDER\n");
+    EXPECT_EQ(events[2].text, "CANCELLED 1\n");
+    EXPECT_EQ(kinds(),
+              (std::vector<journal::RecordKind>{journal::RecordKind::New,
+                                                journal::RecordKind::Cancel}));
+}
+
+// Two records to a segment, so the third needs a new one.
+class EngineJournalFailureTest : public EngineJournalTest {
+   protected:
+    EngineJournalFailureTest() { segmentBytes = 2 * sizeof(journal::Record); }
+};
+
+TEST_F(EngineJournalFailureTest, RefusesBookChangesOnceTheJournalFails) {
+    newOrder(7, "C1", Side::Buy, 100, 5);
+    newOrder(7, "C1", Side::Buy, 99, 5);
+    ASSERT_EQ(collect(2).size(), 2u);
+
+    // the next segment cannot be created, so the third order goes unrecorded
+    std::filesystem::remove_all(dir);
+    newOrder(7, "C1", Side::Buy, 98, 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    newOrder(7, "C1", Side::Buy, 97, 5);
+    EngineCommand query;
+    query.kind  = EngineCommand::Kind::Query;
+    query.query = [](Instrument& i) { return std::to_string(i.getOrderMap().size()); };
+    submit(std::move(query));
+
+    auto events = collect(2);
+    ASSERT_EQ(events.size(), 2u) << "the unrecorded order is not acknowledged";
+    EXPECT_EQ(events[0].text, "ERR JOURNAL_FAILED\n");
+    EXPECT_EQ(events[1].text, "3") << "queries are still answered";
+}
+
+class EngineLadderJournalTest : public EngineJournalTest {
+   protected:
+    InstrumentSpec spec() const override {
+        InstrumentSpec s = EngineTest::spec();
+        s.book           = BookSpec{BookType::Ladder, 1, 1000};
+        return s;
+    }
+};
+
+TEST_F(EngineLadderJournalTest, DoesNotJournalAmendsOffTheLadder) {
+    newOrder(7, "C1", Side::Buy, 100, 5);
+    EngineCommand amend;
+    amend.kind           = EngineCommand::Kind::Amend;
+    amend.order.clientId = "C1";
+    amend.order.quantity = 5;
+    amend.order.price    = 5000;
+    amend.orderId        = 1;
+    submit(std::move(amend));
+
+    auto events = collect(2);
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[1].text, "ERR BAD_PRICE\n");
+    EXPECT_EQ(kinds(), std::vector<journal::RecordKind>{journal::RecordKind::New});
+}
@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <utils/fd_table.hpp>
+#include <vector>
+
+TEST(FdTableTest, IndexesByDescriptor) {
+    utils::FdTable<std::shared_ptr<int>> table;
+    table.insert(5, std::make_shared<int>(50));
+    table.insert(2, std::make_shared<int>(20));
+
+    EXPECT_EQ(table.size(), 2u);
+    ASSERT_NE(table.find(5), nullptr);
+    EXPECT_EQ(**table.find(5), 50);
+    EXPECT_EQ(table.find(3), nullptr);
+    EXPECT_EQ(table.find(-1), nullptr);
+    EXPECT_EQ(table.find(100), nullptr);
+
+    table.erase(5);
+    table.erase(5);
+    EXPECT_EQ(table.find(5), nullptr);
+    EXPECT_EQ(table.size(), 1u);
+}
+
+TEST(FdTableTest, VisitsEntriesInFdOrder) {
+    utils::FdTable<std::shared_ptr<int>> table;
+    for (int fd : {9, 4, 6}) table.insert(fd, std::make_shared<int>(fd));
+    table.erase(6);
+
+    std::vector<int> fds;
+    table.forEach([&](int fd, std::shared_ptr<int> &) { fds.push_back(fd); });
+    EXPECT_EQ(fds, (std::vector<int>{4, 9}));
+}
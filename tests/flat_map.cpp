@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <string>
+#include <utils/flat_map.hpp>
+
+// Sends every key to the same home slot, so erase has to shift whole probe runs.
+struct CollidingHash {
+    size_t operator()(int) const noexcept { return 7; }
+};
+
+TEST(FlatMapTest, InsertsFindsAndErases) {
+    utils::FlatMap<uint64_t, int> map;
+    for (uint64_t id = 1; id <= 1000; ++id) EXPECT_TRUE(map.emplace(id, int(id) * 2).second);
+    EXPECT_EQ(map.size(), 1000u);
+    EXPECT_FALSE(map.emplace(5, 0).second) << "existing keys are left alone";
+    EXPECT_EQ(map.find(5)->second, 10);
+
+    EXPECT_EQ(map.erase(uint64_t(5)), 1u);
+    EXPECT_EQ(map.erase(uint64_t(5)), 0u);
+    EXPECT_EQ(map.find(5), map.end());
+    EXPECT_EQ(map.size(), 999u);
+    for (uint64_t id = 6; id <= 1000; ++id) ASSERT_EQ(map.find(id)->second, int(id) * 2);
+}
+
+TEST(FlatMapTest, LooksUpStringsByView) {
+    utils::FlatMap<std::string, int> map;
+    map["alice"] = 1;
+    map["bob"]   = 2;
+
+    std::string_view key = "alice";
+    EXPECT_EQ(map.find(key)->second, 1);
+    EXPECT_TRUE(map.contains("bob"));
+    EXPECT_FALSE(map.contains("carol"));
+}
+
+TEST(FlatMapTest, EraseKeepsCollidingKeysReachable) {
+    utils::FlatMap<int, int, CollidingHash> map;
+    for (int k = 0; k < 10; ++k) map.emplace(k, k);
+
+    map.erase(3);
+    map.erase(0);
+    for (int k = 0; k < 10; ++k) {
+        if (k == 0 || k == 3)
+            EXPECT_FALSE(map.contains(k));
+        else
+            EXPECT_EQ(map.find(k)->second, k) << k;
+    }
+}
+
+TEST(FlatMapTest, MatchesStdMapUnderChurn) {
+    utils::FlatMap<uint64_t, uint64_t> map;
+    std::map<uint64_t, uint64_t>       reference;
+    std::mt19937_64                    rng(42);
+
+    for (int step = 0; step < 20000; ++step) {
+        uint64_t key = rng() % 512;
+        if (rng() % 3 == 0) {
+            EXPECT_EQ(map.erase(key), reference.erase(key));
+        } else {
+            map[key]       = step;
+            reference[key] = step;
+        }
+    }
+
+    ASSERT_EQ(map.size(), reference.size());
+    size_t seen = 0;
+    for (auto &[key, value] : map) {
+        EXPECT_EQ(reference.at(key), value);
+        ++seen;
+    }
+    EXPECT_EQ(seen, reference.size());
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <latency.hpp>
+#include <random>
+#include <thread>
+#include <utils/histogram.hpp>
+#include <vector>
+
+using utils::Histogram;
+
+TEST(Histogram, SmallValuesAreExact) {
+    Histogram h;
+    for (uint64_t v = 0; v < Histogram::SUB; ++v) h.record(v);
+    EXPECT_EQ(h.count(), Histogram::SUB);
+    EXPECT_EQ(h.min(), 0u);
+    EXPECT_EQ(h.max(), Histogram::SUB - 1);
+    EXPECT_EQ(h.percentile(50), Histogram::SUB / 2 - 1);
+    EXPECT_EQ(h.percentile(100), Histogram::SUB - 1);
+}
+
+TEST(Histogram, BucketsTileTheRange) {
+    for (size_t b = 0; b + 1 < Histogram::BUCKETS; ++b) {
+        ASSERT_EQ(Histogram::bucketOf(Histogram::lowestIn(b)), b);
+        ASSERT_EQ(Histogram::bucketOf(Histogram::highestIn(b)), b);
+        ASSERT_EQ(Histogram::highestIn(b) + 1, Histogram::lowestIn(b + 1));
+    }
+    EXPECT_EQ(Histogram::bucketOf(UINT64_MAX), Histogram::BUCKETS - 1);
+}
+
+TEST(Histogram, PercentilesStayWithinTheBucketError) {
+    std::mt19937_64       rng(3);
+    std::vector<uint64_t> values;
+    Histogram             h;
+    for (int i = 0; i < 100000; ++i) {
+        uint64_t v = 100 + rng() % 1000000;
+        values.push_back(v);
+        h.record(v);
+    }
+    std::sort(values.begin(), values.end());
+
+    for (double p : {50.0, 90.0, 99.0, 99.9}) {
+        uint64_t exact = values[static_cast<size_t>(p / 100 * values.size()) - 1];
+        uint64_t got   = h.percentile(p);
+        EXPECT_GE(got, exact) << p;
+        EXPECT_LE(got, exact + exact / Histogram::SUB + 1) << p;
+    }
+    EXPECT_EQ(h.percentile(100), values.back());
+    EXPECT_NEAR(h.mean(), 500100, 5000);
+}
+
+TEST(Histogram, AddMergesCountsAndExtremes) {
+    Histogram a, b, all;
+    a.record(10);
+    a.record(2000);
+    b.record(3);
+    b.record(70000);
+    all.add(a);
+    all.add(b);
+    all.add(Histogram{});
+    EXPECT_EQ(all.count(), 4u);
+    EXPECT_EQ(all.min(), 3u);
+    EXPECT_EQ(all.max(), 70000u);
+    EXPECT_EQ(all.percentile(50), 10u);
+    EXPECT_EQ(Histogram{}.percentile(99), 0u);
+}
+
+TEST(Histogram, ReadsWhileAnotherThreadRecords) {
+    Histogram         h;
+    std::atomic<bool> done{false};
+    std::thread       writer([&] {
+        for (uint64_t i = 1; i <= 200000; ++i) h.record(i % 5000);
+        done.store(true);
+    });
+    uint64_t last = 0;
+    while (!done.load()) {
+        uint64_t n = h.count();
+        EXPECT_GE(n, last);
+        last = n;
+        EXPECT_LE(h.percentile(99), 4999u);
+    }
+    writer.join();
+    EXPECT_EQ(h.count(), 200000u);
+}
+
+TEST(LatencyStats, IgnoresUnstampedIntervals) {
+    LatencyStats stats;
+    stats.record(Stage::Total, 0, 500);
+    stats.record(Stage::Match, 100, 350);
+    stats.record(Stage::Match, 400, 300);  // another core's clock ran behind
+    EXPECT_EQ(stats[Stage::Total].count(), 0u);
+    EXPECT_EQ(stats[Stage::Match].count(), 2u);
+    EXPECT_EQ(stats[Stage::Match].min(), 0u);
+    EXPECT_EQ(stats[Stage::Match].max(), 250u);
+}
@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include <instrument.hpp>
+
+class InstrumentTest : public ::testing::TestWithParam<BookType> {
+   protected:
+    std::shared_ptr<Instrument> inst;
+
+    void SetUp() override {
+        InstrumentSpec spec{
+                .symbol = "TEST", .tick = TickSize{2, 1}, .book = BookSpec{GetParam(), 1, 1 << 12}};
+        inst = makeInstrument(spec);
+    }
+
+    Placement last = Placement::Refused;
+
+    // Returns the new order's id; the outcome is left in `last`.
+    OrderId place(const std::string& cid,
+                  Side               side,
+                  Price              price,
+                  int                qty,
+                  TimeInForce        tif  = TimeInForce::GTC,
+                  OrderType          type = OrderType::Limit) {
+        Order*  o  = inst->createOrder(OrderRequest{cid, "TEST", side, type, price, qty, tif});
+        OrderId id = o->getId();
+        last       = inst->placeOrder(*o);
+        return id;
+    }
+
+    OrderId market(const std::string& cid, Side side, int qty, TimeInForce tif = TimeInForce::IOC) {
+        return place(cid, side, 0, qty, tif, OrderType::Market);
+    }
+
+    uint64_t levelQuantity(Side side) {
+        uint64_t total = 0;
+        inst->forEachLevel(side, [&](PriceLevelNode* n) { total += n->quantity(); }, SIZE_MAX);
+        return total;
+    }
+};
+
+TEST_P(InstrumentTest, AssignsIncreasingIds) {
+    OrderId a = place("C1", Side::Buy, 100, 5);
+    OrderId b = place("C1", Side::Buy, 101, 5);
+    EXPECT_EQ(last, Placement::Rested);
+
+    EXPECT_LT(a, b);
+    EXPECT_EQ(inst->findOrder(a)->getPrice(), 100);
+    EXPECT_EQ(inst->findOrder(b)->getPrice(), 101);
+}
+
+TEST_P(InstrumentTest, CancelRemovesRestingOrder) {
+    OrderId a = place("C1", Side::Buy, 100, 5);
+    OrderId b = place("C1", Side::Buy, 100, 7);
+
+    EXPECT_TRUE(inst->cancelOrder(a, "C1"));
+    EXPECT_EQ(inst->findOrder(a), nullptr);
+    EXPECT_EQ(levelQuantity(Side::Buy), 7u);
+
+    EXPECT_TRUE(inst->cancelOrder(b, "C1"));
+    EXPECT_EQ(levelQuantity(Side::Buy), 0u);
+    EXPECT_TRUE(inst->getOrderMap().empty());
+}
+
+TEST_P(InstrumentTest, CancelChecksOwnerAndLiveness) {
+    OrderId a = place("C1", Side::Sell, 100, 5);
+
+    EXPECT_FALSE(inst->cancelOrder(a, "C2"));
+    EXPECT_FALSE(inst->cancelOrder(a + 1, "C1"));
+    EXPECT_NE(inst->findOrder(a), nullptr);
+}
+
+TEST_P(InstrumentTest, KeepsFullLengthClientIdsInline) {
+    std::string cid(ClientId::CAPACITY - 1, 'x');
+    cid += 'y';  // past the small string buffer, still inside the order
+    OrderId a = place(cid, Side::Buy, 100, 5);
+
+    EXPECT_EQ(inst->findOrder(a)->getClientId(), cid);
+    EXPECT_FALSE(inst->cancelOrder(a, cid.substr(0, cid.size() - 1)));
+    EXPECT_TRUE(inst->cancelOrder(a, cid));
+
+    ClientId truncated(cid + "z");
+    EXPECT_EQ(truncated.view(), cid);
+}
+
+TEST_P(InstrumentTest, FilledOrdersLeaveTheMap) {
+    OrderId sell = place("C1", Side::Sell, 100, 5);
+    OrderId buy  = place("C2", Side::Buy, 100, 3);
+    EXPECT_EQ(last, Placement::Filled);
+
+    EXPECT_EQ(inst->findOrder(buy), nullptr);
+    ASSERT_NE(inst->findOrder(sell), nullptr);
+    EXPECT_EQ(inst->findOrder(sell)->getRemainingQuantity(), 2);
+    EXPECT_FALSE(inst->cancelOrder(buy, "C2"));
+}
+
+TEST_P(InstrumentTest, CrossingLimitRestsOnlyItsRemainder) {
+    place("C1", Side::Sell, 100, 5);
+    place("C1", Side::Sell, 101, 5);
+    OrderId buy = place("C2", Side::Buy, 101, 12);
+
+    EXPECT_EQ(last, Placement::Rested);
+    EXPECT_EQ(levelQuantity(Side::Sell), 0u);
+    ASSERT_NE(inst->findOrder(buy), nullptr);
+    EXPECT_EQ(inst->findOrder(buy)->getRemainingQuantity(), 2u);
+    EXPECT_EQ(inst->getLastTradePrice(), 101);
+}
+
+TEST_P(InstrumentTest, MarketOrderSweepsAndNeverRests) {
+    place("C1", Side::Buy, 100, 5);
+    place("C1", Side::Buy, 99, 5);
+
+    OrderId id = market("C2", Side::Sell, 7);
+    EXPECT_EQ(last, Placement::Filled);
+    EXPECT_EQ(inst->findOrder(id), nullptr);
+    EXPECT_EQ(levelQuantity(Side::Buy), 3u);
+    EXPECT_EQ(inst->getLastTradePrice(), 99);
+
+    market("C2", Side::Sell, 10);
+    EXPECT_EQ(last, Placement::Cancelled) << "the unfilled rest of a market order is dropped";
+    EXPECT_EQ(levelQuantity(Side::Sell), 0u);
+
+    market("C2", Side::Sell, 1);
+    EXPECT_EQ(last, Placement::Killed) << "nothing to trade against";
+}
+
+TEST_P(InstrumentTest, IocCancelsTheRemainder) {
+    place("C1", Side::Sell, 100, 4);
+
+    OrderId id = place("C2", Side::Buy, 100, 6, TimeInForce::IOC);
+    EXPECT_EQ(last, Placement::Cancelled);
+    EXPECT_EQ(inst->findOrder(id), nullptr);
+    EXPECT_EQ(levelQuantity(Side::Buy), 0u);
+    EXPECT_EQ(inst->getVolumeToday(), 4u);
+}
+
+TEST_P(InstrumentTest, FokFillsInFullOrNotAtAll) {
+    place("C1", Side::Sell, 100, 4);
+    place("C1", Side::Sell, 102, 4);
+
+    place("C2", Side::Buy, 101, 6, TimeInForce::FOK);
+    EXPECT_EQ(last, Placement::Killed) << "only 4 are offered at or below 101";
+    EXPECT_EQ(levelQuantity(Side::Sell), 8u);
+    EXPECT_EQ(inst->getVolumeToday(), 0u);
+
+    place("C2", Side::Buy, 102, 6, TimeInForce::FOK);
+    EXPECT_EQ(last, Placement::Filled);
+    EXPECT_EQ(levelQuantity(Side::Sell), 2u);
+}
+
+TEST_P(InstrumentTest, AmendDownKeepsPriority) {
+    OrderId a = place("C1", Side::Sell, 100, 5);
+    place("C2", Side::Sell, 100, 5);
+
+    EXPECT_EQ(inst->amendOrder(a, "C1", 2, 100), Amendment::Reduced);
+    EXPECT_EQ(levelQuantity(Side::Sell), 7u);
+
+    // still first in line
+    place("C3", Side::Buy, 100, 2);
+    EXPECT_EQ(inst->findOrder(a), nullptr);
+    EXPECT_EQ(levelQuantity(Side::Sell), 5u);
+}
+
+TEST_P(InstrumentTest, AmendUpOrAcrossRequeues) {
+    OrderId a = place("C1", Side::Sell, 100, 5);
+    OrderId b = place("C2", Side::Sell, 100, 5);
+
+    EXPECT_EQ(inst->amendOrder(a, "C1", 6, 100), Amendment::Requeued);
+    place("C3", Side::Buy, 100, 5);
+    EXPECT_EQ(inst->findOrder(b), nullptr) << "a larger order goes behind the level";
+    ASSERT_NE(inst->findOrder(a), nullptr);
+    EXPECT_EQ(inst->findOrder(a)->getRemainingQuantity(), 6u);
+
+    EXPECT_EQ(inst->amendOrder(a, "C1", 6, 102), Amendment::Requeued);
+    EXPECT_EQ(inst->findOrder(a)->getPrice(), 102);
+}
+
+TEST_P(InstrumentTest, AmendThatCrossesTrades) {
+    OrderId bid = place("C1", Side::Buy, 99, 4);
+    place("C2", Side::Sell, 101, 3);
+
+    EXPECT_EQ(inst->amendOrder(bid, "C1", 4, 101), Amendment::Requeued);
+    EXPECT_EQ(inst->getVolumeToday(), 3u);
+    EXPECT_EQ(inst->findOrder(bid)->getRemainingQuantity(), 1u);
+
+    place("C2", Side::Sell, 102, 5);
+    EXPECT_EQ(inst->amendOrder(bid, "C1", 1, 102), Amendment::Filled);
+    EXPECT_EQ(inst->findOrder(bid), nullptr);
+    EXPECT_EQ(levelQuantity(Side::Buy), 0u);
+}
+
+TEST_P(InstrumentTest, AmendChecksOwnerAndPrice) {
+    OrderId a = place("C1", Side::Buy, 100, 5);
+
+    EXPECT_EQ(inst->amendOrder(a, "C2", 1, 100), Amendment::Unknown);
+    EXPECT_EQ(inst->amendOrder(a + 1, "C1", 1, 100), Amendment::Unknown);
+    EXPECT_EQ(inst->amendOrder(a, "C1", 1, 0), Amendment::Refused);
+    EXPECT_EQ(levelQuantity(Side::Buy), 5u);
+}
+
+TEST_P(InstrumentTest, AcceptsPricesTheBookCanHold) {
+    EXPECT_TRUE(inst->accepts(Side::Buy, 1));
+    EXPECT_TRUE(inst->accepts(Side::Sell, 1 << 12));
+    EXPECT_FALSE(inst->accepts(Side::Buy, 0));
+    EXPECT_FALSE(inst->accepts(Side::Sell, -1));
+    // only the ladder has an upper bound
+    EXPECT_EQ(inst->accepts(Side::Buy, 1 << 13), GetParam() == BookType::AVL);
+}
+
+INSTANTIATE_TEST_SUITE_P(Books, InstrumentTest, ::testing::Values(BookType::AVL, BookType::Ladder));
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <instrument.hpp>
+#include <journal.hpp>
+#include <vector>
+
+class JournalTest : public ::testing::Test {
+   protected:
+    std::string                 dir;
+    std::shared_ptr<Instrument> inst;
+
+    void SetUp() override {
+        char tmpl[] = "/tmp/journal_test_XXXXXX";
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        dir  = tmpl;
+        inst = makeInstrument(
+                InstrumentSpec{.symbol = "TEST", .tick = TickSize{2, 1}, .book = BookSpec{}});
+    }
+
+    void TearDown() override { std::filesystem::remove_all(dir); }
+
+    // Places an order the way the engine does: journaled before it is placed.
+    OrderId place(journal::Journal&  j,
+                  Instrument&        i,
+                  const std::string& cid,
+                  Side               side,
+                  Price              price,
+                  int                qty) {
+        Order  *o  = i.createOrder(OrderRequest{cid, "TEST", side, OrderType::Limit, price, qty});
+        OrderId id = o->getId();
+        j.newOrder(i, *o);
+        i.placeOrder(*o);
+        return id;
+    }
+
+    std::vector<journal::Record> readAll() {
+        std::vector<journal::Record> records;
+        journal::read(dir, [&](const journal::Position&, const journal::Record& r) {
+            records.push_back(r);
+        });
+        return records;
+    }
+};
+
+TEST_F(JournalTest, RecordsAreFixedSize) {
+    EXPECT_EQ(sizeof(journal::Record), 4u + 4 + 5 * 8 + 8 + 24);
+}
+
+TEST_F(JournalTest, ReadsBackWhatWasAppended) {
+    {
+        journal::Journal j(dir, 1, 0);
+        ASSERT_TRUE(j.open());
+        place(j, *inst, "C1", Side::Buy, 100, 5);
+        j.cancel(*inst, "C1", 1);
+        j.amend(*inst, "C2", 7, 3, 101);
+        j.commit();
+    }
+
+    auto records = readAll();
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].kind, journal::RecordKind::New);
+    EXPECT_EQ(records[0].orderId, 1u);
+    EXPECT_EQ(records[0].price, 100);
+    EXPECT_EQ(journal::field(records[0].symbol, journal::SYMBOL_LEN), "TEST");
+    EXPECT_EQ(journal::field(records[0].clientId, journal::CLIENT_ID_LEN), "C1");
+    EXPECT_EQ(records[1].kind, journal::RecordKind::Cancel);
+    EXPECT_EQ(records[2].kind, journal::RecordKind::Amend);
+    EXPECT_EQ(records[2].sequence, 3u);
+    EXPECT_EQ(journal::nextEpoch(dir), 2u);
+}
+
+TEST_F(JournalTest, RollsOverToNewSegments) {
+    {
+        journal::Journal j(dir, 1, 0, 4 * sizeof(journal::Record));
+        ASSERT_TRUE(j.open());
+        for (int k = 0; k < 10; ++k) j.cancel(*inst, "C1", k);
+    }
+
+    auto records = readAll();
+    ASSERT_EQ(records.size(), 10u);
+    for (size_t k = 0; k < records.size(); ++k) EXPECT_EQ(records[k].orderId, k);
+}
+
+TEST_F(JournalTest, PrunesSegmentsASnapshotCovers) {
+    {
+        journal::Journal j(dir, 1, 0, 4 * sizeof(journal::Record));
+        ASSERT_TRUE(j.open());
+        for (int k = 0; k < 10; ++k) j.cancel(*inst, "C1", k);
+        j.prune(10);
+    }
+
+    auto records = readAll();
+    ASSERT_EQ(records.size(), 2u) << "only the open segment is left";
+    EXPECT_EQ(records[0].sequence, 9u);
+}
+
+TEST_F(JournalTest, KeepsSegmentsWithRecordsPastThePrune) {
+    {
+        journal::Journal j(dir, 1, 0, 4 * sizeof(journal::Record));
+        ASSERT_TRUE(j.open());
+        for (int k = 0; k < 10; ++k) j.cancel(*inst, "C1", k);
+        j.prune(6);  // the second segment still holds records 7 and 8
+    }
+
+    auto records = readAll();
+    ASSERT_EQ(records.size(), 6u);
+    EXPECT_EQ(records[0].sequence, 5u);
+}
+
+TEST_F(JournalTest, RemovesEarlierEpochs) {
+    for (uint64_t epoch = 1; epoch <= 3; ++epoch) {
+        journal::Journal j(dir, epoch, 0);
+        ASSERT_TRUE(j.open());
+        j.cancel(*inst, "C1", epoch);
+    }
+
+    EXPECT_EQ(journal::removeBefore(dir, 3), 2u);
+    auto records = readAll();
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0].orderId, 3u);
+    EXPECT_EQ(journal::nextEpoch(dir), 4u);
+}
+
+TEST_F(JournalTest, StopsAtADamagedRecord) {
+    {
+        journal::Journal j(dir, 1, 0);
+        ASSERT_TRUE(j.open());
+        for (int k = 0; k < 3; ++k) j.cancel(*inst, "C1", k);
+    }
+
+    // tear the second record as a crash in the middle of a write would
+    auto         file = std::filesystem::directory_iterator(dir)->path();
+    std::fstream f(file, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(sizeof(journal::Record) + offsetof(journal::Record, orderId));
+    f.put('\x7f');
+    f.close();
+
+    EXPECT_EQ(readAll().size(), 1u);
+}
+
+TEST_F(JournalTest, ReplayRebuildsTheBook) {
+    {
+        journal::Journal j(dir, 1, 0);
+        ASSERT_TRUE(j.open());
+        place(j, *inst, "C1", Side::Sell, 100, 5);
+        place(j, *inst, "C1", Side::Sell, 101, 5);
+        place(j, *inst, "C2", Side::Buy, 100, 3);  // fills 3 of order 1
+        j.cancel(*inst, "C1", 2);
+        inst->cancelOrder(2, "C1");
+        j.amend(*inst, "C1", 1, 1, 100);
+        inst->amendOrder(1, "C1", 1, 100);
+    }
+
+    auto fresh = makeInstrument(
+            InstrumentSpec{.symbol = "TEST", .tick = TickSize{2, 1}, .book = BookSpec{}});
+    for (auto& r : readAll()) EXPECT_TRUE(journal::apply(r, *fresh));
+
+    EXPECT_EQ(fresh->getOrderMap().size(), 1u);
+    ASSERT_NE(fresh->findOrder(1), nullptr);
+    EXPECT_EQ(fresh->findOrder(1)->getRemainingQuantity(), 1u);
+    EXPECT_EQ(fresh->getVolumeToday(), 3u);
+    EXPECT_EQ(fresh->createOrder(OrderRequest{"C3", "TEST", Side::Buy, OrderType::Limit, 1, 1})
+                      ->getId(),
+              4u)
+            << "the id sequence continues where it stopped";
+}
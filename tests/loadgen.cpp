@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <command.hpp>
+#include <loadgen.hpp>
+#include <protocol.hpp>
+#include <string>
+#include <vector>
+
+// Splits what a flow wrote into its request lines.
+static std::vector<CommandLine> requests(std::string& out) {
+    std::vector<CommandLine> lines;
+    for (size_t pos = 0, nl; (nl = out.find('\n', pos)) != std::string::npos; pos = nl + 1)
+        lines.emplace_back(out.data() + pos, nl - pos);
+    return lines;
+}
+
+class FlowTest : public ::testing::Test {
+   protected:
+    loadgen::Config config;
+    loadgen::Stats  stats;
+
+    void SetUp() override {
+        config.groups   = {"L1"};
+        config.pipeline = 4;
+        config.cancels  = 0;
+        config.cross    = 0;
+    }
+
+    void login(loadgen::Flow& flow) {
+        flow.onLine("OK AUTH", 1, stats);
+        flow.onLine("SUBSCRIEBED", 1, stats);
+    }
+};
+
+TEST_F(FlowTest, LogsInBeforeSendingOrders) {
+    loadgen::Flow flow(config, 7);
+    EXPECT_EQ(flow.clientId(), "LG7");
+    EXPECT_EQ(flow.hello(), "AUTH pawy LG7\nSUB L1\n");
+
+    std::string out;
+    EXPECT_FALSE(flow.next(out, 10, stats));
+    login(flow);
+    EXPECT_TRUE(flow.ready());
+    EXPECT_TRUE(flow.next(out, 10, stats));
+    EXPECT_EQ(stats.orders, 1u);
+}
+
+TEST_F(FlowTest, KeepsThePipelineFullAndMatchesAcksInOrder) {
+    loadgen::Flow flow(config, 0);
+    login(flow);
+
+    std::string out;
+    for (uint64_t t = 0; t < 4; ++t) EXPECT_TRUE(flow.next(out, 100 + t, stats));
+    EXPECT_FALSE(flow.next(out, 200, stats)) << "pipeline of 4";
+
+    auto lines = requests(out);
+    ASSERT_EQ(lines.size(), 4u);
+    for (auto& line : lines) {
+        EXPECT_EQ(line.verb(), Command::NewL);
+        EXPECT_EQ(line[2], "TSLA");
+        Price price = 0;
+        ASSERT_TRUE(parsePrice(line[4], config.tick, price));
+        Side side;
+        ASSERT_TRUE(parseSide(line[1], side));
+        // passive orders stay on their side of mid
+        EXPECT_TRUE(side == Side::Buy ? price < config.mid : price > config.mid) << line[4];
+        EXPECT_EQ(line.size(), 5u) << "GTC is the default";
+    }
+
+    flow.onLine("REQUEST_MADE 1", 150, stats);
+    flow.onLine("L1 TSLA 99.99 5 100.01 3", 151, stats);
+    flow.onLine("REQUEST_MADE 2", 160, stats);
+    EXPECT_EQ(flow.inFlight(), 2u);
+    EXPECT_EQ(flow.resting(), 2u);
+    EXPECT_EQ(stats.acks, 2u);
+    EXPECT_EQ(stats.ack.min(), 50u);
+    EXPECT_EQ(stats.ack.max(), 59u);
+    EXPECT_EQ(stats.marketData, 1u);
+    EXPECT_TRUE(flow.next(out, 170, stats));
+}
+
+TEST_F(FlowTest, CancelsItsOwnRestingOrders) {
+    config.cancels = 1;
+    loadgen::Flow flow(config, 0);
+    login(flow);
+
+    std::string out;
+    ASSERT_TRUE(flow.next(out, 0, stats));
+    flow.onLine("REQUEST_MADE 41", 5, stats);
+    out.clear();
+    ASSERT_TRUE(flow.next(out, 10, stats));
+    EXPECT_EQ(out, "CANCEL TSLA 41\n");
+    EXPECT_EQ(flow.resting(), 0u);
+
+    flow.onLine("CANCELLED 41", 25, stats);
+    EXPECT_EQ(stats.cancel.count(), 1u);
+    EXPECT_EQ(stats.cancel.max(), 15u);
+    EXPECT_EQ(flow.inFlight(), 0u);
+
+    // a cancel that lost the race to a fill
+    out.clear();
+    ASSERT_TRUE(flow.next(out, 30, stats));
+    flow.onLine("REQUEST_MADE 42", 31, stats);
+    ASSERT_TRUE(flow.next(out, 32, stats));
+    flow.onLine("ERR UNKNOWN_ORDER", 40, stats);
+    EXPECT_EQ(stats.errors, 1u);
+    EXPECT_EQ(flow.inFlight(), 0u);
+}
+
+TEST_F(FlowTest, TimesTheFirstExecutionOfACrossingOrder) {
+    config.cross = 1;
+    loadgen::Flow flow(config, 0);
+    login(flow);
+
+    std::string out;
+    ASSERT_TRUE(flow.next(out, 100, stats));
+    auto lines = requests(out);
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(lines[0][5], "IOC");
+
+    // executions come before the ack, the unfilled rest is cancelled after it
+    flow.onLine("EXEC TSLA 3@100.05", 130, stats);
+    flow.onLine("EXEC TSLA 2@100.06", 140, stats);
+    flow.onLine("REQUEST_MADE 9", 150, stats);
+    flow.onLine("CANCELLED 9", 151, stats);
+
+    EXPECT_EQ(stats.executions, 2u);
+    EXPECT_EQ(stats.exec.count(), 1u);
+    EXPECT_EQ(stats.exec.max(), 30u);
+    EXPECT_EQ(stats.cancel.count(), 0u) << "the IOC remainder answers no request";
+    EXPECT_EQ(flow.resting(), 0u);
+    EXPECT_EQ(flow.inFlight(), 0u);
+}
+
+TEST(LoadgenOptions, ParsesKeyValuePairs) {
+    loadgen::Config config;
+    std::string     error;
+    EXPECT_TRUE(loadgen::parseOption("sessions=2000", config, error));
+    EXPECT_TRUE(loadgen::parseOption("symbols=AAPL,TSLA", config, error));
+    EXPECT_TRUE(loadgen::parseOption("groups=", config, error));
+    EXPECT_TRUE(loadgen::parseOption("mid=250.50", config, error));
+    EXPECT_TRUE(loadgen::parseOption("seconds=30", config, error));
+    EXPECT_EQ(config.sessions, 2000u);
+    EXPECT_EQ(config.symbols, (std::vector<std::string>{"AAPL", "TSLA"}));
+    EXPECT_TRUE(config.groups.empty());
+    EXPECT_EQ(config.mid, 25050);
+    EXPECT_EQ(config.duration, std::chrono::seconds(30));
+
+    EXPECT_FALSE(loadgen::parseOption("cancels=1.5", config, error));
+    EXPECT_EQ(error, "bad value for cancels: 1.5");
+    EXPECT_FALSE(loadgen::parseOption("speed=3", config, error));
+    EXPECT_EQ(error, "unknown option: speed");
+    EXPECT_FALSE(loadgen::parseOption("sessions", config, error));
+}
+
+TEST(LoadgenOptions, SpreadsSessionsOverSymbols) {
+    loadgen::Config config;
+    config.symbols = {"AAPL", "TSLA"};
+    EXPECT_EQ(loadgen::Flow(config, 0).symbol(), "AAPL");
+    EXPECT_EQ(loadgen::Flow(config, 1).symbol(), "TSLA");
+    EXPECT_EQ(loadgen::Flow(config, 2).symbol(), "AAPL");
+}
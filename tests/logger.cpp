@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <logger.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A record as LOG_* builds it, without handing it to the background thread.
+template <typename... Args>
+static logging::Record record(logging::Level level, const char* format, const Args&... args) {
+    logging::Record r{};
+    r.format = format;
+    r.level  = level;
+    (logging::detail::encode(r, args), ...);
+    return r;
+}
+
+// Text after the "YYYY-mm-dd HH:MM:SS.mmm " timestamp.
+static std::string message(const std::string& line) {
+    return line.size() > 24 ? line.substr(24) : line;
+}
+
+TEST(LoggerFormat, SubstitutesArgumentsInOrder) {
+    std::string name = "alice";
+    auto        r    = record(logging::Level::Info,
+                      "{} sent {} for {} at {}, ok={}",
+                      name,
+                      uint16_t{10},
+                      "TSLA",
+                      -1.5,
+                      true);
+    EXPECT_EQ(message(logging::format(r)), "[INFO] alice sent 10 for TSLA at -1.5, ok=true");
+}
+
+TEST(LoggerFormat, StampsTheTimeOfTheCall) {
+    logging::Record r = record(logging::Level::Warn, "x");
+    r.ns              = 1'700'000'000'123'456'789ull;
+    std::string line  = logging::format(r);
+    ASSERT_EQ(line.size(), 24u + 8u);
+    EXPECT_EQ(line.substr(19, 5), ".123 ");
+    EXPECT_EQ(message(line), "[WARN] x");
+}
+
+TEST(LoggerFormat, RendersErrnoLater) {
+    errno  = ENOENT;
+    auto r = record(logging::Level::Error, "open: {}", logging::sysError());
+    errno  = 0;
+    EXPECT_EQ(message(logging::format(r)), std::string("[ERROR] open: ") + std::strerror(ENOENT));
+}
+
+TEST(LoggerFormat, KeepsPlaceholdersWithoutArguments) {
+    auto r = record(logging::Level::Info, "{} and {}", 1);
+    EXPECT_EQ(message(logging::format(r)), "[INFO] 1 and {}");
+}
+
+TEST(LoggerFormat, TruncatesWhatDoesNotFit) {
+    std::string long_text(logging::TEXT_BYTES + 50, 'x');
+    auto        r = record(logging::Level::Info, "{}|{}", long_text, std::string("tail"));
+    EXPECT_EQ(message(logging::format(r)), "[INFO] " + std::string(logging::TEXT_BYTES, 'x') + "|");
+
+    auto many = record(logging::Level::Info, "{}{}{}{}{}{}{}{}{}", 1, 2, 3, 4, 5, 6, 7, 8, 9);
+    EXPECT_EQ(many.count, logging::MAX_ARGS);
+    EXPECT_EQ(message(logging::format(many)), "[INFO] 12345678{}");
+}
+
+class LoggerOutput : public ::testing::Test {
+   protected:
+    int info  = -1;
+    int error = -1;
+
+    void SetUp() override {
+        info  = open("info");
+        error = open("error");
+        logging::setOutput(info, error);
+    }
+
+    void TearDown() override {
+        logging::setOutput(STDOUT_FILENO, STDERR_FILENO);
+        ::close(info);
+        ::close(error);
+    }
+
+    static int open(const char* name) {
+        std::string path = std::string("/tmp/logger_test_") + name + "_XXXXXX";
+        int         fd   = mkstemp(path.data());
+        unlink(path.c_str());
+        return fd;
+    }
+
+    static std::vector<std::string> lines(int fd) {
+        std::string text;
+        char        buf[4096];
+        ssize_t     n;
+        for (off_t at = 0; (n = pread(fd, buf, sizeof(buf), at)) > 0; at += n) text.append(buf, n);
+        std::vector<std::string> out;
+        std::istringstream       in(text);
+        for (std::string line; std::getline(in, line);) out.push_back(message(line));
+        return out;
+    }
+};
+
+TEST_F(LoggerOutput, SplitsLevelsOverTheTwoOutputs) {
+    ASSERT_GE(info, 0);
+    ASSERT_GE(error, 0);
+    LOG_DEBUG("compiled out at the default level {}", TRADESTACK_LOG_LEVEL);
+    LOG_INFO("reactor {} listening on port {}", 0, 9000);
+    LOG_WARN("journal: damaged record in {}", "seg");
+    LOG_ERROR("bind: {}", logging::SysError{EADDRINUSE});
+    logging::flush();
+
+    EXPECT_EQ(lines(info), (std::vector<std::string>{"[INFO] reactor 0 listening on port 9000"}));
+    std::vector<std::string> expected{"[WARN] journal: damaged record in seg",
+                                      std::string("[ERROR] bind: ") + std::strerror(EADDRINUSE)};
+    EXPECT_EQ(lines(error), expected);
+}
+
+TEST_F(LoggerOutput, KeepsEachThreadsOrderAndOutlivesTheThreads) {
+    constexpr int THREADS = 4, MESSAGES = 500;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < MESSAGES; ++i) {
+                LOG_INFO("thread {} message {}", t, i);
+                if (i % 100 == 99)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    logging::flush();
+
+    std::vector<int> next(THREADS, 0);
+    for (auto& line : lines(info)) {
+        int t = -1, i = -1;
+        ASSERT_EQ(std::sscanf(line.c_str(), "[INFO] thread %d message %d", &t, &i), 2) << line;
+        ASSERT_EQ(i, next[t]++) << "thread " << t;
+    }
+    for (int t = 0; t < THREADS; ++t) EXPECT_EQ(next[t], MESSAGES);
+    EXPECT_TRUE(lines(error).empty()) << "nothing dropped";
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <manager.hpp>
+#include <snapshot.hpp>
+
+static InstrumentSpec specFor(const std::string& symbol) {
+    return InstrumentSpec{.symbol = symbol, .tick = TickSize{2, 1}, .book = BookSpec{}};
+}
+
+TEST(Manager, AddsInstrumentsOnlyBeforeStarting) {
+    Manager manager;
+    EXPECT_TRUE(manager.new_instrument(specFor("TSLA")));
+    EXPECT_FALSE(manager.new_instrument(specFor("TSLA"))) << "symbol taken";
+
+    ASSERT_TRUE(manager.start(2));
+    ASSERT_NE(manager.route("TSLA"), nullptr);
+    EXPECT_FALSE(manager.new_instrument(specFor("AAPL"))) << "the engines are running";
+    EXPECT_EQ(manager.route("AAPL"), nullptr);
+    EXPECT_EQ(manager.instruments_.size(), 1u);
+
+    manager.stop();
+    EXPECT_TRUE(manager.new_instrument(specFor("AAPL")));
+}
+
+// Whether `dir` holds journal segments of `epoch`.
+static bool hasEpoch(const std::string& dir, uint64_t epoch) {
+    char prefix[16];
+    std::snprintf(prefix, sizeof(prefix), "%06llu-", static_cast<unsigned long long>(epoch));
+    for (auto& entry : std::filesystem::directory_iterator(dir))
+        if (entry.path().filename().string().starts_with(prefix))
+            return true;
+    return false;
+}
+
+TEST(Manager, RecoveryRemovesEpochsEverySnapshotCovers) {
+    char tmpl[] = "/tmp/manager_test_XXXXXX";
+    ASSERT_NE(mkdtemp(tmpl), nullptr);
+    std::string dir = tmpl;
+
+    auto tsla = makeInstrument(specFor("TSLA"));
+    auto aapl = makeInstrument(specFor("AAPL"));
+    for (uint64_t epoch = 1; epoch <= 2; ++epoch) {
+        journal::Journal j(dir, epoch, 0);
+        ASSERT_TRUE(j.open());
+        j.cancel(*tsla, "C1", 1);
+    }
+    ASSERT_TRUE(snapshot::write(*tsla, {2, 0, 1}, snapshot::pathFor(dir, "TSLA")));
+
+    auto recover = [&] {
+        Manager manager;
+        manager.new_instrument(specFor("TSLA"));
+        manager.new_instrument(specFor("AAPL"));
+        manager.recover(dir);
+    };
+    recover();
+    EXPECT_TRUE(hasEpoch(dir, 1)) << "AAPL has no snapshot, so all of its journal may be needed";
+
+    ASSERT_TRUE(snapshot::write(*aapl, {2, 0, 1}, snapshot::pathFor(dir, "AAPL")));
+    recover();
+    EXPECT_FALSE(hasEpoch(dir, 1));
+    EXPECT_TRUE(hasEpoch(dir, 2));
+
+    std::filesystem::remove_all(dir);
+}
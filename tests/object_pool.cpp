@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <utils/object_pool.hpp>
+
+class ObjectPoolTest : public ::testing::Test {
+   protected:
+    struct Item {
+        int  value;
+        int* destroyed;
+
+        Item(int v, int* d) : value(v), destroyed(d) {}
+        ~Item() { ++*destroyed; }
+    };
+
+    int                     destroyed = 0;
+    utils::ObjectPool<Item> pool{4};
+};
+
+TEST_F(ObjectPoolTest, CreatesAndDestroysObjects) {
+    Item* a = pool.create(1, &destroyed);
+    Item* b = pool.create(2, &destroyed);
+
+    EXPECT_EQ(a->value, 1);
+    EXPECT_EQ(b->value, 2);
+    EXPECT_EQ(pool.inUse(), 2);
+
+    pool.destroy(a);
+    EXPECT_EQ(destroyed, 1) << "destroy() must run the destructor";
+    EXPECT_EQ(pool.inUse(), 1);
+
+    pool.destroy(b);
+    EXPECT_EQ(pool.inUse(), 0);
+}
+
+TEST_F(ObjectPoolTest, RecyclesFreedBlocks) {
+    Item* a = pool.create(1, &destroyed);
+    pool.destroy(a);
+
+    Item* b = pool.create(2, &destroyed);
+    EXPECT_EQ(a, b) << "most recently freed block must be handed out first";
+    EXPECT_EQ(pool.capacity(), 4) << "recycling must not grow the pool";
+    pool.destroy(b);
+}
+
+TEST_F(ObjectPoolTest, GrowsBySlab) {
+    std::vector<Item*> items;
+    for (int i = 0; i < 5; ++i) items.push_back(pool.create(i, &destroyed));
+
+    EXPECT_EQ(pool.capacity(), 8) << "fifth allocation must add a second slab of 4";
+    for (int i = 0; i < 5; ++i) EXPECT_EQ(items[i]->value, i);
+
+    for (Item* it : items) pool.destroy(it);
+    EXPECT_EQ(pool.inUse(), 0);
+}
+
+TEST_F(ObjectPoolTest, ReserveGrowsAhead) {
+    pool.reserve(9);
+    EXPECT_GE(pool.capacity(), 9);
+    size_t cap = pool.capacity();
+
+    std::vector<Item*> items;
+    for (int i = 0; i < 9; ++i) items.push_back(pool.create(i, &destroyed));
+    EXPECT_EQ(pool.capacity(), cap) << "reserved blocks must be served without growing";
+
+    for (Item* it : items) pool.destroy(it);
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <order_queue.hpp>
+
+class OrderQueueTest : public ::testing::Test {
+   protected:
+    OrderQueue q;
+    Order      a{1, "C1", 100, 10, Side::Buy, OrderType::Limit};
+    Order      b{2, "C2", 100, 20, Side::Buy, OrderType::Limit};
+    Order      c{3, "C3", 100, 30, Side::Buy, OrderType::Limit};
+
+    void SetUp() override {
+        q.push_back(&a);
+        q.push_back(&b);
+        q.push_back(&c);
+    }
+};
+
+TEST_F(OrderQueueTest, KeepsFifoOrderAndAggregates) {
+    EXPECT_EQ(q.size(), 3);
+    EXPECT_EQ(q.quantity(), 60) << "Aggregate quantity must be the sum of all remaining quantities";
+    EXPECT_EQ(q.front(), &a);
+    EXPECT_EQ(q.back(), &c);
+
+    std::vector<Order*> seen(q.begin(), q.end());
+    EXPECT_EQ(seen, (std::vector<Order*>{&a, &b, &c}));
+}
+
+TEST_F(OrderQueueTest, ErasesFromAnyPosition) {
+    q.erase(&b);
+    EXPECT_EQ(q.size(), 2);
+    EXPECT_EQ(q.quantity(), 40);
+    EXPECT_EQ(a.next, &c);
+    EXPECT_EQ(c.prev, &a);
+
+    q.erase(&a);
+    EXPECT_EQ(q.front(), &c);
+    q.erase(&c);
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ(q.front(), nullptr);
+    EXPECT_EQ(q.back(), nullptr);
+    EXPECT_EQ(q.quantity(), 0);
+}
+
+TEST_F(OrderQueueTest, FillReducesAggregate) {
+    q.fill(&a, 4);
+    EXPECT_EQ(a.getRemainingQuantity(), 6);
+    EXPECT_EQ(a.getFilledQuantity(), 4);
+    EXPECT_EQ(q.quantity(), 56);
+
+    EXPECT_EQ(q.pop_front(), &a);
+    EXPECT_EQ(q.quantity(), 50) << "Popping must only subtract what is still remaining";
+}
+
+TEST_F(OrderQueueTest, ReduceKeepsPosition) {
+    q.reduce(&b, 15);
+    EXPECT_EQ(b.getRemainingQuantity(), 5);
+    EXPECT_EQ(b.getFilledQuantity(), 0) << "an amend is not a fill";
+    EXPECT_EQ(q.quantity(), 45);
+
+    std::vector<Order*> seen(q.begin(), q.end());
+    EXPECT_EQ(seen, (std::vector<Order*>{&a, &b, &c}));
+}
+
+TEST_F(OrderQueueTest, SwapExchangesContents) {
+    OrderQueue other;
+    q.swap(other);
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ(other.size(), 3);
+    EXPECT_EQ(other.quantity(), 60);
+    EXPECT_EQ(other.front(), &a);
+}
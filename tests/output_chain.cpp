@@ -0,0 +1,109 @@
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <output_chain.hpp>
+#include <string>
+
+class OutputChainTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+    }
+
+    void TearDown() override {
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    std::string readAll() {
+        std::string out;
+        char        buf[65536];
+        ssize_t     n;
+        while ((n = read(fds[1], buf, sizeof(buf))) > 0) out.append(buf, n);
+        return out;
+    }
+
+    int fds[2];
+};
+
+TEST_F(OutputChainTest, CoalescesSmallWrites) {
+    OutputChain out;
+    out.append(std::string_view("PONG\n"));
+    out.append(std::string_view("OK AUTH\n"));
+    EXPECT_EQ(out.size(), 13u);
+
+    EXPECT_EQ(out.flush(fds[0]), OutputChain::Status::Done);
+    EXPECT_TRUE(out.empty());
+    EXPECT_EQ(readAll(), "PONG\nOK AUTH\n");
+}
+
+TEST_F(OutputChainTest, KeepsOrderAcrossLargeChunks) {
+    OutputChain out;
+    std::string big(OutputChain::COALESCE_LIMIT * 2, 'x');
+    out.append(std::string_view("head\n"));
+    out.append(std::string(big));
+    out.append(std::string_view("tail\n"));
+
+    EXPECT_EQ(out.flush(fds[0]), OutputChain::Status::Done);
+    EXPECT_EQ(readAll(), "head\n" + big + "tail\n");
+}
+
+TEST_F(OutputChainTest, SharesPayloadsWithoutCopying) {
+    utils::Payload update = utils::makePayload("F1_UPDATE\n");
+
+    OutputChain a, b;
+    a.append(std::string_view("PONG\n"));
+    a.append(update);
+    a.append(std::string_view("OK\n"));
+    b.append(update);
+    EXPECT_EQ(update.use_count(), 3);
+
+    EXPECT_EQ(a.flush(fds[0]), OutputChain::Status::Done);
+    EXPECT_EQ(readAll(), "PONG\nF1_UPDATE\nOK\n");
+    EXPECT_EQ(update.use_count(), 2);  // released once sent
+
+    b.clear();
+    EXPECT_EQ(update.use_count(), 1);
+}
+
+TEST_F(OutputChainTest, ResumesAfterBlocking) {
+    int small = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+
+    OutputChain out;
+    std::string expected;
+    for (int i = 0; i < 20000; ++i) {
+        std::string line = "EXEC AAPL " + std::to_string(i) + "@1.00\n";
+        expected += line;
+        out.append(std::string_view(line));
+    }
+
+    std::string received;
+    int         rounds = 0;
+    while (true) {
+        auto status = out.flush(fds[0]);
+        ASSERT_NE(status, OutputChain::Status::Error);
+        received += readAll();
+        if (status == OutputChain::Status::Done)
+            break;
+        ++rounds;
+    }
+    received += readAll();
+
+    EXPECT_GT(rounds, 0);  // the socket filled up at least once
+    EXPECT_TRUE(out.empty());
+    EXPECT_EQ(received, expected);
+}
+
+TEST_F(OutputChainTest, ReportsClosedPeer) {
+    close(fds[1]);
+    fds[1] = open("/dev/null", O_RDONLY);
+
+    OutputChain out;
+    out.append(std::string_view("PONG\n"));
+    EXPECT_EQ(out.flush(fds[0]), OutputChain::Status::Error);
+}
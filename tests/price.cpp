@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <price.hpp>
+
+TEST(PriceTest, ParsesIntoTicks) {
+    TickSize cents{2, 1};
+    Price    p = 0;
+
+    ASSERT_TRUE(parsePrice("250", cents, p));
+    EXPECT_EQ(p, 25000);
+    ASSERT_TRUE(parsePrice("250.5", cents, p));
+    EXPECT_EQ(p, 25050);
+    ASSERT_TRUE(parsePrice("250.05", cents, p));
+    EXPECT_EQ(p, 25005);
+    ASSERT_TRUE(parsePrice("0.01", cents, p));
+    EXPECT_EQ(p, 1);
+    ASSERT_TRUE(parsePrice("1.500", cents, p)) << "Zeros past the quoted precision are accepted";
+    EXPECT_EQ(p, 150);
+    ASSERT_TRUE(parsePrice(".5", cents, p));
+    EXPECT_EQ(p, 50);
+}
+
+TEST(PriceTest, RespectsTickMultiple) {
+    TickSize nickels{2, 5};
+    Price    p = 0;
+
+    ASSERT_TRUE(parsePrice("10.05", nickels, p));
+    EXPECT_EQ(p, 201) << "10.05 is 201 ticks of 0.05";
+    EXPECT_FALSE(parsePrice("10.03", nickels, p)) << "Off-tick prices must be refused";
+
+    TickSize whole{0, 1};
+    ASSERT_TRUE(parsePrice("42", whole, p));
+    EXPECT_EQ(p, 42);
+    EXPECT_FALSE(parsePrice("42.5", whole, p));
+}
+
+TEST(PriceTest, RejectsMalformedInput) {
+    TickSize cents{2, 1};
+    Price    p = 0;
+
+    EXPECT_FALSE(parsePrice("", cents, p));
+    EXPECT_FALSE(parsePrice(".", cents, p));
+    EXPECT_FALSE(parsePrice("1.2.3", cents, p));
+    EXPECT_FALSE(parsePrice("-1", cents, p));
+    EXPECT_FALSE(parsePrice("12a", cents, p));
+    EXPECT_FALSE(parsePrice("1.234", cents, p)) << "Sub-tick precision must be refused";
+    EXPECT_FALSE(parsePrice("99999999999999999999", cents, p)) << "Overflow must be refused";
+}
+
+TEST(PriceTest, ParsesUpToTheLargestTick) {
+    TickSize whole{0, 1};
+    Price    p = 0;
+
+    ASSERT_TRUE(parsePrice("9223372036854775807", whole, p));
+    EXPECT_EQ(p, INT64_MAX);
+    EXPECT_FALSE(parsePrice("9223372036854775808", whole, p)) << "one past INT64_MAX";
+    EXPECT_FALSE(parsePrice("9223372036854775809", whole, p));
+    EXPECT_FALSE(parsePrice("922337203685477580.8", TickSize{1, 1}, p));
+    EXPECT_FALSE(parsePrice("922337203685477581", TickSize{1, 1}, p)) << "overflows when scaled";
+}
+
+TEST(PriceTest, FormatsWithQuotedPrecision) {
+    EXPECT_EQ(formatPrice(25050, TickSize{2, 1}), "250.50");
+    EXPECT_EQ(formatPrice(1, TickSize{2, 1}), "0.01");
+    EXPECT_EQ(formatPrice(201, TickSize{2, 5}), "10.05");
+    EXPECT_EQ(formatPrice(42, TickSize{0, 1}), "42");
+    EXPECT_EQ(formatPrice(-150, TickSize{2, 1}), "-1.50");
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <order.hpp>
+#include <price_ladder.hpp>
+#include <price_level_node.hpp>
+
+class PriceLadderTest : public ::testing::Test {
+   protected:
+    // 10000 levels: spans several bitmap words and more than one summary word
+    PriceLadder<PriceLevelNode> ladder{100, 5, 10000};
+
+    Order make(uint64_t price, int qty = 10) {
+        return Order(price, "C1", price, qty, Side::Buy, OrderType::Limit);
+    }
+};
+
+TEST_F(PriceLadderTest, AddressesLevelsByTick) {
+    Order a = make(100);
+    Order b = make(105);
+
+    PriceLevelNode* A = ladder.insert(a);
+    PriceLevelNode* B = ladder.insert(b);
+
+    ASSERT_NE(A, nullptr);
+    ASSERT_NE(B, nullptr);
+    EXPECT_EQ(A->price, 100);
+    EXPECT_EQ(B->price, 105);
+    EXPECT_EQ(B - A, 1) << "Adjacent ticks must be adjacent in memory";
+    EXPECT_EQ(ladder.find(105), B);
+    EXPECT_EQ(ladder.find(110), nullptr) << "Empty level must not be found";
+    EXPECT_EQ(ladder.size(), 2);
+}
+
+TEST_F(PriceLadderTest, RefusesOffLadderPrices) {
+    Order below   = make(95);
+    Order offTick = make(102);
+    Order above   = make(100 + 5 * 10000);
+
+    EXPECT_EQ(ladder.insert(below), nullptr);
+    EXPECT_EQ(ladder.insert(offTick), nullptr);
+    EXPECT_EQ(ladder.insert(above), nullptr);
+    EXPECT_TRUE(ladder.empty());
+}
+
+TEST_F(PriceLadderTest, StepsBestPricesAcrossWords) {
+    uint64_t prices[] = {100, 100 + 5 * 63, 100 + 5 * 64, 100 + 5 * 4100, 100 + 5 * 9999};
+    std::vector<Order> orders;
+    for (uint64_t p : prices) orders.push_back(make(p));
+    for (auto& o : orders) ladder.insert(o);
+
+    EXPECT_EQ(ladder.low->price, prices[0]);
+    EXPECT_EQ(ladder.high->price, prices[4]);
+
+    for (size_t i = 0; i + 1 < orders.size(); ++i) {
+        EXPECT_EQ(ladder.remove(orders[i]), nullptr);
+        ASSERT_NE(ladder.low, nullptr);
+        EXPECT_EQ(ladder.low->price, prices[i + 1]) << "low must step to the next occupied level";
+    }
+
+    ladder.insert(orders[0]);
+    ladder.insert(orders[3]);
+    EXPECT_EQ(ladder.remove(orders[4]), nullptr);
+    EXPECT_EQ(ladder.high->price, prices[3]) << "high must step back across summary words";
+    EXPECT_EQ(ladder.remove(orders[3]), nullptr);
+    EXPECT_EQ(ladder.high->price, prices[0]);
+    EXPECT_EQ(ladder.remove(orders[0]), nullptr);
+    EXPECT_EQ(ladder.low, nullptr);
+    EXPECT_EQ(ladder.high, nullptr);
+}
+
+TEST_F(PriceLadderTest, VisitsLevelsInOrder) {
+    std::vector<Order> orders;
+    for (uint64_t p : {300, 100, 200, 5000}) orders.push_back(make(p));
+    for (auto& o : orders) ladder.insert(o);
+
+    std::vector<uint64_t> seen;
+    ladder.inorder([&](PriceLevelNode* node) { seen.push_back(node->price); }, 3);
+    EXPECT_EQ(seen, (std::vector<uint64_t>{100, 200, 300}));
+
+    size_t released = 0;
+    ladder.clear([&](Order*) { ++released; });
+    EXPECT_EQ(released, 4);
+    EXPECT_TRUE(ladder.empty());
+    EXPECT_EQ(ladder.find(100), nullptr);
+}
+
+TEST_F(PriceLadderTest, StepsToNeighbouringLevels) {
+    Order a = make(100);
+    Order b = make(100 + 5 * 700);
+    Order c = make(100 + 5 * 9000);
+
+    PriceLevelNode* A = ladder.insert(a);
+    PriceLevelNode* B = ladder.insert(b);
+    PriceLevelNode* C = ladder.insert(c);
+
+    EXPECT_EQ(ladder.above(A), B);
+    EXPECT_EQ(ladder.above(B), C);
+    EXPECT_EQ(ladder.above(C), nullptr);
+    EXPECT_EQ(ladder.below(C), B);
+    EXPECT_EQ(ladder.below(B), A);
+    EXPECT_EQ(ladder.below(A), nullptr);
+}
+
+TEST_F(PriceLadderTest, IteratesFromBestPrice) {
+    std::vector<Order> orders;
+    for (uint64_t p : {300, 100, 200, 5000}) orders.push_back(make(p));
+    for (auto& o : orders) ladder.insert(o);
+
+    std::vector<uint64_t> seen;
+    for (PriceLevelNode& level : ladder.descending(2)) seen.push_back(level.price);
+    EXPECT_EQ(seen, (std::vector<uint64_t>{5000, 300}));
+}
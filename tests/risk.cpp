@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <risk.hpp>
+
+using risk::Verdict;
+
+TEST(RiskBand, MeasuresBasisPointsFromTheReference) {
+    EXPECT_TRUE(risk::withinBand(10500, 10000, 500));
+    EXPECT_FALSE(risk::withinBand(10501, 10000, 500));
+    EXPECT_TRUE(risk::withinBand(9500, 10000, 500));
+    EXPECT_FALSE(risk::withinBand(9499, 10000, 500));
+    EXPECT_TRUE(risk::withinBand(1, 10000, 0)) << "no band";
+    EXPECT_TRUE(risk::withinBand(1, 0, 500)) << "no trade yet";
+    EXPECT_FALSE(risk::withinBand(INT64_MAX, INT64_MAX / 3, 10000)) << "no overflow";
+}
+
+TEST(RiskChecker, LetsEverythingThroughWithoutLimits) {
+    risk::Checker checker;
+    EXPECT_EQ(checker.check("C1", UINT32_MAX, 1, 1'000'000, true), Verdict::Pass);
+    checker.add("C1", 100, 5);
+    EXPECT_EQ(checker.exposure("C1").quantity, 0u) << "nothing to track";
+}
+
+TEST(RiskChecker, ChecksSizeAndBandOnEveryOrder) {
+    risk::Checker checker(risk::Limits{100, 50, 0, 0});
+    EXPECT_EQ(checker.check("C1", 50, 1010, 1000, false), Verdict::Pass);
+    EXPECT_EQ(checker.check("C1", 51, 1000, 1000, false), Verdict::OrderSize);
+    EXPECT_EQ(checker.check("C1", 10, 1011, 1000, false), Verdict::PriceBand);
+    EXPECT_EQ(checker.check("C1", 10, 0, 1000, false), Verdict::Pass) << "market order";
+}
+
+TEST(RiskChecker, TracksRestingExposurePerClient) {
+    risk::Checker checker(risk::Limits{0, 0, 100, 10'000});
+    checker.add("C1", 60, 100);
+    EXPECT_EQ(checker.check("C1", 40, 100, 0, true), Verdict::Pass);
+    EXPECT_EQ(checker.check("C1", 41, 10, 0, true), Verdict::OpenQuantity);
+    EXPECT_EQ(checker.check("C1", 30, 200, 0, true), Verdict::OpenNotional);
+    EXPECT_EQ(checker.check("C1", 41, 10, 0, false), Verdict::Pass) << "cannot rest";
+    EXPECT_EQ(checker.check("C2", 100, 100, 0, true), Verdict::Pass);
+
+    // an amend of the 60 to 90 replaces it
+    risk::Exposure replaced{60, risk::notional(60, 100)};
+    EXPECT_EQ(checker.check("C1", 90, 100, 0, true, replaced), Verdict::Pass);
+
+    checker.remove("C1", 20, 100);
+    EXPECT_EQ(checker.exposure("C1").quantity, 40u);
+    EXPECT_EQ(checker.exposure("C1").notional, 4000u);
+    checker.remove("C1", 100, 100);
+    EXPECT_EQ(checker.exposure("C1").quantity, 0u) << "never below zero";
+    EXPECT_EQ(checker.exposure("C1").notional, 0u);
+}
+
+TEST(RiskChecker, SaturatesHugeNotionals) {
+    EXPECT_EQ(risk::notional(UINT64_MAX / 2, 3), UINT64_MAX);
+    risk::Checker checker(risk::Limits{0, 0, 0, UINT64_MAX - 1});
+    EXPECT_EQ(checker.check("C1", UINT64_MAX / 2, 3, 0, true), Verdict::OpenNotional);
+}
+
+TEST(RiskThrottle, RefillsAtTheRateUpToTheBurst) {
+    using namespace std::chrono_literals;
+    risk::Throttle throttle(1000, 10);  // one per millisecond
+    auto           t = std::chrono::steady_clock::time_point{} + 1h;
+
+    for (int i = 0; i < 10; ++i) EXPECT_TRUE(throttle.admit(t)) << i;
+    EXPECT_FALSE(throttle.admit(t));
+    EXPECT_FALSE(throttle.admit(t + 999us));
+    EXPECT_TRUE(throttle.admit(t + 1ms));
+    EXPECT_FALSE(throttle.admit(t + 1ms));
+
+    EXPECT_FALSE(throttle.admit(t + 5ms, 5)) << "four back";
+    EXPECT_TRUE(throttle.admit(t + 10s, 10)) << "capped at the burst";
+    EXPECT_FALSE(throttle.admit(t + 10s));
+    EXPECT_FALSE(throttle.admit(t + 20s, 11)) << "more than the burst never fits";
+}
+
+TEST(RiskThrottle, UnlimitedWithoutARate) {
+    risk::Throttle throttle;
+    for (int i = 0; i < 100000; ++i) ASSERT_TRUE(throttle.admit({}));
+}
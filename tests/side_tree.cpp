@@ -5,19 +5,14 @@
 class SideTreeTest : public ::testing::Test {
    protected:
     struct MockNode {
-        int               price;
-        int               height;
-        std::list<Order*> level;
-        MockNode*         left;
-        MockNode*         right;
-
-        void leanCopy(const MockNode* other) {
-            if (!other)
-                return;
-            price  = other->price;
-            level  = other->level;
-            height = other->height;
-        }
+        int        price;
+        int        height;
+        OrderQueue level;
+        MockNode*  left;
+        MockNode*  right;
+        MockNode*  parent = nullptr;
+        MockNode*  prev   = nullptr;
+        MockNode*  next   = nullptr;
 
         MockNode(int k, MockNode* l = nullptr, MockNode* r = nullptr)
             : price(k), height(1), left(l), right(r) {}
@@ -28,10 +23,10 @@ class SideTreeTest : public ::testing::Test {
 
     void SetUp() override {
         st  = new SideTree<MockNode>();
-        o   = new Order("MCK123", "C456", 100, 10, Side::Buy, OrderType::Limit);
-        o10 = new Order("MCK458", "C245", 10, 25, Side::Buy, OrderType::Limit);
-        o20 = new Order("MCK564", "C325", 20, 16, Side::Buy, OrderType::Limit);
-        o30 = new Order("MCK154", "C426", 30, 32, Side::Buy, OrderType::Limit);
+        o   = new Order(123, "C456", 100, 10, Side::Buy, OrderType::Limit);
+        o10 = new Order(458, "C245", 10, 25, Side::Buy, OrderType::Limit);
+        o20 = new Order(564, "C325", 20, 16, Side::Buy, OrderType::Limit);
+        o30 = new Order(154, "C426", 30, 32, Side::Buy, OrderType::Limit);
     }
 
     void TearDown() override {
@@ -53,9 +48,9 @@ TEST_F(SideTreeTest, InsertsInEmptyTree) {
 }
 
 TEST_F(SideTreeTest, InsertsInNonEmptyTree) {
-    Order o10("MCK458", "C245", 10, 25, Side::Buy, OrderType::Limit);
-    Order o20("MCK564", "C325", 20, 16, Side::Buy, OrderType::Limit);
-    Order o30("MCK154", "C426", 30, 32, Side::Buy, OrderType::Limit);
+    Order o10(458, "C245", 10, 25, Side::Buy, OrderType::Limit);
+    Order o20(564, "C325", 20, 16, Side::Buy, OrderType::Limit);
+    Order o30(154, "C426", 30, 32, Side::Buy, OrderType::Limit);
 
     MockNode* first  = st->insert(o10);
     MockNode* second = st->insert(o20);
@@ -83,11 +78,11 @@ TEST_F(SideTreeTest, InsertsInNonEmptyTree) {
 }
 
 TEST_F(SideTreeTest, RemovesOrderFromLevel) {
-    Order oA("MCK458", "C245", 10, 25, Side::Buy, OrderType::Limit);
-    Order oB("MCK564", "C325", 20, 16, Side::Buy, OrderType::Limit);
-    Order oC("MCK154", "C226", 30, 32, Side::Buy, OrderType::Limit);
-    Order oD("MCK574", "C386", 30, 32, Side::Buy, OrderType::Limit);
-    Order oE("MCK964", "C455", 30, 32, Side::Buy, OrderType::Limit);
+    Order oA(458, "C245", 10, 25, Side::Buy, OrderType::Limit);
+    Order oB(564, "C325", 20, 16, Side::Buy, OrderType::Limit);
+    Order oC(154, "C226", 30, 32, Side::Buy, OrderType::Limit);
+    Order oD(574, "C386", 30, 32, Side::Buy, OrderType::Limit);
+    Order oE(964, "C455", 30, 32, Side::Buy, OrderType::Limit);
 
     MockNode* A = st->insert(oA);
     MockNode* B = st->insert(oB);
@@ -98,11 +93,11 @@ TEST_F(SideTreeTest, RemovesOrderFromLevel) {
     ASSERT_NE(C, nullptr);
 
     EXPECT_EQ(A->level.size(), 1);
-    EXPECT_EQ(A->level.front()->getId(), "MCK458");
+    EXPECT_EQ(A->level.front()->getId(), 458);
     EXPECT_EQ(B->level.size(), 1);
-    EXPECT_EQ(B->level.front()->getId(), "MCK564");
+    EXPECT_EQ(B->level.front()->getId(), 564);
     EXPECT_EQ(C->level.size(), 1);
-    EXPECT_EQ(C->level.front()->getId(), "MCK154");
+    EXPECT_EQ(C->level.front()->getId(), 154);
 
     MockNode* D = st->insert(oD);
     MockNode* E = st->insert(oE);
@@ -114,8 +109,8 @@ TEST_F(SideTreeTest, RemovesOrderFromLevel) {
     EXPECT_EQ(E, C);
 
     EXPECT_EQ(C->level.size(), 3);
-    EXPECT_EQ(C->level.front()->getId(), "MCK154");
-    EXPECT_EQ(C->level.back()->getId(), "MCK964");
+    EXPECT_EQ(C->level.front()->getId(), 154);
+    EXPECT_EQ(C->level.back()->getId(), 964);
 
     MockNode* F = st->remove(oA);
     EXPECT_EQ(F, nullptr) << "Removing last order at price 10 must delete node";
@@ -124,10 +119,90 @@ TEST_F(SideTreeTest, RemovesOrderFromLevel) {
 
     EXPECT_EQ(G, C);
     EXPECT_EQ(C->level.size(), 2);
-    EXPECT_EQ(C->level.front()->getId(), "MCK574");
-    EXPECT_EQ(C->level.back()->getId(), "MCK964");
+    EXPECT_EQ(C->level.front()->getId(), 574);
+    EXPECT_EQ(C->level.back()->getId(), 964);
 }
 
 
+TEST_F(SideTreeTest, StepsBestPricesWhenLevelEmpties) {
+    Order oA(458, "C245", 10, 25, Side::Buy, OrderType::Limit);
+    Order oB(564, "C325", 20, 16, Side::Buy, OrderType::Limit);
+    Order oC(154, "C226", 30, 32, Side::Buy, OrderType::Limit);
+
+    MockNode* A = st->insert(oA);
+    MockNode* B = st->insert(oB);
+    MockNode* C = st->insert(oC);
+
+    EXPECT_EQ(st->low, A);
+    EXPECT_EQ(st->high, C);
+
+    EXPECT_EQ(st->remove(oC, C), nullptr);
+    EXPECT_EQ(st->high, B) << "high must step to the next lower level";
+
+    EXPECT_EQ(st->remove(oA), nullptr);
+    EXPECT_EQ(st->low, B) << "low must step to the next higher level";
+    EXPECT_EQ(st->root, B);
+
+    EXPECT_EQ(st->remove(oB, B), nullptr);
+    EXPECT_EQ(st->low, nullptr);
+    EXPECT_EQ(st->high, nullptr);
+    EXPECT_EQ(st->root, nullptr);
+    EXPECT_TRUE(st->empty());
+}
+
 TEST_F(SideTreeTest, FindsPriceLevel) {
-}
\ No newline at end of file
+}
+
+TEST_F(SideTreeTest, IteratesLevelsFromEitherEnd) {
+    std::vector<Order> orders;
+    for (int p : {30, 10, 50, 20, 40})
+        orders.emplace_back(p, "C1", p, 1, Side::Buy, OrderType::Limit);
+    for (auto& order : orders) st->insert(order);
+
+    std::vector<int> up, down;
+    for (MockNode& level : st->ascending()) up.push_back(level.price);
+    for (MockNode& level : st->descending(3)) down.push_back(level.price);
+
+    EXPECT_EQ(up, (std::vector<int>{10, 20, 30, 40, 50}));
+    EXPECT_EQ(down, (std::vector<int>{50, 40, 30})) << "descending(3) must stop after 3 levels";
+
+    auto none = st->ascending(0);
+    EXPECT_TRUE(none.begin() == none.end());
+
+    for (auto& order : orders) st->remove(order);
+}
+
+TEST_F(SideTreeTest, BulkLoadBuildsABalancedTree) {
+    std::vector<Order> orders;
+    orders.reserve(200);
+    for (int p = 1; p <= 100; ++p)
+        for (int k = 0; k < 2; ++k)
+            orders.emplace_back(p * 10 + k, "C1", p, 1, Side::Buy, OrderType::Limit);
+    std::vector<Order*> sorted;
+    for (auto& order : orders) sorted.push_back(&order);
+
+    st->bulkLoad(sorted);
+
+    EXPECT_EQ(st->size(), 200u);
+    ASSERT_NE(st->root, nullptr);
+    EXPECT_LE(st->root->height, 7) << "100 levels fit in a tree of height 7";
+    EXPECT_EQ(st->low->price, 1);
+    EXPECT_EQ(st->high->price, 100);
+
+    int expected = 1;
+    for (MockNode& level : st->ascending()) {
+        EXPECT_EQ(level.price, expected++);
+        ASSERT_EQ(level.level.size(), 2u);
+        EXPECT_EQ(level.level.front()->id, static_cast<OrderId>(level.price * 10))
+                << "orders keep their FIFO order";
+    }
+    EXPECT_EQ(expected, 101);
+
+    // the built tree takes ordinary inserts and removes
+    Order late(5000, "C2", 50, 1, Side::Buy, OrderType::Limit);
+    EXPECT_EQ(st->insert(late), st->find(50));
+    EXPECT_EQ(st->find(50)->level.back(), &late);
+    st->remove(late);
+    for (auto& order : orders) st->remove(order);
+    EXPECT_TRUE(st->empty());
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <instrument.hpp>
+#include <journal.hpp>
+#include <snapshot.hpp>
+#include <vector>
+
+class SnapshotTest : public ::testing::TestWithParam<BookType> {
+   protected:
+    std::string                 dir;
+    std::string                 path;
+    std::shared_ptr<Instrument> inst;
+
+    void SetUp() override {
+        char tmpl[] = "/tmp/snapshot_test_XXXXXX";
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        dir  = tmpl;
+        path = snapshot::pathFor(dir, "TEST");
+        inst = fresh();
+    }
+
+    void TearDown() override { std::filesystem::remove_all(dir); }
+
+    std::shared_ptr<Instrument> fresh(const std::string& symbol = "TEST") {
+        return makeInstrument(
+                InstrumentSpec{.symbol = symbol,
+                               .tick   = TickSize{2, 1},
+                               .book   = BookSpec{GetParam(), 1, 1 << 12}});
+    }
+
+    OrderId place(Instrument&        i,
+                  journal::Journal*  j,
+                  const std::string& cid,
+                  Side               side,
+                  Price              price,
+                  int                qty,
+                  TimeInForce        tif = TimeInForce::GTC) {
+        Order*  o = i.createOrder(
+                OrderRequest{cid, "TEST", side, OrderType::Limit, price, qty, tif});
+        OrderId id = o->getId();
+        if (j)
+            j->newOrder(i, *o);
+        i.placeOrder(*o);
+        return id;
+    }
+
+    // (client, id, remaining) of one side, lowest price first and FIFO within a price
+    static std::vector<std::tuple<std::string, OrderId, uint64_t>> side(Instrument& i, Side s) {
+        std::vector<std::tuple<std::string, OrderId, uint64_t>> out;
+        i.forEachLevel(
+                s,
+                [&](PriceLevelNode* n) {
+                    for (Order* o : n->level)
+                        out.emplace_back(o->clientId, o->id, o->remainingQuantity);
+                },
+                SIZE_MAX);
+        return out;
+    }
+};
+
+TEST_P(SnapshotTest, RoundTripsTheBook) {
+    place(*inst, nullptr, "C1", Side::Sell, 105, 5);
+    place(*inst, nullptr, "C2", Side::Sell, 105, 7);
+    place(*inst, nullptr, "C1", Side::Sell, 110, 2);
+    place(*inst, nullptr, "C3", Side::Buy, 100, 4);
+    place(*inst, nullptr, "C2", Side::Buy, 100, 6);
+    place(*inst, nullptr, "C3", Side::Buy, 95, 1);
+    place(*inst, nullptr, "C4", Side::Buy, 105, 3);  // trades 3 of the first ask
+
+    ASSERT_TRUE(snapshot::write(*inst, journal::Position{3, 1, 42}, path));
+
+    auto              copy = fresh();
+    journal::Position at;
+    ASSERT_TRUE(snapshot::load(*copy, path, at));
+
+    EXPECT_EQ(at.epoch, 3u);
+    EXPECT_EQ(at.engine, 1u);
+    EXPECT_EQ(at.sequence, 42u);
+    EXPECT_EQ(side(*copy, Side::Buy), side(*inst, Side::Buy));
+    EXPECT_EQ(side(*copy, Side::Sell), side(*inst, Side::Sell));
+    EXPECT_EQ(copy->getOrderMap().size(), inst->getOrderMap().size());
+    ASSERT_NE(copy->findOrder(1), nullptr);
+    EXPECT_EQ(copy->findOrder(1)->getFilledQuantity(), 3u);
+
+    EXPECT_EQ(copy->getVolumeToday(), 3u);
+    EXPECT_EQ(copy->getVWAPNumerator(), inst->getVWAPNumerator());
+    EXPECT_EQ(copy->getLastTradePrice(), 105);
+    EXPECT_EQ(copy->getOpen(), inst->getOpen());
+    EXPECT_EQ(copy->getHigh(), inst->getHigh());
+    EXPECT_EQ(copy->getLow(), inst->getLow());
+    EXPECT_EQ(copy->nextOrderId(), inst->nextOrderId());
+}
+
+TEST_P(SnapshotTest, RestoredOrdersTradeAndCancel) {
+    place(*inst, nullptr, "C1", Side::Sell, 105, 5);
+    place(*inst, nullptr, "C2", Side::Sell, 105, 7);
+    OrderId bid = place(*inst, nullptr, "C3", Side::Buy, 100, 4);
+    ASSERT_TRUE(snapshot::write(*inst, {}, path));
+
+    auto              copy = fresh();
+    journal::Position at;
+    ASSERT_TRUE(snapshot::load(*copy, path, at));
+
+    // time priority survives: the first ask fills before the second
+    OrderId taker = place(*copy, nullptr, "C4", Side::Buy, 105, 6);
+    EXPECT_EQ(taker, 4u) << "ids continue after the snapshot";
+    EXPECT_EQ(copy->findOrder(1), nullptr);
+    ASSERT_NE(copy->findOrder(2), nullptr);
+    EXPECT_EQ(copy->findOrder(2)->getRemainingQuantity(), 6u);
+
+    EXPECT_TRUE(copy->cancelOrder(bid, "C3"));
+    EXPECT_TRUE(side(*copy, Side::Buy).empty());
+}
+
+TEST_P(SnapshotTest, RefusesADamagedFile) {
+    place(*inst, nullptr, "C1", Side::Buy, 100, 4);
+    ASSERT_TRUE(snapshot::write(*inst, {}, path));
+
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(-1, std::ios::end);
+        f.put('\x7f');
+    }
+
+    auto              copy = fresh();
+    journal::Position at;
+    EXPECT_FALSE(snapshot::load(*copy, path, at));
+    EXPECT_TRUE(copy->getOrderMap().empty()) << "nothing is loaded from a damaged snapshot";
+}
+
+TEST_P(SnapshotTest, RefusesAnotherSymbolsSnapshot) {
+    place(*inst, nullptr, "C1", Side::Buy, 100, 4);
+    ASSERT_TRUE(snapshot::write(*inst, {}, path));
+
+    auto              other = fresh("OTHER");
+    journal::Position at;
+    EXPECT_FALSE(snapshot::load(*other, path, at));
+}
+
+TEST_P(SnapshotTest, ReplaysOnlyTheJournalTail) {
+    journal::Journal j(dir, 1, 0);
+    ASSERT_TRUE(j.open());
+    place(*inst, &j, "C1", Side::Sell, 105, 5);
+    place(*inst, &j, "C2", Side::Buy, 100, 5);
+    ASSERT_TRUE(snapshot::write(*inst, j.position(), path));
+
+    place(*inst, &j, "C3", Side::Buy, 105, 2);  // after the snapshot
+    j.cancel(*inst, "C2", 2);
+    inst->cancelOrder(2, "C2");
+    j.commit();
+
+    auto              copy = fresh();
+    journal::Position at;
+    ASSERT_TRUE(snapshot::load(*copy, path, at));
+
+    size_t replayed = 0;
+    journal::read(
+            dir,
+            [&](const journal::Position& rec, const journal::Record& r) {
+                if (journal::covers(at, rec))
+                    return;
+                EXPECT_TRUE(journal::apply(r, *copy));
+                ++replayed;
+            },
+            at.epoch);
+
+    EXPECT_EQ(replayed, 2u);
+    EXPECT_EQ(side(*copy, Side::Sell), side(*inst, Side::Sell));
+    EXPECT_TRUE(side(*copy, Side::Buy).empty());
+    EXPECT_EQ(copy->getVolumeToday(), 2u);
+    EXPECT_EQ(copy->nextOrderId(), inst->nextOrderId());
+}
+
+TEST(JournalPosition, CoversEarlierRecordsOnly) {
+    journal::Position snap{2, 1, 10};
+    EXPECT_TRUE(journal::covers(snap, {1, 3, 500}));
+    EXPECT_TRUE(journal::covers(snap, {2, 1, 10}));
+    EXPECT_FALSE(journal::covers(snap, {2, 1, 11}));
+    EXPECT_FALSE(journal::covers(snap, {2, 0, 1})) << "another engine's journal of the same run";
+    EXPECT_FALSE(journal::covers(snap, {3, 1, 1}));
+    EXPECT_FALSE(journal::covers(journal::Position{}, {1, 0, 1}));
+}
+
+INSTANTIATE_TEST_SUITE_P(Books, SnapshotTest, ::testing::Values(BookType::AVL, BookType::Ladder));
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <utils/spsc_ring.hpp>
+
+TEST(SpscRingTest, RoundsCapacityUpToPowerOfTwo) {
+    utils::SpscRing<int> ring(5);
+    EXPECT_EQ(ring.capacity(), 8u);
+}
+
+TEST(SpscRingTest, RefusesPushWhenFull) {
+    utils::SpscRing<int> ring(4);
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(ring.tryPush(int(i)));
+    EXPECT_FALSE(ring.tryPush(4));
+
+    int v;
+    ASSERT_TRUE(ring.tryPop(v));
+    EXPECT_EQ(v, 0);
+    EXPECT_TRUE(ring.tryPush(4));
+}
+
+TEST(SpscRingTest, PopsInFifoOrder) {
+    utils::SpscRing<std::string> ring(4);
+    ring.tryPush("a");
+    ring.tryPush("b");
+
+    std::string v;
+    ASSERT_TRUE(ring.tryPop(v));
+    EXPECT_EQ(v, "a");
+    ASSERT_TRUE(ring.tryPop(v));
+    EXPECT_EQ(v, "b");
+    EXPECT_FALSE(ring.tryPop(v));
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTest, TransfersAcrossThreadsWithoutLoss) {
+    constexpr uint64_t        N = 200'000;
+    utils::SpscRing<uint64_t> ring(1024);
+
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < N; ++i)
+            while (!ring.tryPush(uint64_t(i))) std::this_thread::yield();
+    });
+
+    uint64_t expected = 0, v;
+    bool     inOrder  = true;
+    while (expected < N) {
+        if (ring.tryPop(v)) {
+            inOrder &= v == expected;
+            ++expected;
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(inOrder);
+    EXPECT_TRUE(ring.empty());
+}
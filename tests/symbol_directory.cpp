@@ -0,0 +1,24 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <symbol_directory.hpp>
+
+TEST(SymbolDirectoryTest, InternsToDenseIds) {
+    SymbolDirectory dir;
+    EXPECT_EQ(dir.intern("TSLA"), 0u);
+    EXPECT_EQ(dir.intern("AAPL"), 1u);
+    EXPECT_EQ(dir.intern(std::string("TSLA")), 0u) << "known symbols keep their id";
+    EXPECT_EQ(dir.size(), 2u);
+
+    EXPECT_EQ(dir.find("AAPL"), 1u);
+    EXPECT_EQ(dir.find("MSFT"), NO_SYMBOL);
+    EXPECT_EQ(dir.find(""), NO_SYMBOL);
+    EXPECT_EQ(dir.name(1), "AAPL");
+}
+
+TEST(SymbolDirectoryTest, ScalesToManySymbols) {
+    SymbolDirectory dir;
+    for (int i = 0; i < 5000; ++i) ASSERT_EQ(dir.intern("S" + std::to_string(i)), SymbolId(i));
+    for (int i = 0; i < 5000; ++i) ASSERT_EQ(dir.find("S" + std::to_string(i)), SymbolId(i));
+    EXPECT_EQ(dir.name(4321), "S4321");
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <utils/timer_wheel.hpp>
+#include <vector>
+
+using Wheel = utils::TimerWheel<int>;
+
+// Advances one tick at a time and records which values fired at which tick.
+static std::vector<std::pair<uint64_t, int>> run(Wheel& wheel, uint64_t to) {
+    std::vector<std::pair<uint64_t, int>> fired;
+    while (wheel.now() < to)
+        wheel.advance(wheel.now() + 1, [&](int v) { fired.emplace_back(wheel.now(), v); });
+    return fired;
+}
+
+TEST(TimerWheelTest, FiresAtTheDeadline) {
+    Wheel wheel(1000);
+    wheel.schedule(1005, 1);
+    wheel.schedule(1001, 2);
+    wheel.schedule(1064, 3);  // just past level 0
+    EXPECT_EQ(wheel.size(), 3u);
+
+    auto fired = run(wheel, 1100);
+    EXPECT_EQ(fired, (std::vector<std::pair<uint64_t, int>>{{1001, 2}, {1005, 1}, {1064, 3}}));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, PastDeadlinesFireOnTheNextTick) {
+    Wheel wheel(50);
+    wheel.schedule(10, 7);
+    wheel.schedule(50, 8);
+    auto fired = run(wheel, 51);
+    EXPECT_EQ(fired.size(), 2u);
+    for (auto& [at, v] : fired) EXPECT_EQ(at, 51u) << v;
+}
+
+TEST(TimerWheelTest, CascadesThroughEveryLevel) {
+    Wheel                 wheel(12345);
+    std::vector<uint64_t> deadlines{12345 + 63,
+                                    12345 + 64,
+                                    12345 + 4095,
+                                    12345 + 4096,
+                                    12345 + 262143,
+                                    12345 + 262144,
+                                    12345 + Wheel::SPAN - 1,
+                                    12345 + Wheel::SPAN + 70,  // beyond the top level
+                                    12345 + 2 * Wheel::SPAN};
+    for (size_t i = 0; i < deadlines.size(); ++i) wheel.schedule(deadlines[i], static_cast<int>(i));
+
+    std::vector<uint64_t> at(deadlines.size(), 0);
+    wheel.advance(12345 + 2 * Wheel::SPAN, [&](int v) { at[v] = wheel.now(); });
+    EXPECT_EQ(at, deadlines);
+}
+
+TEST(TimerWheelTest, CancelsAndIgnoresStaleHandles) {
+    Wheel wheel;
+    auto  a = wheel.schedule(10, 1);
+    auto  b = wheel.schedule(10, 2);
+    EXPECT_TRUE(wheel.cancel(a));
+    EXPECT_FALSE(wheel.cancel(a));
+
+    // the node is reused, the old handle must not reach the new timer
+    auto c = wheel.schedule(20, 3);
+    EXPECT_EQ(c.index, a.index);
+    EXPECT_FALSE(wheel.cancel(a));
+
+    auto fired = run(wheel, 30);
+    EXPECT_EQ(fired, (std::vector<std::pair<uint64_t, int>>{{10, 2}, {20, 3}}));
+    EXPECT_FALSE(wheel.cancel(b)) << "already fired";
+    EXPECT_FALSE(wheel.cancel(Wheel::Handle{}));
+}
+
+TEST(TimerWheelTest, CallbackMayRescheduleAndCancel) {
+    Wheel wheel;
+    auto  other = wheel.schedule(5, 100);
+    wheel.schedule(5, 1);
+    int fires = 0;
+    wheel.advance(50, [&](int v) {
+        ++fires;
+        if (v == 1) {
+            wheel.cancel(other);
+            wheel.schedule(wheel.now() + 10, 2);
+        }
+    });
+    // 100 and 1 share a slot; whichever fires first, 2 always follows
+    EXPECT_GE(fires, 2);
+    EXPECT_LE(fires, 3);
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, MatchesASortedMapOnRandomTimers) {
+    std::mt19937_64                                   rng(7);
+    Wheel                                             wheel(1'000'000);
+    std::multimap<uint64_t, int>                      expected;
+    std::map<int, std::pair<Wheel::Handle, uint64_t>> live;
+
+    uint64_t now = wheel.now();
+    for (int id = 0; id < 20000; ++id) {
+        uint64_t spread = rng() % 3 == 0 ? 300000 : 200;
+        uint64_t at     = now + 1 + rng() % spread;
+        live[id]        = {wheel.schedule(at, id), at};
+        if (rng() % 5 == 0) {
+            auto victim = live.begin();
+            EXPECT_TRUE(wheel.cancel(victim->second.first));
+            live.erase(victim);
+        }
+        if (id % 10 == 0) {
+            now += rng() % 50;
+            wheel.advance(now, [&](int v) {
+                ASSERT_EQ(live.count(v), 1u);
+                EXPECT_EQ(live[v].second, wheel.now()) << v;
+                live.erase(v);
+            });
+        }
+    }
+    for (auto& [id, timer] : live) expected.emplace(timer.second, id);
+
+    std::multimap<uint64_t, int> fired;
+    wheel.advance(now + 400000, [&](int v) { fired.emplace(wheel.now(), v); });
+    EXPECT_EQ(fired.size(), expected.size());
+    for (auto& [at, id] : expected) {
+        auto range = fired.equal_range(at);
+        bool found = false;
+        for (auto it = range.first; it != range.second; ++it) found |= it->second == id;
+        EXPECT_TRUE(found) << id << " at " << at;
+    }
+    EXPECT_TRUE(wheel.empty());
+}
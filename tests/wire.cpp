@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <wire.hpp>
+
+TEST(WireTest, LayoutsArePacked) {
+    EXPECT_EQ(sizeof(wire::Header), 3u);
+    EXPECT_EQ(sizeof(wire::NewOrder), 3u + 8 + 1 + 4 + 8 + 1 + 1);
+    EXPECT_EQ(sizeof(wire::Cancel), 3u + 8 + 8);
+    EXPECT_EQ(sizeof(wire::Amend), 3u + 8 + 8 + 4 + 8);
+    EXPECT_EQ(sizeof(wire::Ack), 3u + 1 + 8);
+    EXPECT_EQ(sizeof(wire::Exec), 3u + 8 + 8 + 4 + 8);
+    EXPECT_EQ(sizeof(wire::Reject), 3u + 1);
+    EXPECT_EQ(sizeof(wire::BatchHeader), 3u + 8 + 2);
+    EXPECT_EQ(sizeof(wire::BatchEntry), 1u + 1 + 1 + 4 + 8);
+    EXPECT_EQ(sizeof(wire::BatchAck), 3u + 8 + 8 + 2 + 2);
+    EXPECT_EQ(sizeof(wire::BatchReject), 2u + 1);
+}
+
+TEST(WireTest, BatchAckLengthCoversRejects) {
+    std::string frame = wire::batchAck("TEST", 5, 3, {{1, wire::RejectReason::BadPrice}});
+
+    wire::BatchAck ack;
+    std::memcpy(&ack, frame.data(), sizeof(ack));
+    EXPECT_EQ(frame.size(), sizeof(wire::BatchAck) + sizeof(wire::BatchReject));
+    EXPECT_EQ(ack.hdr.length, frame.size());
+    EXPECT_EQ(ack.rejected, 1u);
+    EXPECT_EQ(uint8_t(frame.back()), uint8_t(wire::RejectReason::BadPrice));
+}
+
+TEST(WireTest, EncodesHeaderLittleEndian) {
+    std::string frame = wire::reject(wire::RejectReason::BadQty);
+
+    ASSERT_EQ(frame.size(), 4u);
+    EXPECT_EQ(uint8_t(frame[0]), 4);
+    EXPECT_EQ(uint8_t(frame[1]), 0);
+    EXPECT_EQ(uint8_t(frame[2]), 0x83);
+    EXPECT_EQ(uint8_t(frame[3]), uint8_t(wire::RejectReason::BadQty));
+}
+
+TEST(WireTest, SymbolsAreNulPadded) {
+    wire::Cancel m{};
+    wire::setSymbol(m.symbol, "TSLA");
+    EXPECT_EQ(wire::symbolOf(m.symbol), "TSLA");
+
+    wire::setSymbol(m.symbol, "ABCDEFGHIJ");
+    EXPECT_EQ(wire::symbolOf(m.symbol), "ABCDEFGH");
+}
+
+TEST(WireTest, SplitsLongTextAcrossFrames) {
+    std::string out;
+    wire::appendText(out, std::string(70000, 'x'));
+
+    wire::Header first;
+    std::memcpy(&first, out.data(), sizeof(first));
+    EXPECT_EQ(first.type, wire::MsgType::Text);
+    EXPECT_EQ(first.length, UINT16_MAX);
+    EXPECT_EQ(out.size(), 70000u + 2 * sizeof(wire::Header));
+}